@@ -0,0 +1,23 @@
+#include "AssetBenchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+// Command-line driver for AssetBenchmark, built by CMakeLists.txt on any
+// platform (the Windows app runs the same suite with --bench-assets).
+//
+//   kg5_asset_bench [model.obj] [iterations]
+//
+// Defaults to assets/sponza/sponza.obj. The .mtl next to the model (same
+// name) is used for the MTL and texture stages, so they still run when the
+// OBJ itself is not present.
+int main(int argc, char** argv)
+{
+	const std::string objPath = (argc > 1) ? argv[1] : "assets/sponza/sponza.obj";
+	const int iterations = (argc > 2) ? (std::max)(std::atoi(argv[2]), 1) : 3;
+
+	std::string report;
+	const bool passed = AssetBenchmark::RunAll(objPath, iterations, report);
+	std::fputs(report.c_str(), stdout);
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,880 @@
+#include "AssetBenchmark.h"
+#include "ObjLoader.h"
+#include "TangentBuilder.h"
+#include "TextureDecodePool.h"
+#include "TextureManifest.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <thread>
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static size_t FileBytes(const std::string& path)
+{
+	std::ifstream f(path, std::ios::binary | std::ios::ate);
+	return f.is_open() ? (size_t)f.tellg() : 0;
+}
+
+// Rate per second of 'amount' processed in 'ms'
+static double PerSecond(double amount, double ms)
+{
+	return (ms > 0.0) ? amount * 1000.0 / ms : 0.0;
+}
+
+static bool MeshesEqual(const ObjMesh& a, const ObjMesh& b)
+{
+	if (a.vertices.size() != b.vertices.size() || a.indices.size() != b.indices.size() ||
+		a.subsets.size() != b.subsets.size() || a.materials.size() != b.materials.size())
+		return false;
+	// Bitwise compare: the mapped parser must round every float the same way.
+	if (!a.vertices.empty() &&
+		std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(ObjMesh::Vertex)) != 0)
+		return false;
+	if (!a.indices.empty() &&
+		std::memcmp(a.indices.data(), b.indices.data(), a.indices.size() * sizeof(UINT)) != 0)
+		return false;
+	for (size_t i = 0; i < a.subsets.size(); ++i)
+	{
+		if (a.subsets[i].indexStart != b.subsets[i].indexStart ||
+			a.subsets[i].indexCount != b.subsets[i].indexCount ||
+			a.subsets[i].materialIdx != b.subsets[i].materialIdx)
+			return false;
+	}
+	for (size_t i = 0; i < a.materials.size(); ++i)
+	{
+		if (a.materials[i].name != b.materials[i].name)
+			return false;
+	}
+	return true;
+}
+
+bool AssetBenchmark::RunObjLoad(const std::string& objPath, int iterations, ObjLoadResult& out,
+	unsigned threadCount)
+{
+	out = ObjLoadResult{};
+	{
+		std::ifstream f(objPath, std::ios::binary | std::ios::ate);
+		if (!f.is_open()) return false;
+		out.fileBytes = (size_t)f.tellg();
+	}
+	if (iterations < 1) iterations = 1;
+
+	ObjLoadOptions parallelOptions;
+	parallelOptions.parallel = true;
+	parallelOptions.threadCount = threadCount ? threadCount : std::thread::hardware_concurrency();
+	out.threadCount = parallelOptions.threadCount;
+
+	ObjMesh legacyMesh;
+	ObjMesh mappedMesh;
+	ObjMesh parallelMesh;
+	ObjMesh streamedMesh;
+	out.legacyMs = 1e30;
+	out.mappedMs = 1e30;
+	out.parallelMs = 1e30;
+	out.streamingMs = 1e30;
+	out.firstSubsetMs = 1e30;
+	for (int i = 0; i < iterations; ++i)
+	{
+		legacyMesh = ObjMesh{};
+		auto start = std::chrono::steady_clock::now();
+		if (!ObjLoader::LoadLegacy(objPath, legacyMesh)) return false;
+		const double legacyMs = ElapsedMs(start);
+		if (legacyMs < out.legacyMs) out.legacyMs = legacyMs;
+
+		mappedMesh = ObjMesh{};
+		start = std::chrono::steady_clock::now();
+		if (!ObjLoader::Load(objPath, mappedMesh)) return false;
+		const double mappedMs = ElapsedMs(start);
+		if (mappedMs < out.mappedMs) out.mappedMs = mappedMs;
+
+		parallelMesh = ObjMesh{};
+		start = std::chrono::steady_clock::now();
+		if (!ObjLoader::Load(objPath, parallelMesh, parallelOptions)) return false;
+		const double parallelMs = ElapsedMs(start);
+		if (parallelMs < out.parallelMs) out.parallelMs = parallelMs;
+
+		streamedMesh = ObjMesh{};
+		size_t subsetCount = 0;
+		double firstSubsetMs = -1.0;
+		start = std::chrono::steady_clock::now();
+		const ObjSubsetCallback onSubset = [&](UINT, ObjMesh&, const std::vector<Material>&)
+		{
+			if (subsetCount++ == 0) firstSubsetMs = ElapsedMs(start);
+		};
+		if (!ObjLoader::LoadStreaming(objPath, streamedMesh, onSubset)) return false;
+		const double streamingMs = ElapsedMs(start);
+		if (streamingMs < out.streamingMs) out.streamingMs = streamingMs;
+		if (firstSubsetMs >= 0.0 && firstSubsetMs < out.firstSubsetMs) out.firstSubsetMs = firstSubsetMs;
+		out.streamedSubsets = subsetCount;
+	}
+	if (out.firstSubsetMs > 1e29) out.firstSubsetMs = 0.0;
+
+	out.vertexCount = mappedMesh.vertices.size();
+	out.indexCount = mappedMesh.indices.size();
+	out.subsetCount = mappedMesh.subsets.size();
+	out.legacyMatches = MeshesEqual(legacyMesh, mappedMesh);
+	out.parallelMatches = MeshesEqual(mappedMesh, parallelMesh);
+	out.streamedMatches = MeshesEqual(mappedMesh, streamedMesh) && out.streamedSubsets == streamedMesh.subsets.size();
+	out.outputsMatch = out.legacyMatches && out.parallelMatches && out.streamedMatches;
+	return true;
+}
+
+std::string AssetBenchmark::Format(const ObjLoadResult& r)
+{
+	const double mb = (double)r.fileBytes / (1024.0 * 1024.0);
+	char buf[768];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[AssetBench][OBJ] %.1f MB, vertices=%zu indices=%zu subsets=%zu\n"
+		"[AssetBench][OBJ] legacy: %.1f ms (%.1f MB/s), output %s\n"
+		"[AssetBench][OBJ] mapped: %.1f ms (%.1f MB/s), speedup x%.2f\n"
+		"[AssetBench][OBJ] parallel (%u threads): %.1f ms (%.1f MB/s), speedup x%.2f, output %s\n"
+		"[AssetBench][OBJ] streaming: %.1f ms, first of %zu subsets after %.1f ms, output %s\n",
+		mb,
+		r.vertexCount,
+		r.indexCount,
+		r.subsetCount,
+		r.legacyMs,
+		(r.legacyMs > 0.0) ? mb * 1000.0 / r.legacyMs : 0.0,
+		r.legacyMatches ? "identical to mapped" : "MISMATCH vs mapped",
+		r.mappedMs,
+		(r.mappedMs > 0.0) ? mb * 1000.0 / r.mappedMs : 0.0,
+		(r.mappedMs > 0.0) ? r.legacyMs / r.mappedMs : 0.0,
+		r.threadCount,
+		r.parallelMs,
+		(r.parallelMs > 0.0) ? mb * 1000.0 / r.parallelMs : 0.0,
+		(r.parallelMs > 0.0) ? r.legacyMs / r.parallelMs : 0.0,
+		r.parallelMatches ? "identical to mapped" : "MISMATCH vs mapped",
+		r.streamingMs,
+		r.streamedSubsets,
+		r.firstSubsetMs,
+		r.streamedMatches ? "identical to mapped" : "MISMATCH vs mapped");
+	return buf;
+}
+
+bool AssetBenchmark::RunTangents(const std::string& objPath, int iterations, TangentResult& out,
+	unsigned threadCount)
+{
+	out = TangentResult{};
+	ObjMesh source;
+	if (!ObjLoader::Load(objPath, source)) return false;
+	if (iterations < 1) iterations = 1;
+
+	TangentOptions serialOptions;
+	TangentOptions parallelOptions;
+	parallelOptions.threadCount = threadCount ? threadCount : std::thread::hardware_concurrency();
+	TangentOptions mikkOptions = parallelOptions;
+	mikkOptions.mikkTSpace = true;
+	out.threadCount = parallelOptions.threadCount;
+
+	ObjMesh referenceMesh;
+	ObjMesh serialMesh;
+	ObjMesh parallelMesh;
+	ObjMesh mikkMesh;
+	out.referenceMs = 1e30;
+	out.serialMs = 1e30;
+	out.parallelMs = 1e30;
+	out.mikkMs = 1e30;
+	for (int i = 0; i < iterations; ++i)
+	{
+		referenceMesh = source;
+		auto start = std::chrono::steady_clock::now();
+		TangentBuilder::BuildReference(referenceMesh);
+		out.referenceMs = (std::min)(out.referenceMs, ElapsedMs(start));
+
+		serialMesh = source;
+		start = std::chrono::steady_clock::now();
+		TangentBuilder::Build(serialMesh, serialOptions);
+		out.serialMs = (std::min)(out.serialMs, ElapsedMs(start));
+
+		parallelMesh = source;
+		start = std::chrono::steady_clock::now();
+		TangentBuilder::Build(parallelMesh, parallelOptions);
+		out.parallelMs = (std::min)(out.parallelMs, ElapsedMs(start));
+
+		mikkMesh = source;
+		start = std::chrono::steady_clock::now();
+		TangentBuilder::Build(mikkMesh, mikkOptions);
+		out.mikkMs = (std::min)(out.mikkMs, ElapsedMs(start));
+	}
+
+	out.vertexCount = source.vertices.size();
+	out.triangleCount = source.indices.size() / 3;
+	out.outputsMatch = MeshesEqual(referenceMesh, serialMesh) && MeshesEqual(serialMesh, parallelMesh);
+
+	double angleSum = 0.0;
+	for (size_t v = 0; v < referenceMesh.vertices.size(); ++v)
+	{
+		const XMFLOAT3& a = referenceMesh.vertices[v].Tangent;
+		const XMFLOAT3& b = mikkMesh.vertices[v].Tangent;
+		const float d = (std::max)(-1.f, (std::min)(1.f, a.x * b.x + a.y * b.y + a.z * b.z));
+		const float angle = std::acos(d) * 57.2957795f;
+		out.mikkMaxAngleDeg = (std::max)(out.mikkMaxAngleDeg, angle);
+		angleSum += angle;
+	}
+	if (!referenceMesh.vertices.empty())
+		out.mikkMeanAngleDeg = (float)(angleSum / (double)referenceMesh.vertices.size());
+	return true;
+}
+
+std::string AssetBenchmark::Format(const TangentResult& r)
+{
+	char buf[768];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[AssetBench][Tangents] vertices=%zu triangles=%zu\n"
+		"[AssetBench][Tangents] reference: %.2f ms\n"
+		"[AssetBench][Tangents] serial: %.2f ms, speedup x%.2f\n"
+		"[AssetBench][Tangents] parallel (%u threads): %.2f ms, speedup x%.2f, output %s\n"
+		"[AssetBench][Tangents] mikktspace: %.2f ms, vs reference max %.1f deg, mean %.2f deg\n",
+		r.vertexCount,
+		r.triangleCount,
+		r.referenceMs,
+		r.serialMs,
+		(r.serialMs > 0.0) ? r.referenceMs / r.serialMs : 0.0,
+		r.threadCount,
+		r.parallelMs,
+		(r.parallelMs > 0.0) ? r.referenceMs / r.parallelMs : 0.0,
+		r.outputsMatch ? "identical" : "MISMATCH",
+		r.mikkMs,
+		r.mikkMaxAngleDeg,
+		r.mikkMeanAngleDeg);
+	return buf;
+}
+
+bool AssetBenchmark::RunObjStages(const std::string& objPath, int iterations, ObjStageResult& out,
+	unsigned threadCount)
+{
+	out = ObjStageResult{};
+	out.fileBytes = FileBytes(objPath);
+	if (out.fileBytes == 0) return false;
+	if (iterations < 1) iterations = 1;
+
+	ObjLoadTimings timings;
+	ObjLoadOptions options;
+	options.parallel = true;
+	options.threadCount = (std::max)(threadCount ? threadCount : std::thread::hardware_concurrency(), 2u);
+	options.timings = &timings;
+	out.threadCount = options.threadCount;
+
+	out.parseMs = 1e30;
+	out.weldMs = 1e30;
+	out.tangentMs = 1e30;
+	for (int i = 0; i < iterations; ++i)
+	{
+		ObjMesh mesh;
+		if (!ObjLoader::Load(objPath, mesh, options)) return false;
+		out.parseMs = (std::min)(out.parseMs, timings.parseMs);
+		out.weldMs = (std::min)(out.weldMs, timings.weldMs);
+		out.tangentMs = (std::min)(out.tangentMs, timings.finishMs);
+		out.triangleCount = mesh.indices.size() / 3;
+		out.cornerCount = mesh.indices.size();
+		out.vertexCount = mesh.vertices.size();
+	}
+	return true;
+}
+
+std::string AssetBenchmark::Format(const ObjStageResult& r)
+{
+	const double mb = (double)r.fileBytes / (1024.0 * 1024.0);
+	const double tris = (double)r.triangleCount;
+	char weld[128];
+	if (r.weldMs > 0.0)
+	{
+		std::snprintf(weld, sizeof(weld), "%.1f ms (%.2f Mtri/s, %.2f Mcorner/s)",
+			r.weldMs, PerSecond(tris, r.weldMs) / 1e6, PerSecond((double)r.cornerCount, r.weldMs) / 1e6);
+	}
+	else
+	{
+		// Too small to split: the serial parser welds as it reads
+		std::snprintf(weld, sizeof(weld), "included in parse");
+	}
+	char buf[768];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[AssetBench][Stages] %.1f MB, triangles=%zu corners=%zu vertices=%zu, %u threads\n"
+		"[AssetBench][Stages] OBJ parse: %.1f ms (%.1f MB/s, %.2f Mtri/s)\n"
+		"[AssetBench][Stages] weld: %s\n"
+		"[AssetBench][Stages] tangents + bounds: %.1f ms (%.2f Mtri/s)\n",
+		mb,
+		r.triangleCount,
+		r.cornerCount,
+		r.vertexCount,
+		r.threadCount,
+		r.parseMs,
+		PerSecond(mb, r.parseMs),
+		PerSecond(tris, r.parseMs) / 1e6,
+		weld,
+		r.tangentMs,
+		PerSecond(tris, r.tangentMs) / 1e6);
+	return buf;
+}
+
+bool AssetBenchmark::RunMtl(const std::vector<std::string>& mtlPaths, int iterations, MtlResult& out)
+{
+	out = MtlResult{};
+	if (mtlPaths.empty()) return false;
+	if (iterations < 1) iterations = 1;
+	for (const std::string& path : mtlPaths)
+		out.fileBytes += FileBytes(path);
+
+	out.ms = 1e30;
+	for (int i = 0; i < iterations; ++i)
+	{
+		std::vector<Material> materials;
+		const auto start = std::chrono::steady_clock::now();
+		for (const std::string& path : mtlPaths)
+		{
+			if (!ObjLoader::LoadMtl(path, materials)) return false;
+		}
+		out.ms = (std::min)(out.ms, ElapsedMs(start));
+		out.materialCount = materials.size();
+	}
+	return true;
+}
+
+std::string AssetBenchmark::Format(const MtlResult& r)
+{
+	const double mb = (double)r.fileBytes / (1024.0 * 1024.0);
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[AssetBench][MTL] %.1f KB, materials=%zu: %.3f ms (%.1f MB/s, %.0f materials/s)\n",
+		(double)r.fileBytes / 1024.0,
+		r.materialCount,
+		r.ms,
+		PerSecond(mb, r.ms),
+		PerSecond((double)r.materialCount, r.ms));
+	return buf;
+}
+
+static bool LooksLikeNormalMap(std::string name)
+{
+	std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return name.find("_ddn") != std::string::npos || name.find("_nrm") != std::string::npos ||
+		name.find("normal") != std::string::npos;
+}
+
+// The renderer's choice per slot, keyed by the slot's mip filter
+static TextureCompression CompressionFor(TextureMipFilter filter)
+{
+	switch (filter)
+	{
+	case TextureMipFilter::Srgb: return TextureCompression::Color;
+	case TextureMipFilter::NormalMap: return TextureCompression::NormalMap;
+	default: return TextureCompression::Height;
+	}
+}
+
+bool AssetBenchmark::RunTextureDecode(const std::vector<std::string>& mtlPaths, int iterations,
+	TextureDecodeResult& out)
+{
+	out = TextureDecodeResult{};
+	if (iterations < 1) iterations = 1;
+
+	// Distinct files, in a stable order, with the mip filter of their first use
+	std::map<std::string, TextureMipFilter> paths;
+	for (const std::string& mtlPath : mtlPaths)
+	{
+		std::vector<Material> materials;
+		if (!ObjLoader::LoadMtl(mtlPath, materials)) return false;
+		const size_t slash = mtlPath.find_last_of("/\\");
+		const std::string dir = (slash == std::string::npos) ? std::string() : mtlPath.substr(0, slash + 1);
+		for (const Material& m : materials)
+		{
+			if (!m.diffuseTexture.empty())
+				paths.emplace(dir + m.diffuseTexture, TextureMipFilter::Srgb);
+			if (!m.normalTexture.empty())
+				paths.emplace(dir + m.normalTexture, TextureMipFilter::NormalMap);
+			// Sponza lists its _ddn normal maps as map_Disp; the renderer treats them as normals
+			if (!m.displacementTexture.empty())
+				paths.emplace(dir + m.displacementTexture,
+					LooksLikeNormalMap(m.displacementTexture) ? TextureMipFilter::NormalMap : TextureMipFilter::Linear);
+		}
+	}
+
+	out.ms = 1e30;
+	out.mipMs = 1e30;
+	for (int i = 0; i < iterations; ++i)
+	{
+		size_t decoded = 0, missing = 0, bytes = 0, pixels = 0;
+		double ms = 0.0;
+		TextureMipmapper::Stats mips;
+		TextureCompressor::Stats compression;
+		for (const auto& entry : paths)
+		{
+			const std::string& path = entry.first;
+			TextureImage image;
+			const auto start = std::chrono::steady_clock::now();
+			const bool loaded = TextureDecoder::LoadFromFile(path, image, true);
+			if (!loaded)
+			{
+				++missing;
+				continue;
+			}
+			ms += ElapsedMs(start);
+			TextureMipmapper::Generate(image, entry.second, &mips);
+			TextureCompressor::Compress(image, CompressionFor(entry.second), TextureCompressOptions(), &compression);
+			++decoded;
+			bytes += FileBytes(path);
+			pixels += (size_t)image.width * image.height;
+		}
+		out.ms = (std::min)(out.ms, ms);
+		out.fileCount = decoded;
+		out.missingCount = missing;
+		out.fileBytes = bytes;
+		out.pixelCount = pixels;
+		out.mipMs = (std::min)(out.mipMs, mips.milliseconds);
+		out.mipBytes = mips.bytesAdded;
+		out.compression = compression;
+	}
+
+	auto makeJobs = [&](bool useCache)
+	{
+		std::vector<TextureDecodeJob> jobs(paths.size());
+		size_t j = 0;
+		for (const auto& entry : paths)
+		{
+			jobs[j].candidates.push_back(entry.first);
+			jobs[j].generateMips = true;
+			jobs[j].compression = CompressionFor(entry.second);
+			jobs[j].useCache = useCache;
+			jobs[j++].mipFilter = entry.second;
+		}
+		return jobs;
+	};
+	out.poolMs = 1e30;
+	for (int i = 0; i < iterations; ++i)
+	{
+		std::vector<TextureDecodeJob> jobs = makeJobs(false);
+		const TextureDecodePool::Stats stats = TextureDecodePool::Decode(jobs);
+		out.poolMs = (std::min)(out.poolMs, stats.milliseconds);
+		out.poolThreads = stats.threadCount;
+	}
+
+	// Cook whatever is missing or stale, then time the warm load
+	{
+		std::vector<TextureDecodeJob> jobs = makeJobs(true);
+		TextureDecodePool::Decode(jobs);
+	}
+	out.cookedMs = 1e30;
+	for (int i = 0; i < iterations; ++i)
+	{
+		std::vector<TextureDecodeJob> jobs = makeJobs(true);
+		const TextureDecodePool::Stats stats = TextureDecodePool::Decode(jobs);
+		out.cookedMs = (std::min)(out.cookedMs, stats.milliseconds);
+		out.cookedCount = stats.cacheHits;
+		out.cookedBytes = 0;
+		for (const TextureDecodeJob& job : jobs)
+			out.cookedBytes += job.cooked ? job.cooked->DataSize() : 0;
+	}
+
+	// What a single-level upload writes to staging memory
+	out.stagedMs = 1e30;
+	out.directMs = 1e30;
+	std::vector<uint8_t> staging;
+	for (int i = 0; i < iterations; ++i)
+	{
+		double stagedMs = 0.0, directMs = 0.0;
+		for (const auto& entry : paths)
+		{
+			UINT width, height;
+			if (!TextureDecoder::ReadInfo(entry.first, width, height))
+				continue;
+			const UINT pitch = (width * 4 + 255) & ~255u;
+			staging.resize((size_t)pitch * height);
+
+			auto start = std::chrono::steady_clock::now();
+			TextureImage image;
+			if (TextureDecoder::LoadFromFile(entry.first, image))
+			{
+				for (UINT y = 0; y < height; ++y)
+					std::memcpy(staging.data() + (size_t)y * pitch, image.pixels.data() + (size_t)y * image.rowPitch, image.rowPitch);
+			}
+			stagedMs += ElapsedMs(start);
+
+			start = std::chrono::steady_clock::now();
+			TextureDecoder::LoadInto(entry.first, staging.data(), pitch, width, height);
+			directMs += ElapsedMs(start);
+		}
+		out.stagedMs = (std::min)(out.stagedMs, stagedMs);
+		out.directMs = (std::min)(out.directMs, directMs);
+	}
+	return out.fileCount > 0;
+}
+
+std::string AssetBenchmark::Format(const TextureDecodeResult& r)
+{
+	const double mb = (double)r.fileBytes / (1024.0 * 1024.0);
+	char buf[512];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[AssetBench][Decode] %zu files (%zu missing), %.1f MB, %.1f Mpixel: %.1f ms (%.1f MB/s, %.1f Mpixel/s), "
+		"mips %.1f ms (+%.1f MB), pool of %u threads with mips and BCn %.1f ms (%.2fx), "
+		"%zu cooked (%.1f MB) %.1f ms, to staging %.1f ms decoded and copied / %.1f ms direct\n",
+		r.fileCount,
+		r.missingCount,
+		mb,
+		(double)r.pixelCount / 1e6,
+		r.ms,
+		PerSecond(mb, r.ms),
+		PerSecond((double)r.pixelCount, r.ms) / 1e6,
+		r.mipMs,
+		(double)r.mipBytes / (1024.0 * 1024.0),
+		r.poolThreads,
+		r.poolMs,
+		(r.poolMs > 0.0) ? (r.ms + r.mipMs + r.compression.milliseconds) / r.poolMs : 0.0,
+		r.cookedCount,
+		(double)r.cookedBytes / (1024.0 * 1024.0),
+		r.cookedMs,
+		r.stagedMs,
+		r.directMs);
+	return buf + TextureCompressor::Format(r.compression);
+}
+
+// The renderer's three texture slots per material, with its settings and
+// candidate guesses (Renderer::LoadObj)
+static bool BuildSlotJobs(const std::vector<std::string>& mtlPaths, std::vector<TextureDecodeJob>& jobs)
+{
+	jobs.clear();
+	for (const std::string& mtlPath : mtlPaths)
+	{
+		std::vector<Material> materials;
+		if (!ObjLoader::LoadMtl(mtlPath, materials)) return false;
+		const size_t slash = mtlPath.find_last_of("/\\");
+		const std::string dir = (slash == std::string::npos) ? std::string() : mtlPath.substr(0, slash + 1);
+		for (const Material& m : materials)
+		{
+			TextureDecodeJob diffuse, normal, displacement;
+			diffuse.generateMips = normal.generateMips = true;
+			diffuse.compression = TextureCompression::Color;
+			normal.mipFilter = TextureMipFilter::NormalMap;
+			normal.compression = TextureCompression::NormalMap;
+			displacement.compression = TextureCompression::Height;
+			if (!m.diffuseTexture.empty())
+				diffuse.candidates.push_back(dir + m.diffuseTexture);
+			if (!m.normalTexture.empty())
+				normal.candidates.push_back(dir + m.normalTexture);
+			if (!m.displacementTexture.empty() && !LooksLikeNormalMap(m.displacementTexture))
+				displacement.candidates.push_back(dir + m.displacementTexture);
+			const size_t dot = m.diffuseTexture.find_last_of('.');
+			if (!m.diffuseTexture.empty() && dot != std::string::npos)
+			{
+				const std::string stem = m.diffuseTexture.substr(0, dot);
+				const std::string ext = m.diffuseTexture.substr(dot);
+				auto replaced = [&](const char* from, const char* to)
+				{
+					const size_t at = stem.find(from);
+					return (at == std::string::npos) ? std::string() : std::string(stem).replace(at, std::strlen(from), to);
+				};
+				auto push = [&](TextureDecodeJob& job, const std::string& guess)
+				{
+					if (!guess.empty())
+						job.candidates.push_back(dir + guess + ext);
+				};
+				push(normal, stem + "_ddn");
+				push(normal, replaced("_diff", "_ddn"));
+				push(normal, replaced("_dif", "_ddn"));
+				push(displacement, replaced("_diff", "_disp"));
+				push(displacement, replaced("_dif", "_disp"));
+				push(displacement, stem + "_disp");
+				push(displacement, stem + "_displacement");
+				push(displacement, stem + "_height");
+			}
+			jobs.push_back(std::move(diffuse));
+			jobs.push_back(std::move(normal));
+			jobs.push_back(std::move(displacement));
+		}
+	}
+	return true;
+}
+
+bool AssetBenchmark::RunTextureShare(const std::vector<std::string>& mtlPaths, TextureRegistry::Stats& out)
+{
+	std::vector<TextureDecodeJob> jobs;
+	if (!BuildSlotJobs(mtlPaths, jobs)) return false;
+	TextureShareOptions options;
+	options.compareContents = true;
+	out = TextureRegistry::Share(jobs, options);
+	TextureDecodePool::Decode(jobs);
+	TextureRegistry::AddSavings(jobs, out);
+	return out.resolvedCount > 0;
+}
+
+bool AssetBenchmark::RunTextureResolve(const std::string& objPath, const std::vector<std::string>& mtlPaths,
+	TextureResolveResult& out)
+{
+	out = TextureResolveResult{};
+	std::vector<TextureDecodeJob> jobs;
+	if (!BuildSlotJobs(mtlPaths, jobs)) return false;
+
+	// What the pool did before: open candidates in order until one exists
+	auto start = std::chrono::steady_clock::now();
+	for (const TextureDecodeJob& job : jobs)
+	{
+		out.candidateCount += job.candidates.size();
+		for (const std::string& candidate : job.candidates)
+		{
+			std::ifstream f(candidate, std::ios::binary);
+			if (f.is_open())
+				break;
+			++out.missingOpens;
+		}
+	}
+	out.probeMs = ElapsedMs(start);
+
+	// Cold: no manifest, folder listings only; decoding (cooked) fills the manifest
+	std::remove(TextureManifest::PathFor(objPath).c_str());
+	std::vector<TextureDecodeJob> cold;
+	BuildSlotJobs(mtlPaths, cold);
+	for (TextureDecodeJob& job : cold)
+		job.useCache = true;
+	start = std::chrono::steady_clock::now();
+	AssetDirectoryIndex coldIndex;
+	TextureManifest coldManifest;
+	coldManifest.Resolve(objPath, cold, coldIndex);
+	out.indexMs = ElapsedMs(start);
+	out.index = coldIndex.GetStats();
+	out.coldResolvedCount = coldManifest.GetStats().resolvedCount;
+	// Shared slots are not decoded; the manifest records them from their owner
+	TextureRegistry::Share(cold);
+	TextureDecodePool::Decode(cold);
+	coldManifest.Write(cold);
+
+	// Warm: the manifest matches
+	std::vector<TextureDecodeJob> warm;
+	BuildSlotJobs(mtlPaths, warm);
+	start = std::chrono::steady_clock::now();
+	AssetDirectoryIndex warmIndex;
+	TextureManifest warmManifest;
+	warmManifest.Resolve(objPath, warm, warmIndex);
+	out.manifestMs = ElapsedMs(start);
+	out.manifest = warmManifest.GetStats();
+	return true;
+}
+
+std::string AssetBenchmark::Format(const TextureResolveResult& r)
+{
+	char buf[384];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[AssetBench][Resolve] %zu slots, %zu candidates: probing %.2f ms (%zu missing opens), "
+		"folder index %.2f ms (%zu folders, %zu lookups), manifest %s %.2f ms (%zu / %zu slots resolved)\n",
+		r.manifest.jobCount,
+		r.candidateCount,
+		r.probeMs,
+		r.missingOpens,
+		r.indexMs,
+		r.index.directoriesListed,
+		r.index.lookups,
+		r.manifest.loaded ? "hit" : "miss",
+		r.manifestMs,
+		r.manifest.resolvedCount,
+		r.coldResolvedCount);
+	return buf;
+}
+
+bool AssetBenchmark::RunWeld(const std::string& objPath, VertexWelder::Stats& out)
+{
+	ObjMesh mesh;
+	if (!ObjLoader::Load(objPath, mesh)) return false;
+	out = VertexWelder::Weld(mesh);
+	return true;
+}
+
+bool AssetBenchmark::RunSubsetMerge(const std::string& objPath, SubsetPartitioner::Stats& out)
+{
+	ObjMesh mesh;
+	if (!ObjLoader::Load(objPath, mesh)) return false;
+	out = SubsetPartitioner::MergeByMaterial(mesh);
+	return true;
+}
+
+bool AssetBenchmark::RunSubsetSplit(const std::string& objPath, SubsetPartitioner::Stats& out)
+{
+	ObjMesh mesh;
+	if (!ObjLoader::Load(objPath, mesh)) return false;
+	SubsetPartitioner::MergeByMaterial(mesh);
+	out = SubsetPartitioner::SplitOversized(mesh);
+	return true;
+}
+
+bool AssetBenchmark::RunMeshOptimize(const std::string& objPath, MeshOptimizer::Stats& out)
+{
+	ObjMesh mesh;
+	if (!ObjLoader::Load(objPath, mesh)) return false;
+	out = MeshOptimizer::Optimize(mesh);
+	return true;
+}
+
+// Packs the mesh in every VertexFormat and checks the decoded vertices
+static bool PackAndMeasure(const ObjMesh& mesh, std::string& report)
+{
+	bool passed = true;
+	const VertexFormat formats[] = { VertexFormat::Packed, VertexFormat::PackedQuantized };
+	for (VertexFormat format : formats)
+	{
+		PackedVertexData packed;
+		if (!VertexPacking::Pack(mesh.vertices.data(), mesh.vertices.size(), mesh.subsets, format, packed))
+			return false;
+		const VertexPacking::Accuracy accuracy =
+			VertexPacking::Measure(mesh.vertices.data(), mesh.vertices.size(), mesh.subsets, packed);
+		report += VertexPacking::Format(accuracy, packed);
+		passed = passed && accuracy.Passes();
+	}
+	return passed;
+}
+
+bool AssetBenchmark::RunVertexPacking(const std::string& objPath, std::string& report)
+{
+	ObjMesh mesh;
+	if (!ObjLoader::Load(objPath, mesh)) return false;
+	MeshOptimizer::Optimize(mesh);
+
+	const bool passed = PackAndMeasure(mesh, report);
+
+	PackedIndexData indices;
+	VertexPacking::PackIndices(mesh.indices.data(), mesh.indices.size(), mesh.subsets, mesh.lods, indices);
+	report += VertexPacking::FormatIndices(indices);
+	return passed;
+}
+
+bool AssetBenchmark::RunVertexPackingSynthetic(std::string& report)
+{
+	// UV sphere, far from the origin, with u mirrored on the western half
+	// (opposite handedness) and uv running up to 64 to stress the halves
+	const UINT rings = 48, segments = 96;
+	const float radius = 25.f;
+	const XMFLOAT3 center(1000.f, -40.f, 300.f);
+	ObjMesh mesh;
+	for (UINT r = 0; r <= rings; ++r)
+	{
+		const float theta = 3.14159265f * (float)r / (float)rings;
+		for (UINT s = 0; s <= segments; ++s)
+		{
+			const float phi = 6.28318531f * (float)s / (float)segments;
+			const XMFLOAT3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			ObjMesh::Vertex v{};
+			v.Position = XMFLOAT3(center.x + n.x * radius, center.y + n.y * radius, center.z + n.z * radius);
+			v.Normal = n;
+			const float u = 64.f * (float)s / (float)segments;
+			v.TexCoord = XMFLOAT2((s <= segments / 2) ? u : 64.f - u, 8.f * (float)r / (float)rings);
+			mesh.vertices.push_back(v);
+		}
+	}
+	for (UINT r = 0; r < rings; ++r)
+	{
+		for (UINT s = 0; s < segments; ++s)
+		{
+			const UINT i0 = r * (segments + 1) + s, i1 = i0 + 1, i2 = i0 + segments + 1, i3 = i2 + 1;
+			const UINT quad[6] = { i0, i2, i1, i1, i2, i3 };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+	MeshSubset subset;
+	subset.indexCount = (UINT)mesh.indices.size();
+	subset.materialIdx = 0;
+	subset.vertexCount = (UINT)mesh.vertices.size();
+	mesh.subsets.push_back(subset);
+	TangentBuilder::Build(mesh);
+
+	report += "[AssetBench][VertexPack] generated sphere\n";
+	return PackAndMeasure(mesh, report);
+}
+
+bool AssetBenchmark::RunAll(const std::string& objPath, int iterations, std::string& report)
+{
+	if (iterations < 1) iterations = 1;
+	std::vector<std::string> mtlPaths;
+	const size_t dot = objPath.find_last_of('.');
+	mtlPaths.push_back(objPath.substr(0, dot) + ".mtl");
+
+	bool passed = true;
+	bool ranAny = false;
+
+	ObjLoadResult load;
+	if (RunObjLoad(objPath, iterations, load))
+	{
+		ranAny = true;
+		report += Format(load);
+		passed = passed && load.outputsMatch;
+
+		ObjMesh mesh;
+		if (ObjLoader::Load(objPath, mesh) && !mesh.materialLibraries.empty())
+			mtlPaths = mesh.materialLibraries;
+
+		ObjStageResult stages;
+		if (RunObjStages(objPath, iterations, stages))
+			report += Format(stages);
+		TangentResult tangents;
+		const bool tangentsLoaded = RunTangents(objPath, iterations, tangents);
+		if (tangentsLoaded)
+			report += Format(tangents);
+		passed = passed && tangentsLoaded && tangents.outputsMatch;
+		VertexWelder::Stats weldStats;
+		if (RunWeld(objPath, weldStats))
+			report += VertexWelder::Format(weldStats);
+		SubsetPartitioner::Stats mergeStats;
+		if (RunSubsetMerge(objPath, mergeStats))
+			report += SubsetPartitioner::Format(mergeStats);
+		SubsetPartitioner::Stats splitStats;
+		if (RunSubsetSplit(objPath, splitStats))
+			report += SubsetPartitioner::FormatSplit(splitStats);
+		MeshOptimizer::Stats optStats;
+		if (RunMeshOptimize(objPath, optStats))
+			report += MeshOptimizer::Format(optStats);
+		passed = RunVertexPacking(objPath, report) && passed;
+	}
+	else if (!std::ifstream(objPath, std::ios::binary).is_open())
+	{
+		report += "[AssetBench][OBJ] " + objPath + " not found, mesh stages skipped\n";
+	}
+	else
+	{
+		report += "[AssetBench][OBJ] " + objPath + " failed to load, mesh stages skipped\n";
+		passed = false;
+	}
+	passed = RunVertexPackingSynthetic(report) && passed;
+
+	MtlResult mtl;
+	if (RunMtl(mtlPaths, iterations, mtl))
+	{
+		ranAny = true;
+		report += Format(mtl);
+	}
+	else
+	{
+		report += "[AssetBench][MTL] " + mtlPaths.front() + " not found\n";
+	}
+
+	// Decoding every texture is slow; one pass is enough for a stable number.
+	TextureDecodeResult decode;
+	if (RunTextureDecode(mtlPaths, 1, decode))
+	{
+		ranAny = true;
+		report += Format(decode);
+	}
+	TextureRegistry::Stats share;
+	if (RunTextureShare(mtlPaths, share))
+		report += TextureRegistry::Format(share);
+	TextureResolveResult resolve;
+	if (RunTextureResolve(objPath, mtlPaths, resolve))
+		report += Format(resolve);
+
+	return ranAny && passed;
+}
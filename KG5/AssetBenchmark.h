@@ -0,0 +1,160 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "TextureCompressor.h"
+#include "TextureManifest.h"
+#include "TextureRegistry.h"
+#include "SubsetPartitioner.h"
+#include "VertexPacking.h"
+#include "VertexWelder.h"
+// CPU-side asset loading benchmarks. Results are plain numbers so they can be
+// logged from the app (--bench-assets) or any other harness.
+class AssetBenchmark
+{
+public:
+	struct ObjLoadResult
+	{
+		size_t fileBytes = 0;
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+		size_t subsetCount = 0;
+		double legacyMs = 0.0;  // best of N, ObjLoader::LoadLegacy
+		double mappedMs = 0.0;  // best of N, ObjLoader::Load
+		double parallelMs = 0.0; // best of N, ObjLoader::Load with options.parallel
+		double streamingMs = 0.0; // best of N, ObjLoader::LoadStreaming
+		double firstSubsetMs = 0.0; // best of N, LoadStreaming start -> first subset callback
+		size_t streamedSubsets = 0;
+		unsigned threadCount = 0;
+		// Each of the other meshes against the mapped one, bit for bit
+		bool legacyMatches = false;
+		bool parallelMatches = false;
+		bool streamedMatches = false; // also: one callback per streamed subset
+		bool outputsMatch = false; // all three of the above
+	};
+	// threadCount = 0 uses every hardware thread for the parallel run.
+	static bool RunObjLoad(const std::string& objPath, int iterations, ObjLoadResult& out,
+		unsigned threadCount = 0);
+	static std::string Format(const ObjLoadResult& r);
+
+	struct TangentResult
+	{
+		size_t vertexCount = 0;
+		size_t triangleCount = 0;
+		double referenceMs = 0.0; // best of N, TangentBuilder::BuildReference
+		double serialMs = 0.0;    // best of N, TangentBuilder::Build on one thread
+		double parallelMs = 0.0;  // best of N, TangentBuilder::Build on threadCount threads
+		double mikkMs = 0.0;      // best of N, parallel with TangentOptions::mikkTSpace
+		unsigned threadCount = 0;
+		bool outputsMatch = false; // reference, serial and parallel frames are bit-identical
+		float mikkMaxAngleDeg = 0.f;  // MikkTSpace-style tangent vs reference
+		float mikkMeanAngleDeg = 0.f;
+	};
+	// Loads objPath once and rebuilds its tangent frames with every builder.
+	static bool RunTangents(const std::string& objPath, int iterations, TangentResult& out,
+		unsigned threadCount = 0);
+	static std::string Format(const TangentResult& r);
+	struct ObjStageResult
+	{
+		size_t fileBytes = 0;
+		size_t triangleCount = 0;
+		size_t cornerCount = 0; // face corners fed to the welder (indices)
+		size_t vertexCount = 0; // welded vertices
+		double parseMs = 0.0;   // best of N, ObjLoadTimings::parseMs
+		double weldMs = 0.0;    // best of N, ObjLoadTimings::weldMs (0 = folded into parse)
+		double tangentMs = 0.0; // best of N, ObjLoadTimings::finishMs
+		unsigned threadCount = 0;
+	};
+	// Per-stage breakdown of ObjLoader::Load on the chunked parallel path
+	// (at least two chunks, so parse and weld are timed separately).
+	static bool RunObjStages(const std::string& objPath, int iterations, ObjStageResult& out,
+		unsigned threadCount = 0);
+	static std::string Format(const ObjStageResult& r);
+
+	struct MtlResult
+	{
+		size_t fileBytes = 0;
+		size_t materialCount = 0;
+		double ms = 0.0; // best of N, ObjLoader::LoadMtl over every library
+	};
+	static bool RunMtl(const std::vector<std::string>& mtlPaths, int iterations, MtlResult& out);
+	static std::string Format(const MtlResult& r);
+
+	struct TextureDecodeResult
+	{
+		size_t fileCount = 0;   // decoded files
+		size_t missingCount = 0; // referenced but missing or undecodable
+		size_t fileBytes = 0;
+		size_t pixelCount = 0;
+		double ms = 0.0; // best of N, TextureDecoder::LoadFromFile over every file
+		double mipMs = 0.0;  // best of N, TextureMipmapper::Generate over the decoded files
+		size_t mipBytes = 0; // added by the chains
+		TextureCompressor::Stats compression; // last run, BCn on every thread
+		double poolMs = 0.0; // best of N, the same files decoded, mipped and compressed through TextureDecodePool
+		unsigned poolThreads = 0;
+		size_t cookedCount = 0; // files mapped from TextureCache in the warm runs
+		size_t cookedBytes = 0;
+		double cookedMs = 0.0; // best of N, the pool again with every file cooked
+		// Best of N, level 0 into a 256-byte-pitched buffer like a staging
+		// footprint: decoded to an image and copied, then TextureDecoder::LoadInto
+		double stagedMs = 0.0;
+		double directMs = 0.0;
+	};
+	// Decodes every distinct texture the libraries reference (map_Kd,
+	// map_bump, map_Disp), resolved next to their .mtl like the renderer does,
+	// builds their mip chains (normal-map filter for map_bump) and block-compresses
+	// them like the renderer (BC1/BC3 map_Kd, BC5 map_bump, BC4 map_Disp).
+	// Then cooks them (TextureCache files next to the textures) and times
+	// the warm pool load, and the single-level staging paths.
+	static bool RunTextureDecode(const std::vector<std::string>& mtlPaths, int iterations,
+		TextureDecodeResult& out);
+	static std::string Format(const TextureDecodeResult& r);
+	// Builds the renderer's three texture slots per material (map_Kd;
+	// map_bump, then <diffuse>_ddn and _diff -> _ddn; map_Disp unless it is
+	// a normal map) with its settings, shares them through TextureRegistry
+	// (content hashing on) and decodes the remaining jobs without the cache
+	// to measure the savings.
+	static bool RunTextureShare(const std::vector<std::string>& mtlPaths, TextureRegistry::Stats& out);
+
+	struct TextureResolveResult
+	{
+		size_t candidateCount = 0;
+		size_t missingOpens = 0;
+		double probeMs = 0.0;    // opening candidates until one exists
+		double indexMs = 0.0;    // TextureManifest::Resolve without a manifest
+		double manifestMs = 0.0; // the same with the manifest just written
+		AssetDirectoryIndex::Stats index; // of the cold resolve
+		TextureManifest::Stats manifest;  // of the warm resolve
+		size_t coldResolvedCount = 0;     // the warm resolve should match it
+	};
+	// The same slots, resolved three ways; the cold run shares and decodes
+	// them like the renderer. Writes the manifest for objPath
+	// (the OBJ itself need not exist) and cooks the textures it finds.
+	static bool RunTextureResolve(const std::string& objPath, const std::vector<std::string>& mtlPaths,
+		TextureResolveResult& out);
+	static std::string Format(const TextureResolveResult& r);
+
+	// Loads objPath and runs VertexWelder::Weld with default options.
+	static bool RunWeld(const std::string& objPath, VertexWelder::Stats& out);
+	// Loads objPath and runs SubsetPartitioner::MergeByMaterial (draw count before/after).
+	static bool RunSubsetMerge(const std::string& objPath, SubsetPartitioner::Stats& out);
+	// Loads objPath, merges by material and runs SubsetPartitioner::SplitOversized
+	// with default options.
+	static bool RunSubsetSplit(const std::string& objPath, SubsetPartitioner::Stats& out);
+	// Loads objPath and runs MeshOptimizer::Optimize (ACMR before/after).
+	static bool RunMeshOptimize(const std::string& objPath, MeshOptimizer::Stats& out);
+	// Packs the optimized mesh in every VertexFormat, decodes it again and
+	// appends VertexPacking::Format lines to 'report'. False if any fails.
+	static bool RunVertexPacking(const std::string& objPath, std::string& report);
+	// The same checks on a generated mesh with mirrored UVs, so the packing
+	// is verified without any assets.
+	static bool RunVertexPackingSynthetic(std::string& report);
+
+	// Every stage above on objPath and the .mtl libraries it references (the
+	// .mtl of the same name when the OBJ is missing), as kg5_asset_bench and
+	// the app's --bench-assets run them. Texture decoding runs once, the
+	// other timed stages 'iterations' times. Appends one line per stage to
+	// 'report'; false when a stage that checks its output fails or nothing loads.
+	static bool RunAll(const std::string& objPath, int iterations, std::string& report);
+};
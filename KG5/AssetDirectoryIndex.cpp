@@ -0,0 +1,105 @@
+#include "AssetDirectoryIndex.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::string FoldCase(std::string s)
+{
+#ifdef _WIN32
+	std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+	return s;
+}
+
+std::string AssetDirectoryIndex::Key(const std::string& path)
+{
+	std::error_code ec;
+	fs::path p = fs::absolute(fs::path(path), ec);
+	if (ec) p = fs::path(path);
+	std::string key = FoldCase(p.lexically_normal().generic_string());
+	while (key.size() > 1 && key.back() == '/')
+		key.pop_back();
+	return key;
+}
+
+AssetDirectoryIndex::FileSet& AssetDirectoryIndex::List(const std::string& dirKey, const std::string& dir)
+{
+	auto found = m_dirs.find(dirKey);
+	if (found != m_dirs.end())
+		return found->second;
+
+	const auto start = std::chrono::steady_clock::now();
+	FileSet& files = m_dirs[dirKey];
+	std::error_code ec;
+	fs::directory_iterator it(dir, ec);
+	if (ec)
+	{
+		++m_stats.missingDirectories;
+	}
+	else
+	{
+		++m_stats.directoriesListed;
+		for (; it != fs::directory_iterator(); it.increment(ec))
+		{
+			if (ec) break;
+			std::error_code typeEc;
+			const std::string name = FoldCase(it->path().filename().string());
+			if (it->is_regular_file(typeEc) && name.find(".kg5") == std::string::npos)
+				files.insert(name);
+		}
+		m_stats.filesIndexed += files.size();
+	}
+	m_stats.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return files;
+}
+
+bool AssetDirectoryIndex::Exists(const std::string& path)
+{
+	++m_stats.lookups;
+	const std::string key = Key(path);
+	const size_t slash = key.find_last_of('/');
+	if (slash == std::string::npos || slash + 1 == key.size())
+		return false;
+	const std::string dirKey = (slash == 0) ? key.substr(0, 1) : key.substr(0, slash);
+	const std::string dir = fs::path(path).parent_path().string();
+	const FileSet& files = List(dirKey, dir.empty() ? std::string(".") : dir);
+	const bool hit = files.count(key.substr(slash + 1)) != 0;
+	m_stats.hits += hit ? 1 : 0;
+	return hit;
+}
+
+uint64_t AssetDirectoryIndex::FolderStamp(const std::string& dir)
+{
+	std::error_code ec;
+	if (!fs::is_directory(dir, ec))
+		return 0;
+	const FileSet& files = List(Key(dir), dir);
+	std::vector<std::string> names(files.begin(), files.end());
+	std::sort(names.begin(), names.end());
+	uint64_t hash = HashBytes64(nullptr, 0, names.size());
+	for (const std::string& name : names)
+		hash = HashBytes64(name.data(), name.size() + 1, hash);
+	return hash;
+}
+
+std::string AssetDirectoryIndex::Format(const Stats& s)
+{
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[AssetIndex] %zu folders listed (%zu missing), %zu files: %zu lookups, %zu hits, %.2f ms listing\n",
+		s.directoriesListed,
+		s.missingDirectories,
+		s.filesIndexed,
+		s.lookups,
+		s.hits,
+		s.milliseconds);
+	return buf;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+// In-memory listing of asset folders. The renderer guesses texture names
+// (_ddn, _disp, _height, absolute fallbacks); asking the index instead of the
+// file system means a guess that does not exist costs a hash lookup, not a
+// failed open. Each directory is listed once, on first use; a directory
+// that does not exist is remembered as empty. Names compare case-insensitively on Windows, like the file system.
+// Files the engine writes next to assets (*.kg5mesh, *.kg5tex, ...) are not
+// indexed.
+class AssetDirectoryIndex
+{
+public:
+	struct Stats
+	{
+		size_t directoriesListed = 0;
+		size_t missingDirectories = 0;
+		size_t filesIndexed = 0;
+		size_t lookups = 0;
+		size_t hits = 0;
+		double milliseconds = 0.0; // spent listing
+	};
+
+	// True when 'path' names an existing regular file
+	bool Exists(const std::string& path);
+	// Hash of the folder's file names (0 = missing); changes when files are
+	// added, removed or renamed
+	uint64_t FolderStamp(const std::string& dir);
+
+	// Absolute, lexically normal, '/'-separated and case-folded on Windows
+	static std::string Key(const std::string& path);
+	const Stats& GetStats() const { return m_stats; }
+	static std::string Format(const Stats& s);
+private:
+	using FileSet = std::unordered_set<std::string>;
+	// Key of a directory -> key-form file names in it
+	FileSet& List(const std::string& dirKey, const std::string& dir);
+
+	std::unordered_map<std::string, FileSet> m_dirs;
+	Stats m_stats;
+};
@@ -0,0 +1,12 @@
+#pragma once
+// Basic types for the CPU asset code (OBJ/MTL parsing, mesh processing,
+// image decoding). None of it needs <Windows.h>: UINT is declared exactly
+// as minwindef.h does, and off Windows DirectXMathCompat.h stands in for
+// the DirectXMath storage types and the few XMVector helpers in use.
+#ifdef _WIN32
+#include <DirectXMath.h>
+#else
+#include "DirectXMathCompat.h"
+#endif
+typedef unsigned int UINT;
+using namespace DirectX;
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+// Fast non-cryptographic 64-bit hash for cache keys (change detection of
+// asset files, not security). Four independent multiply-xorshift lanes over
+// 8-byte words keep the loop throughput-bound rather than latency-bound.
+inline uint64_t HashBytes64(const void* data, size_t size, uint64_t seed = 0)
+{
+	const uint64_t kMul = 0x9E3779B97F4A7C15ull;
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	uint64_t lanes[4] = { seed ^ 0x243F6A8885A308D3ull, seed ^ 0x13198A2E03707344ull,
+		seed ^ 0xA4093822299F31D0ull, seed ^ 0x082EFA98EC4E6C89ull };
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			uint64_t w;
+			std::memcpy(&w, p + i + lane * 8, 8);
+			lanes[lane] = (lanes[lane] ^ w) * kMul;
+			lanes[lane] ^= lanes[lane] >> 29;
+		}
+	}
+	uint64_t h = (uint64_t)size * kMul;
+	for (int lane = 0; lane < 4; ++lane)
+		h = (h ^ lanes[lane]) * kMul + (h >> 31);
+	for (; i < size; ++i)
+		h = (h ^ p[i]) * 0x100000001B3ull;
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	return h;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+// Portable stand-in for the part of DirectXMath used by the asset code, for
+// platforms without the Windows SDK (see AssetTypes.h). Storage types keep
+// the DirectXMath layout so cooked files stay interchangeable; XMVECTOR is
+// a plain float[4] and the helpers are scalar.
+namespace DirectX
+{
+	struct XMFLOAT2
+	{
+		float x, y;
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+		explicit XMFLOAT2(const float* p) : x(p[0]), y(p[1]) {}
+	};
+	struct XMFLOAT3
+	{
+		float x, y, z;
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+		explicit XMFLOAT3(const float* p) : x(p[0]), y(p[1]), z(p[2]) {}
+	};
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+		explicit XMFLOAT4(const float* p) : x(p[0]), y(p[1]), z(p[2]), w(p[3]) {}
+	};
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+		XMFLOAT4X4() = default;
+		constexpr XMFLOAT4X4(
+			float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+			: _11(m00), _12(m01), _13(m02), _14(m03)
+			, _21(m10), _22(m11), _23(m12), _24(m13)
+			, _31(m20), _32(m21), _33(m22), _34(m23)
+			, _41(m30), _42(m31), _43(m32), _44(m33) {}
+		float operator()(size_t row, size_t column) const { return m[row][column]; }
+		float& operator()(size_t row, size_t column) { return m[row][column]; }
+	};
+
+	struct XMVECTOR
+	{
+		float v[4];
+	};
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* p) { return { { p->x, p->y, p->z, 0.f } }; }
+	inline void XMStoreFloat3(XMFLOAT3* p, XMVECTOR v)
+	{
+		p->x = v.v[0];
+		p->y = v.v[1];
+		p->z = v.v[2];
+	}
+	inline float XMVectorGetX(XMVECTOR v) { return v.v[0]; }
+	inline float XMVectorGetY(XMVECTOR v) { return v.v[1]; }
+	inline float XMVectorGetZ(XMVECTOR v) { return v.v[2]; }
+	inline float XMVectorGetW(XMVECTOR v) { return v.v[3]; }
+	inline XMVECTOR XMVectorAdd(XMVECTOR a, XMVECTOR b)
+	{
+		return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+	}
+	inline XMVECTOR XMVectorSubtract(XMVECTOR a, XMVECTOR b)
+	{
+		return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+	}
+	inline XMVECTOR XMVectorMultiply(XMVECTOR a, XMVECTOR b)
+	{
+		return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+	}
+	inline XMVECTOR XMVectorScale(XMVECTOR a, float s)
+	{
+		return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } };
+	}
+	// Results are replicated into every lane, like DirectXMath.
+	inline XMVECTOR XMVector3Dot(XMVECTOR a, XMVECTOR b)
+	{
+		const float d = a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2];
+		return { { d, d, d, d } };
+	}
+	inline XMVECTOR XMVector3LengthSq(XMVECTOR a) { return XMVector3Dot(a, a); }
+	inline XMVECTOR XMVector3Length(XMVECTOR a)
+	{
+		const float l = std::sqrt(XMVector3Dot(a, a).v[0]);
+		return { { l, l, l, l } };
+	}
+	// Zero-length input gives a zero vector, as in DirectXMath.
+	inline XMVECTOR XMVector3Normalize(XMVECTOR a)
+	{
+		const float l = std::sqrt(XMVector3Dot(a, a).v[0]);
+		const float s = (l > 0.f) ? 1.f / l : 0.f;
+		return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } };
+	}
+	inline XMVECTOR XMVector3Cross(XMVECTOR a, XMVECTOR b)
+	{
+		return { {
+			a.v[1] * b.v[2] - a.v[2] * b.v[1],
+			a.v[2] * b.v[0] - a.v[0] * b.v[2],
+			a.v[0] * b.v[1] - a.v[1] * b.v[0],
+			0.f } };
+	}
+}
@@ -1,6 +1,8 @@
 Texture2D gDiffuseMap      : register(t0);
 Texture2D gNormalMap       : register(t1);
 Texture2D gDisplacementMap : register(t2);
+// Rigid placements of instanced subsets; entry 0 is the identity
+StructuredBuffer<float4x4> gInstanceWorld : register(t3);
 SamplerState gSampler : register(s0);
 
 cbuffer ObjectTransformConstants : register(b0)
@@ -8,6 +10,10 @@ cbuffer ObjectTransformConstants : register(b0)
     float4x4 gWorld;
     float4x4 gWorldInvTranspose;
     float4 gColorTint;
+    float4 gPositionScale;
+    float4 gPositionOffset;
+    uint gInstanceBase;
+    uint3 gInstancePad;
 };
 
 cbuffer GeometryFrameConstants : register(b1)
@@ -35,15 +41,44 @@ cbuffer MaterialConstants : register(b2)
     float2 gMaterialPad;
 };
 
+// Packed vertex (see VertexPacking.h): POSITION is float3 or unorm16 relative
+// to the subset AABB, NORMAL is octahedral snorm16, TANGENT is unorm10 xyz
+// with the bitangent sign in w.
 struct VSInput
 {
-    float3 Position  : POSITION;
-    float3 Normal    : NORMAL;
-    float2 TexCoord  : TEXCOORD;
-    float3 Tangent   : TANGENT;
-    float3 Bitangent : BITANGENT;
+    float3 Position   : POSITION;
+    float2 NormalOct  : NORMAL;
+    float2 TexCoord   : TEXCOORD;
+    float4 TangentSgn : TANGENT;
+};
+
+struct DecodedVertex
+{
+    float3 Position;
+    float3 Normal;
+    float3 Tangent;
+    float3 Bitangent;
 };
 
+float3 DecodeOctNormal(float2 e)
+{
+    float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    const float t = saturate(-n.z);
+    n.xy += (n.xy >= 0.0f) ? -t : t;
+    return normalize(n);
+}
+
+DecodedVertex DecodeVertex(VSInput vin)
+{
+    DecodedVertex v;
+    v.Position = vin.Position * gPositionScale.xyz + gPositionOffset.xyz;
+    v.Normal = DecodeOctNormal(vin.NormalOct);
+    v.Tangent = normalize(vin.TangentSgn.xyz * 2.0f - 1.0f);
+    const float bitangentSign = (vin.TangentSgn.w > 0.5f) ? 1.0f : -1.0f;
+    v.Bitangent = cross(v.Normal, v.Tangent) * bitangentSign;
+    return v;
+}
+
 struct VSOutput
 {
     float3 PositionW  : POSITION;
@@ -79,15 +114,28 @@ struct PSOutput
     float4 Material : SV_Target2;
 };
 
-VSOutput VSMain(VSInput vin)
+// Instance transforms are rotation + translation only, so the same 3x3
+// carries normals and tangents before the world matrix is applied.
+DecodedVertex ApplyInstance(DecodedVertex v, uint instanceID)
+{
+    const float4x4 inst = gInstanceWorld[gInstanceBase + instanceID];
+    v.Position = mul(float4(v.Position, 1.0f), inst).xyz;
+    v.Normal = mul(v.Normal, (float3x3)inst);
+    v.Tangent = mul(v.Tangent, (float3x3)inst);
+    v.Bitangent = mul(v.Bitangent, (float3x3)inst);
+    return v;
+}
+
+VSOutput VSMain(VSInput vin, uint instanceID : SV_InstanceID)
 {
     VSOutput vout;
-    float4 posW = mul(float4(vin.Position, 1.0f), gWorld);
+    const DecodedVertex v = ApplyInstance(DecodeVertex(vin), instanceID);
+    float4 posW = mul(float4(v.Position, 1.0f), gWorld);
     vout.PositionW = posW.xyz;
-    vout.NormalW = normalize(mul(vin.Normal, (float3x3)gWorldInvTranspose));
+    vout.NormalW = normalize(mul(v.Normal, (float3x3)gWorldInvTranspose));
     vout.TexCoord = vin.TexCoord;
-    vout.TangentW = normalize(mul(vin.Tangent, (float3x3)gWorld));
-    vout.BitangentW = normalize(mul(vin.Bitangent, (float3x3)gWorld));
+    vout.TangentW = normalize(mul(v.Tangent, (float3x3)gWorld));
+    vout.BitangentW = normalize(mul(v.Bitangent, (float3x3)gWorld));
     vout.ColorTint = gColorTint;
     return vout;
 }
@@ -213,8 +261,9 @@ PSOutput PSMain(DSOutput pin)
         float handedness = (dot(cross(n, t), bRef) < 0.0f) ? -1.0f : 1.0f;
         float3 b = normalize(cross(n, t)) * handedness;
 
-        float3 normalTS = gNormalMap.Sample(gSampler, pin.TexCoord).xyz;
-        normalTS = normalize(normalTS * 2.0f - 1.0f);
+        // z is rebuilt from xy, so two-channel (BC5) normal maps work as well
+        float2 normalXY = gNormalMap.Sample(gSampler, pin.TexCoord).xy * 2.0f - 1.0f;
+        float3 normalTS = float3(normalXY, sqrt(saturate(1.0f - dot(normalXY, normalXY))));
 
         float3x3 tbn = float3x3(t, b, n);
         n = normalize(mul(normalTS, tbn));
@@ -270,16 +319,17 @@ struct VSNoTessOutput
     float3 BitangentW : TEXCOORD4;
 };
 
-VSNoTessOutput VSMainNoTess(VSInput vin)
+VSNoTessOutput VSMainNoTess(VSInput vin, uint instanceID : SV_InstanceID)
 {
     VSNoTessOutput o;
-    float4 posW = mul(float4(vin.Position, 1.0f), gWorld);
+    const DecodedVertex v = ApplyInstance(DecodeVertex(vin), instanceID);
+    float4 posW = mul(float4(v.Position, 1.0f), gWorld);
     o.PositionW = posW.xyz;
     o.PositionH = mul(mul(posW, gView), gProj);
-    o.NormalW = normalize(mul(vin.Normal, (float3x3)gWorldInvTranspose));
+    o.NormalW = normalize(mul(v.Normal, (float3x3)gWorldInvTranspose));
     o.TexCoord = vin.TexCoord;
-    o.TangentW = normalize(mul(vin.Tangent, (float3x3)gWorld));
-    o.BitangentW = normalize(mul(vin.Bitangent, (float3x3)gWorld));
+    o.TangentW = normalize(mul(v.Tangent, (float3x3)gWorld));
+    o.BitangentW = normalize(mul(v.Bitangent, (float3x3)gWorld));
     return o;
 }
 
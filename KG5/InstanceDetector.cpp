@@ -0,0 +1,462 @@
+#include "InstanceDetector.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+static const UINT InvalidIndex = 0xFFFFFFFFu;
+
+// -------------------------------------------------------
+// Connected components
+// -------------------------------------------------------
+static UINT FindRoot(std::vector<UINT>& parent, UINT v)
+{
+	while (parent[v] != v)
+	{
+		parent[v] = parent[parent[v]];
+		v = parent[v];
+	}
+	return v;
+}
+
+static void Unite(std::vector<UINT>& parent, UINT a, UINT b)
+{
+	a = FindRoot(parent, a);
+	b = FindRoot(parent, b);
+	if (a != b)
+		parent[(std::max)(a, b)] = (std::min)(a, b);
+}
+
+struct PositionKey
+{
+	uint32_t x, y, z;
+	bool operator==(const PositionKey& o) const { return x == o.x && y == o.y && z == o.z; }
+	bool operator<(const PositionKey& o) const
+	{
+		return x != o.x ? x < o.x : (y != o.y ? y < o.y : z < o.z);
+	}
+};
+
+static PositionKey KeyOf(const XMFLOAT3& p)
+{
+	PositionKey k;
+	std::memcpy(&k.x, &p.x, 4);
+	std::memcpy(&k.y, &p.y, 4);
+	std::memcpy(&k.z, &p.z, 4);
+	return k;
+}
+
+struct Component
+{
+	std::vector<UINT> triangles; // offsets of the triangles in mesh.indices
+	std::vector<UINT> vertices;  // global ids in first-use order
+	std::vector<UINT> localIndices;
+	uint64_t key = 0;
+	// Reference vertices (local ids) spanning the component's frame
+	UINT refA = 0;
+	UINT refB = 0;
+	UINT refC = 0;
+	float extent = 0.f;
+	bool usable = false;
+};
+
+// -------------------------------------------------------
+// Rigid fit
+// -------------------------------------------------------
+static XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+static float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+// Orthonormal right-handed frame (rows) through three points; false if they are collinear.
+static bool BuildFrame(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c, XMFLOAT3 frame[3])
+{
+	XMFLOAT3 e1 = Sub(b, a);
+	const float len1 = std::sqrt(Dot(e1, e1));
+	if (len1 <= 0.f) return false;
+	e1 = XMFLOAT3(e1.x / len1, e1.y / len1, e1.z / len1);
+	XMFLOAT3 ac = Sub(c, a);
+	const float d = Dot(ac, e1);
+	XMFLOAT3 e2(ac.x - e1.x * d, ac.y - e1.y * d, ac.z - e1.z * d);
+	const float len2 = std::sqrt(Dot(e2, e2));
+	if (len2 <= 1e-6f * len1) return false;
+	e2 = XMFLOAT3(e2.x / len2, e2.y / len2, e2.z / len2);
+	frame[0] = e1;
+	frame[1] = e2;
+	frame[2] = Cross(e1, e2);
+	return true;
+}
+
+static float Axis(const XMFLOAT3& v, int i) { return (i == 0) ? v.x : ((i == 1) ? v.y : v.z); }
+
+// Row-vector rotation: v * R
+static XMFLOAT3 Rotate(const XMFLOAT3& v, const float r[3][3])
+{
+	return XMFLOAT3(
+		v.x * r[0][0] + v.y * r[1][0] + v.z * r[2][0],
+		v.x * r[0][1] + v.y * r[1][1] + v.z * r[2][1],
+		v.x * r[0][2] + v.y * r[1][2] + v.z * r[2][2]);
+}
+
+static void PrepareComponent(const ObjMesh& mesh, Component& c)
+{
+	c.usable = false;
+	const XMFLOAT3& a = mesh.vertices[c.vertices[0]].Position;
+	float farthest = -1.f;
+	for (UINT i = 0; i < (UINT)c.vertices.size(); ++i)
+	{
+		const XMFLOAT3 d = Sub(mesh.vertices[c.vertices[i]].Position, a);
+		const float lenSq = Dot(d, d);
+		if (lenSq > farthest)
+		{
+			farthest = lenSq;
+			c.refB = i;
+		}
+	}
+	c.refA = 0;
+	c.extent = std::sqrt((std::max)(farthest, 0.f));
+	if (c.extent <= 0.f) return;
+
+	const XMFLOAT3 ab = Sub(mesh.vertices[c.vertices[c.refB]].Position, a);
+	float widest = 0.f;
+	for (UINT i = 0; i < (UINT)c.vertices.size(); ++i)
+	{
+		const XMFLOAT3 n = Cross(ab, Sub(mesh.vertices[c.vertices[i]].Position, a));
+		const float lenSq = Dot(n, n);
+		if (lenSq > widest)
+		{
+			widest = lenSq;
+			c.refC = i;
+		}
+	}
+	XMFLOAT3 frame[3];
+	c.usable = BuildFrame(a, mesh.vertices[c.vertices[c.refB]].Position, mesh.vertices[c.vertices[c.refC]].Position, frame);
+}
+
+// True when 'candidate' is 'prototype' moved by a rotation + translation;
+// 'transform' then maps prototype vertices onto the candidate.
+static bool MatchRigid(const ObjMesh& mesh, const Component& prototype, const Component& candidate, XMFLOAT4X4& transform)
+{
+	if (prototype.vertices.size() != candidate.vertices.size() ||
+		prototype.localIndices != candidate.localIndices)
+		return false;
+
+	const auto pos = [&](const Component& c, UINT local) -> const XMFLOAT3& { return mesh.vertices[c.vertices[local]].Position; };
+	XMFLOAT3 fp[3];
+	XMFLOAT3 fc[3];
+	if (!BuildFrame(pos(prototype, prototype.refA), pos(prototype, prototype.refB), pos(prototype, prototype.refC), fp) ||
+		!BuildFrame(pos(candidate, prototype.refA), pos(candidate, prototype.refB), pos(candidate, prototype.refC), fc))
+		return false;
+
+	// R = Fp^T * Fc: prototype frame coordinates re-expressed in the candidate frame
+	float r[3][3];
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+			r[i][j] = Axis(fp[0], i) * Axis(fc[0], j) + Axis(fp[1], i) * Axis(fc[1], j) + Axis(fp[2], i) * Axis(fc[2], j);
+	}
+	const XMFLOAT3& ap = pos(prototype, prototype.refA);
+	const XMFLOAT3& ac = pos(candidate, prototype.refA);
+	const XMFLOAT3 rotatedA = Rotate(ap, r);
+	const XMFLOAT3 t(ac.x - rotatedA.x, ac.y - rotatedA.y, ac.z - rotatedA.z);
+
+	const float tolerance = (std::max)(InstanceDetector::PositionTolerance * prototype.extent, 1e-6f);
+	for (size_t i = 0; i < prototype.vertices.size(); ++i)
+	{
+		const ObjMesh::Vertex& vp = mesh.vertices[prototype.vertices[i]];
+		const ObjMesh::Vertex& vc = mesh.vertices[candidate.vertices[i]];
+		const XMFLOAT3 moved = Rotate(Sub(vp.Position, ap), r);
+		const XMFLOAT3 d = Sub(XMFLOAT3(moved.x + ac.x, moved.y + ac.y, moved.z + ac.z), vc.Position);
+		if (Dot(d, d) > tolerance * tolerance)
+			return false;
+		if (std::fabs(vp.TexCoord.x - vc.TexCoord.x) > InstanceDetector::UvTolerance ||
+			std::fabs(vp.TexCoord.y - vc.TexCoord.y) > InstanceDetector::UvTolerance)
+			return false;
+		const XMFLOAT3 n = Rotate(vp.Normal, r);
+		const float lenSq = Dot(n, n) * Dot(vc.Normal, vc.Normal);
+		if (lenSq > 0.f && Dot(n, vc.Normal) < InstanceDetector::NormalTolerance * std::sqrt(lenSq))
+			return false;
+	}
+
+	transform = XMFLOAT4X4(
+		r[0][0], r[0][1], r[0][2], 0.f,
+		r[1][0], r[1][1], r[1][2], 0.f,
+		r[2][0], r[2][1], r[2][2], 0.f,
+		t.x, t.y, t.z, 1.f);
+	return true;
+}
+
+// -------------------------------------------------------
+// Detection
+// -------------------------------------------------------
+static uint64_t HashCombine(uint64_t h, uint64_t value)
+{
+	// FNV-1a over the 8 bytes of value
+	for (int i = 0; i < 8; ++i)
+	{
+		h ^= (value >> (i * 8)) & 0xFFu;
+		h *= 0x100000001B3ull;
+	}
+	return h;
+}
+
+static uint64_t CanonicalKey(const ObjMesh& mesh, const Component& c)
+{
+	uint64_t h = 0xCBF29CE484222325ull;
+	h = HashCombine(h, c.vertices.size());
+	h = HashCombine(h, c.triangles.size());
+	for (UINT i : c.localIndices)
+		h = HashCombine(h, i);
+	for (UINT v : c.vertices)
+	{
+		const XMFLOAT2& uv = mesh.vertices[v].TexCoord;
+		h = HashCombine(h, (uint64_t)(int64_t)std::lround(uv.x * 8192.f));
+		h = HashCombine(h, (uint64_t)(int64_t)std::lround(uv.y * 8192.f));
+	}
+	return h;
+}
+
+InstanceDetector::Stats InstanceDetector::Detect(ObjMesh& mesh)
+{
+	const auto start = std::chrono::steady_clock::now();
+	Stats stats;
+	stats.subsetsBefore = mesh.subsets.size();
+	stats.trianglesBefore = mesh.indices.size() / 3;
+
+	const size_t vertexCount = mesh.vertices.size();
+	std::vector<UINT> parent(vertexCount);
+	std::vector<UINT> componentOf(vertexCount, InvalidIndex);
+	std::vector<UINT> localOf(vertexCount, InvalidIndex);
+	std::vector<uint8_t> referenced(vertexCount, 0);
+	for (UINT i : mesh.indices)
+	{
+		if (i < vertexCount && !referenced[i])
+		{
+			referenced[i] = 1;
+			++stats.verticesBefore;
+		}
+	}
+
+	std::vector<UINT> newIndices;
+	newIndices.reserve(mesh.indices.size());
+	std::vector<MeshSubset> newSubsets;
+	std::vector<MeshInstance> instances;
+	std::vector<UINT> subsetVertices;
+
+	for (const MeshSubset& subset : mesh.subsets)
+	{
+		const UINT first = subset.indexStart;
+		const UINT end = (std::min)((UINT)mesh.indices.size(), subset.indexStart + subset.indexCount - subset.indexCount % 3);
+		bool inRange = true;
+		for (UINT i = first; i < end; ++i)
+			inRange = inRange && mesh.indices[i] < vertexCount;
+
+		// Vertices joined by a triangle or by a shared position (UV/normal seams)
+		std::vector<Component> components;
+		std::vector<UINT> triangleComponent;
+		if (inRange)
+		{
+			subsetVertices.clear();
+			for (UINT i = first; i < end; ++i)
+				parent[mesh.indices[i]] = InvalidIndex;
+			for (UINT i = first; i < end; ++i)
+			{
+				const UINT v = mesh.indices[i];
+				if (parent[v] == InvalidIndex)
+				{
+					parent[v] = v;
+					subsetVertices.push_back(v);
+				}
+			}
+			// Equal positions end up adjacent
+			std::sort(subsetVertices.begin(), subsetVertices.end(), [&](UINT a, UINT b)
+			{
+				return KeyOf(mesh.vertices[a].Position) < KeyOf(mesh.vertices[b].Position);
+			});
+			for (size_t k = 1; k < subsetVertices.size(); ++k)
+			{
+				if (KeyOf(mesh.vertices[subsetVertices[k]].Position) == KeyOf(mesh.vertices[subsetVertices[k - 1]].Position))
+					Unite(parent, subsetVertices[k], subsetVertices[k - 1]);
+			}
+			for (UINT i = first; i < end; i += 3)
+			{
+				Unite(parent, mesh.indices[i], mesh.indices[i + 1]);
+				Unite(parent, mesh.indices[i], mesh.indices[i + 2]);
+			}
+
+			for (UINT i = first; i < end; i += 3)
+			{
+				const UINT root = FindRoot(parent, mesh.indices[i]);
+				if (componentOf[root] == InvalidIndex)
+				{
+					componentOf[root] = (UINT)components.size();
+					components.emplace_back();
+				}
+				const UINT ci = componentOf[root];
+				triangleComponent.push_back(ci);
+				Component& c = components[ci];
+				c.triangles.push_back(i);
+				for (int k = 0; k < 3; ++k)
+				{
+					const UINT v = mesh.indices[i + k];
+					if (localOf[v] == InvalidIndex)
+					{
+						localOf[v] = (UINT)c.vertices.size();
+						c.vertices.push_back(v);
+					}
+					c.localIndices.push_back(localOf[v]);
+				}
+			}
+			for (UINT i = first; i < end; ++i)
+			{
+				componentOf[FindRoot(parent, mesh.indices[i])] = InvalidIndex;
+				localOf[mesh.indices[i]] = InvalidIndex;
+			}
+		}
+		stats.componentCount += components.size();
+
+		// groups[g][0] is the prototype; transforms[g][k] places member k
+		std::vector<std::vector<UINT>> groups;
+		std::vector<std::vector<XMFLOAT4X4>> transforms;
+		std::vector<UINT> groupOf(components.size(), InvalidIndex);
+		std::unordered_map<uint64_t, std::vector<UINT>> groupsByKey;
+		const XMFLOAT4X4 identity(
+			1.f, 0.f, 0.f, 0.f,
+			0.f, 1.f, 0.f, 0.f,
+			0.f, 0.f, 1.f, 0.f,
+			0.f, 0.f, 0.f, 1.f);
+		for (UINT ci = 0; ci < (UINT)components.size(); ++ci)
+		{
+			Component& c = components[ci];
+			if (c.triangles.size() < MinTriangles)
+				continue;
+			c.key = CanonicalKey(mesh, c);
+			std::vector<UINT>& candidates = groupsByKey[c.key];
+			XMFLOAT4X4 transform;
+			for (UINT g : candidates)
+			{
+				if (MatchRigid(mesh, components[groups[g][0]], c, transform))
+				{
+					groupOf[ci] = g;
+					groups[g].push_back(ci);
+					transforms[g].push_back(transform);
+					break;
+				}
+			}
+			if (groupOf[ci] != InvalidIndex)
+				continue;
+			PrepareComponent(mesh, c);
+			if (!c.usable)
+				continue;
+			groupOf[ci] = (UINT)groups.size();
+			candidates.push_back((UINT)groups.size());
+			groups.push_back({ ci });
+			transforms.push_back({ identity });
+		}
+
+		// Remaining triangles keep the subset, each group gets a new one
+		std::vector<uint8_t> instanced(components.size(), 0);
+		for (const std::vector<UINT>& g : groups)
+		{
+			if (g.size() >= MinInstances)
+			{
+				for (UINT ci : g)
+					instanced[ci] = 1;
+			}
+		}
+
+		MeshSubset remainder = subset;
+		remainder.indexStart = (UINT)newIndices.size();
+		if (inRange)
+		{
+			for (size_t t = 0; t < triangleComponent.size(); ++t)
+			{
+				if (instanced[triangleComponent[t]])
+					continue;
+				const UINT i = first + (UINT)t * 3;
+				newIndices.insert(newIndices.end(), mesh.indices.begin() + i, mesh.indices.begin() + i + 3);
+			}
+		}
+		else
+		{
+			newIndices.insert(newIndices.end(), mesh.indices.begin() + first, mesh.indices.begin() + end);
+		}
+		remainder.indexCount = (UINT)newIndices.size() - remainder.indexStart;
+		remainder.vertexStart = remainder.vertexCount = 0;
+		remainder.meshletStart = remainder.meshletCount = 0;
+		remainder.lodStart = remainder.lodCount = 0;
+		remainder.instanceStart = remainder.instanceCount = 0;
+		if (remainder.indexCount > 0)
+			newSubsets.push_back(remainder);
+
+		for (size_t g = 0; g < groups.size(); ++g)
+		{
+			if (groups[g].size() < MinInstances)
+				continue;
+			MeshSubset prototype = remainder;
+			prototype.indexStart = (UINT)newIndices.size();
+			for (UINT i : components[groups[g][0]].triangles)
+				newIndices.insert(newIndices.end(), mesh.indices.begin() + i, mesh.indices.begin() + i + 3);
+			prototype.indexCount = (UINT)newIndices.size() - prototype.indexStart;
+			prototype.instanceStart = (UINT)instances.size();
+			prototype.instanceCount = (UINT)groups[g].size();
+			for (const XMFLOAT4X4& transform : transforms[g])
+			{
+				MeshInstance instance{};
+				instance.transform = transform;
+				instance.subset = (UINT)newSubsets.size();
+				instances.push_back(instance);
+			}
+			newSubsets.push_back(prototype);
+			++stats.groupCount;
+			stats.instanceCount += groups[g].size();
+		}
+	}
+
+	mesh.indices.swap(newIndices);
+	mesh.subsets.swap(newSubsets);
+	mesh.instances.swap(instances);
+	mesh.meshlets.clear();
+	mesh.lods.clear();
+	ObjLoader::ComputeBounds(mesh);
+
+	std::fill(referenced.begin(), referenced.end(), (uint8_t)0);
+	for (UINT i : mesh.indices)
+	{
+		if (i < vertexCount && !referenced[i])
+		{
+			referenced[i] = 1;
+			++stats.verticesAfter;
+		}
+	}
+	stats.subsetsAfter = mesh.subsets.size();
+	stats.trianglesAfter = mesh.indices.size() / 3;
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+std::string InstanceDetector::Format(const Stats& s)
+{
+	char buf[320];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[Instancing] %zu components, %zu groups / %zu instances, subsets %zu -> %zu, "
+		"vertices %zu -> %zu, triangles %zu -> %zu, %.1f ms\n",
+		s.componentCount,
+		s.groupCount,
+		s.instanceCount,
+		s.subsetsBefore,
+		s.subsetsAfter,
+		s.verticesBefore,
+		s.verticesAfter,
+		s.trianglesBefore,
+		s.trianglesAfter,
+		s.milliseconds);
+	return buf;
+}
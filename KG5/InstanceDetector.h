@@ -0,0 +1,46 @@
+#pragma once
+#include "ObjLoader.h"
+#include <string>
+// Finds connected components that are rigid copies of each other (columns,
+// vases, arches exported as separate geometry) and keeps one copy plus a
+// list of MeshInstance transforms.
+//
+// Components are bucketed by a canonical key that does not depend on
+// placement: vertex/triangle counts, the triangle list renumbered in
+// first-use order, and quantized UVs. Candidates in a bucket are then fitted
+// with an orthonormal frame through three reference vertices and accepted
+// only when every position, normal and UV matches within tolerance, so
+// mirrored or scaled copies are never merged.
+class InstanceDetector
+{
+public:
+	static constexpr UINT MinTriangles = 32;     // smaller components stay in their subset
+	static constexpr UINT MinInstances = 2;      // copies (including the prototype) per group
+	static constexpr float PositionTolerance = 1e-4f; // of the component's extent
+	static constexpr float NormalTolerance = 0.999f;  // min cos between rotated normals
+	static constexpr float UvTolerance = 1e-5f;
+
+	struct Stats
+	{
+		size_t subsetsBefore = 0;
+		size_t subsetsAfter = 0;
+		size_t componentCount = 0;
+		size_t groupCount = 0;
+		size_t instanceCount = 0;
+		size_t verticesBefore = 0; // referenced vertices
+		size_t verticesAfter = 0;
+		size_t trianglesBefore = 0; // stored triangles
+		size_t trianglesAfter = 0;
+		double milliseconds = 0.0;
+	};
+
+	// Every group becomes its own subset (same material) holding the first
+	// copy, with instanceStart/instanceCount into mesh.instances; instance 0
+	// of a group is the identity. The remaining triangles of each subset keep
+	// their order. Run right after loading: meshlets and LODs are cleared,
+	// vertices are left for MeshOptimizer::OptimizeVertexFetch to compact,
+	// and subset bounds are recomputed.
+	static Stats Detect(ObjMesh& mesh);
+
+	static std::string Format(const Stats& s);
+};
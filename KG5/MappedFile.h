@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <cstddef>
+// Read-only memory mapping of a whole file.
+// The view stays valid until Close() or destruction.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen() const { return m_open; }
+	const char* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+private:
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+	bool m_open = false;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
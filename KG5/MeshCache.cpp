@@ -0,0 +1,380 @@
+#include "MeshCache.h"
+#include "ContentHash.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+// -------------------------------------------------------
+// File layout
+// -------------------------------------------------------
+// [CacheHeader][section data ...], every section 16-byte aligned.
+// All values are little-endian, native struct layout (the cache is a
+// local build artifact, not an interchange format).
+enum CacheSectionId : uint32_t
+{
+	SectionSources = 0,   // blob: {u64 size, i64 mtime, u64 hash, string path}
+	SectionVertices = 1,  // ObjMesh::Vertex[]
+	SectionIndices = 2,   // UINT[]
+	SectionSubsets = 3,   // MeshSubset[]
+	SectionMaterials = 4, // blob: {float4 kd, float4 ks, float ns, 4 strings}
+	SectionMeshlets = 5,  // Meshlet[]
+	SectionLods = 6,      // MeshLod[]
+	SectionInstances = 7, // MeshInstance[]
+	SectionCount
+};
+struct CacheSection
+{
+	uint64_t offset = 0;
+	uint64_t bytes = 0;
+	uint64_t count = 0;
+	uint32_t elementSize = 0; // 0 for variable-length blobs
+	uint32_t pad = 0;
+};
+struct CacheHeader
+{
+	char magic[8] = { 'K', 'G', '5', 'M', 'E', 'S', 'H', '\0' };
+	uint32_t version = MeshCache::Version;
+	uint32_t sectionCount = SectionCount;
+	uint64_t fileSize = 0;
+	uint32_t settings = 0; // see MeshCache::Write
+	uint32_t pad = 0;
+	CacheSection sections[SectionCount];
+};
+static_assert(std::is_trivially_copyable<ObjMesh::Vertex>::value, "Vertex must be memcpy-able");
+static_assert(std::is_trivially_copyable<MeshSubset>::value, "MeshSubset must be memcpy-able");
+static_assert(std::is_trivially_copyable<Meshlet>::value, "Meshlet must be memcpy-able");
+static_assert(std::is_trivially_copyable<MeshLod>::value, "MeshLod must be memcpy-able");
+static_assert(std::is_trivially_copyable<MeshInstance>::value, "MeshInstance must be memcpy-able");
+
+// -------------------------------------------------------
+// Blob helpers
+// -------------------------------------------------------
+class BlobWriter
+{
+public:
+	std::vector<char> data;
+	template <typename T> void Put(const T& value)
+	{
+		const char* p = reinterpret_cast<const char*>(&value);
+		data.insert(data.end(), p, p + sizeof(T));
+	}
+	void PutString(const std::string& s)
+	{
+		Put((uint32_t)s.size());
+		data.insert(data.end(), s.begin(), s.end());
+	}
+};
+class BlobReader
+{
+public:
+	BlobReader(const char* data, size_t size) : m_p(data), m_end(data + size) {}
+	template <typename T> bool Get(T& value)
+	{
+		if ((size_t)(m_end - m_p) < sizeof(T)) return false;
+		std::memcpy(&value, m_p, sizeof(T));
+		m_p += sizeof(T);
+		return true;
+	}
+	bool GetString(std::string& s)
+	{
+		uint32_t len = 0;
+		if (!Get(len) || (size_t)(m_end - m_p) < len) return false;
+		s.assign(m_p, len);
+		m_p += len;
+		return true;
+	}
+private:
+	const char* m_p;
+	const char* m_end;
+};
+
+// -------------------------------------------------------
+// Source stamps
+// -------------------------------------------------------
+struct SourceStamp
+{
+	uint64_t size = 0;
+	int64_t mtime = 0;
+	uint64_t hash = 0;
+};
+static bool StatSource(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+	// file_size() returns -1 on error; leave the outputs untouched then
+	std::error_code ec;
+	const uintmax_t bytes = fs::file_size(path, ec);
+	if (ec) return false;
+	const fs::file_time_type t = fs::last_write_time(path, ec);
+	if (ec) return false;
+	size = (uint64_t)bytes;
+	mtime = (int64_t)t.time_since_epoch().count();
+	return true;
+}
+static bool HashSource(const std::string& path, uint64_t& hash)
+{
+	MappedFile file;
+	if (!file.Open(path)) return false;
+	hash = HashBytes64(file.Data(), file.Size());
+	return true;
+}
+static std::string DirOfPath(const std::string& path)
+{
+	size_t p = path.find_last_of("/\\");
+	return (p == std::string::npos) ? "" : path.substr(0, p + 1);
+}
+
+// -------------------------------------------------------
+// MeshCache
+// -------------------------------------------------------
+std::string MeshCache::PathFor(const std::string& objPath)
+{
+	return fs::path(objPath).replace_extension(".kg5mesh").string();
+}
+
+bool MeshCache::Write(const std::string& objPath, const ObjMesh& mesh, uint32_t settings)
+{
+	const std::string dir = DirOfPath(objPath);
+	std::vector<std::string> sources;
+	sources.push_back(objPath);
+	sources.insert(sources.end(), mesh.materialLibraries.begin(), mesh.materialLibraries.end());
+
+	BlobWriter sourceBlob;
+	size_t sourceCount = 0;
+	for (const std::string& src : sources)
+	{
+		SourceStamp stamp;
+		// A missing mtllib is recorded with size 0 so its later appearance
+		// invalidates the cache.
+		if (StatSource(src, stamp.size, stamp.mtime) && !HashSource(src, stamp.hash))
+			return false;
+		const std::string rel = (src.compare(0, dir.size(), dir) == 0) ? src.substr(dir.size()) : src;
+		sourceBlob.Put(stamp);
+		sourceBlob.PutString(rel);
+		++sourceCount;
+	}
+
+	BlobWriter materialBlob;
+	for (const Material& m : mesh.materials)
+	{
+		materialBlob.Put(m.diffuse);
+		materialBlob.Put(m.specular);
+		materialBlob.Put(m.shininess);
+		materialBlob.PutString(m.name);
+		materialBlob.PutString(m.diffuseTexture);
+		materialBlob.PutString(m.normalTexture);
+		materialBlob.PutString(m.displacementTexture);
+	}
+
+	CacheHeader header;
+	uint64_t offset = (sizeof(CacheHeader) + 15) & ~15ull;
+	auto place = [&](CacheSectionId id, uint64_t bytes, uint64_t count, uint32_t elementSize)
+	{
+		CacheSection& s = header.sections[id];
+		s.offset = offset;
+		s.bytes = bytes;
+		s.count = count;
+		s.elementSize = elementSize;
+		offset = (offset + bytes + 15) & ~15ull;
+	};
+	place(SectionSources, sourceBlob.data.size(), sourceCount, 0);
+	place(SectionVertices, mesh.vertices.size() * sizeof(ObjMesh::Vertex), mesh.vertices.size(), sizeof(ObjMesh::Vertex));
+	place(SectionIndices, mesh.indices.size() * sizeof(UINT), mesh.indices.size(), sizeof(UINT));
+	place(SectionSubsets, mesh.subsets.size() * sizeof(MeshSubset), mesh.subsets.size(), sizeof(MeshSubset));
+	place(SectionMaterials, materialBlob.data.size(), mesh.materials.size(), 0);
+	place(SectionMeshlets, mesh.meshlets.size() * sizeof(Meshlet), mesh.meshlets.size(), sizeof(Meshlet));
+	place(SectionLods, mesh.lods.size() * sizeof(MeshLod), mesh.lods.size(), sizeof(MeshLod));
+	place(SectionInstances, mesh.instances.size() * sizeof(MeshInstance), mesh.instances.size(), sizeof(MeshInstance));
+	header.fileSize = offset;
+	header.settings = settings;
+
+	std::vector<char> file((size_t)header.fileSize, 0);
+	std::memcpy(file.data(), &header, sizeof(header));
+	auto copySection = [&](CacheSectionId id, const void* src)
+	{
+		const CacheSection& s = header.sections[id];
+		if (s.bytes) std::memcpy(file.data() + s.offset, src, (size_t)s.bytes);
+	};
+	copySection(SectionSources, sourceBlob.data.data());
+	copySection(SectionVertices, mesh.vertices.data());
+	copySection(SectionIndices, mesh.indices.data());
+	copySection(SectionSubsets, mesh.subsets.data());
+	copySection(SectionMaterials, materialBlob.data.data());
+	copySection(SectionMeshlets, mesh.meshlets.data());
+	copySection(SectionLods, mesh.lods.data());
+	copySection(SectionInstances, mesh.instances.data());
+
+	// Write to a temp file and rename so a crash never leaves a torn cache.
+	const std::string cachePath = PathFor(objPath);
+	const std::string tmpPath = cachePath + ".tmp";
+	{
+		std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open()) return false;
+		out.write(file.data(), (std::streamsize)file.size());
+		if (!out.good()) return false;
+	}
+	std::error_code ec;
+	fs::rename(tmpPath, cachePath, ec);
+	if (ec)
+	{
+		fs::remove(tmpPath, ec);
+		return false;
+	}
+	return true;
+}
+
+bool MeshCache::Open(const std::string& objPath, uint32_t settings)
+{
+	Close();
+	if (!m_file.Open(PathFor(objPath)) || m_file.Size() < sizeof(CacheHeader))
+	{
+		Close();
+		return false;
+	}
+	CacheHeader header;
+	std::memcpy(&header, m_file.Data(), sizeof(header));
+	const CacheHeader expected;
+	if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+		header.version != Version || header.sectionCount != SectionCount ||
+		header.settings != settings ||
+		header.fileSize != m_file.Size() ||
+		header.sections[SectionVertices].elementSize != sizeof(ObjMesh::Vertex) ||
+		header.sections[SectionIndices].elementSize != sizeof(UINT) ||
+		header.sections[SectionSubsets].elementSize != sizeof(MeshSubset) ||
+		header.sections[SectionMeshlets].elementSize != sizeof(Meshlet) ||
+		header.sections[SectionLods].elementSize != sizeof(MeshLod) ||
+		header.sections[SectionInstances].elementSize != sizeof(MeshInstance))
+	{
+		Close();
+		return false;
+	}
+	for (const CacheSection& s : header.sections)
+	{
+		if (s.offset > header.fileSize || s.bytes > header.fileSize - s.offset ||
+			(s.elementSize != 0 && s.bytes != s.count * s.elementSize))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	const char* base = m_file.Data();
+	m_sources = base + header.sections[SectionSources].offset;
+	m_sourceBytes = (size_t)header.sections[SectionSources].bytes;
+	m_sourceCount = (size_t)header.sections[SectionSources].count;
+
+	// Staleness check
+	m_dir = DirOfPath(objPath);
+	BlobReader sources(m_sources, m_sourceBytes);
+	for (size_t i = 0; i < m_sourceCount; ++i)
+	{
+		SourceStamp stamp;
+		std::string rel;
+		if (!sources.Get(stamp) || !sources.GetString(rel))
+		{
+			Close();
+			return false;
+		}
+		const std::string src = (i == 0) ? objPath : m_dir + rel;
+		SourceStamp current;
+		if (!StatSource(src, current.size, current.mtime))
+		{
+			// Still missing is fine; appearing or disappearing is not
+			if (stamp.size == 0 && stamp.hash == 0) continue;
+			Close();
+			return false;
+		}
+		if (current.size != stamp.size)
+		{
+			Close();
+			return false;
+		}
+		if (current.mtime != stamp.mtime &&
+			(!HashSource(src, current.hash) || current.hash != stamp.hash))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	m_vertices = reinterpret_cast<const ObjMesh::Vertex*>(base + header.sections[SectionVertices].offset);
+	m_vertexCount = (size_t)header.sections[SectionVertices].count;
+	m_indices = reinterpret_cast<const UINT*>(base + header.sections[SectionIndices].offset);
+	m_indexCount = (size_t)header.sections[SectionIndices].count;
+	m_subsets = reinterpret_cast<const MeshSubset*>(base + header.sections[SectionSubsets].offset);
+	m_subsetCount = (size_t)header.sections[SectionSubsets].count;
+	m_meshlets = reinterpret_cast<const Meshlet*>(base + header.sections[SectionMeshlets].offset);
+	m_meshletCount = (size_t)header.sections[SectionMeshlets].count;
+	m_lods = reinterpret_cast<const MeshLod*>(base + header.sections[SectionLods].offset);
+	m_lodCount = (size_t)header.sections[SectionLods].count;
+	m_instances = reinterpret_cast<const MeshInstance*>(base + header.sections[SectionInstances].offset);
+	m_instanceCount = (size_t)header.sections[SectionInstances].count;
+	m_materials = base + header.sections[SectionMaterials].offset;
+	m_materialBytes = (size_t)header.sections[SectionMaterials].bytes;
+	m_materialCount = (size_t)header.sections[SectionMaterials].count;
+	if (m_vertexCount == 0)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MeshCache::Close()
+{
+	m_file.Close();
+	m_dir.clear();
+	m_vertices = nullptr;
+	m_vertexCount = 0;
+	m_indices = nullptr;
+	m_indexCount = 0;
+	m_subsets = nullptr;
+	m_subsetCount = 0;
+	m_meshlets = nullptr;
+	m_meshletCount = 0;
+	m_lods = nullptr;
+	m_lodCount = 0;
+	m_instances = nullptr;
+	m_instanceCount = 0;
+	m_materials = nullptr;
+	m_materialBytes = 0;
+	m_materialCount = 0;
+	m_sources = nullptr;
+	m_sourceBytes = 0;
+	m_sourceCount = 0;
+}
+
+void MeshCache::ReadTables(ObjMesh& out) const
+{
+	out.subsets.assign(m_subsets, m_subsets + m_subsetCount);
+	out.meshlets.assign(m_meshlets, m_meshlets + m_meshletCount);
+	out.lods.assign(m_lods, m_lods + m_lodCount);
+	out.instances.assign(m_instances, m_instances + m_instanceCount);
+
+	out.materials.clear();
+	out.materials.reserve(m_materialCount);
+	BlobReader materials(m_materials, m_materialBytes);
+	for (size_t i = 0; i < m_materialCount; ++i)
+	{
+		Material m;
+		if (!materials.Get(m.diffuse) || !materials.Get(m.specular) || !materials.Get(m.shininess) ||
+			!materials.GetString(m.name) || !materials.GetString(m.diffuseTexture) ||
+			!materials.GetString(m.normalTexture) || !materials.GetString(m.displacementTexture))
+			break;
+		out.materials.push_back(m);
+	}
+
+	out.materialLibraries.clear();
+	BlobReader sources(m_sources, m_sourceBytes);
+	for (size_t i = 0; i < m_sourceCount; ++i)
+	{
+		SourceStamp stamp;
+		std::string rel;
+		if (!sources.Get(stamp) || !sources.GetString(rel))
+			break;
+		if (i > 0)
+			out.materialLibraries.push_back(m_dir + rel);
+	}
+}
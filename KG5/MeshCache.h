@@ -0,0 +1,58 @@
+#pragma once
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include <string>
+#include <cstdint>
+// Binary cache of a fully processed ObjMesh (<name>.kg5mesh next to the OBJ).
+// Stores the final vertex/index arrays, subsets and materials so startup skips
+// OBJ/MTL parsing and tangent generation. The cache records size, mtime and a
+// content hash of the OBJ and every mtllib it used; it is stale when a size
+// differs, or when an mtime differs and the content hash no longer matches.
+class MeshCache
+{
+public:
+	// Bump whenever the stored data or the processing that produced it
+	// changes (2: indices reordered by MeshOptimizer, 3: per-subset vertex ranges,
+	// 4: meshlets, 5: LOD chains, 6: subset bounds, 7: instanced subsets,
+	// 8: value-welded vertices without degenerate triangles, 9: one subset
+	// per material, 10: oversized subsets split into chunks, settings key).
+	static constexpr uint32_t Version = 10;
+	static std::string PathFor(const std::string& objPath);
+	// Serializes 'mesh' (loaded from objPath) next to the OBJ. 'settings'
+	// identifies the load-time options that shaped the mesh.
+	static bool Write(const std::string& objPath, const ObjMesh& mesh, uint32_t settings = 0);
+	// Maps the cache for objPath and validates it against the source files;
+	// a cache written with different settings is stale.
+	bool Open(const std::string& objPath, uint32_t settings = 0);
+	void Close();
+	bool IsOpen() const { return m_vertices != nullptr; }
+	// Arrays point straight into the mapped file; valid until Close().
+	const ObjMesh::Vertex* Vertices() const { return m_vertices; }
+	size_t VertexCount() const { return m_vertexCount; }
+	const UINT* Indices() const { return m_indices; }
+	size_t IndexCount() const { return m_indexCount; }
+	// Decodes the small tables (subsets, meshlets, LODs, instances, materials, material libraries).
+	// Vertices and indices are left empty; use the mapped arrays instead.
+	void ReadTables(ObjMesh& out) const;
+private:
+	MappedFile m_file;
+	std::string m_dir;
+	const ObjMesh::Vertex* m_vertices = nullptr;
+	size_t m_vertexCount = 0;
+	const UINT* m_indices = nullptr;
+	size_t m_indexCount = 0;
+	const MeshSubset* m_subsets = nullptr;
+	size_t m_subsetCount = 0;
+	const Meshlet* m_meshlets = nullptr;
+	size_t m_meshletCount = 0;
+	const MeshLod* m_lods = nullptr;
+	size_t m_lodCount = 0;
+	const MeshInstance* m_instances = nullptr;
+	size_t m_instanceCount = 0;
+	const char* m_materials = nullptr;
+	size_t m_materialBytes = 0;
+	size_t m_materialCount = 0;
+	const char* m_sources = nullptr;
+	size_t m_sourceBytes = 0;
+	size_t m_sourceCount = 0;
+};
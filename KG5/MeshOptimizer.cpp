@@ -0,0 +1,409 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+static const UINT InvalidIndex = 0xFFFFFFFFu;
+
+// -------------------------------------------------------
+// FIFO post-transform cache model
+// -------------------------------------------------------
+// A vertex is resident while fewer than CacheSize misses happened since it
+// was inserted. Flush() just advances the clock past every stamp.
+class FifoCache
+{
+public:
+	explicit FifoCache(size_t vertexCount) : m_stamps(vertexCount, 0) {}
+	// Returns true on a miss.
+	bool Touch(UINT v)
+	{
+		if (m_time - m_stamps[v] <= MeshOptimizer::CacheSize)
+			return false;
+		m_stamps[v] = m_time++;
+		return true;
+	}
+	void Flush() { m_time += MeshOptimizer::CacheSize + 1; }
+private:
+	std::vector<uint32_t> m_stamps;
+	uint32_t m_time = MeshOptimizer::CacheSize + 1;
+};
+
+static size_t TriangleMisses(FifoCache& cache, const UINT* tri)
+{
+	return (size_t)cache.Touch(tri[0]) + (size_t)cache.Touch(tri[1]) + (size_t)cache.Touch(tri[2]);
+}
+
+static void SimulateSubsets(const ObjMesh& mesh, size_t& misses, size_t& referencedVertices)
+{
+	misses = 0;
+	referencedVertices = 0;
+	if (mesh.vertices.empty())
+		return;
+	FifoCache cache(mesh.vertices.size());
+	std::vector<UINT> seen(mesh.vertices.size(), InvalidIndex);
+	for (size_t si = 0; si < mesh.subsets.size(); ++si)
+	{
+		const MeshSubset& s = mesh.subsets[si];
+		const UINT* idx = mesh.indices.data() + s.indexStart;
+		cache.Flush();
+		for (UINT i = 0; i + 2 < s.indexCount; i += 3)
+			misses += TriangleMisses(cache, idx + i);
+		for (UINT i = 0; i < s.indexCount; ++i)
+		{
+			if (seen[idx[i]] != (UINT)si)
+			{
+				seen[idx[i]] = (UINT)si;
+				++referencedVertices;
+			}
+		}
+	}
+}
+
+// -------------------------------------------------------
+// Vertex cache (Tipsify)
+// -------------------------------------------------------
+void MeshOptimizer::OptimizeVertexCache(UINT* indices, size_t indexCount, size_t vertexCount,
+	std::vector<UINT>* clusterStarts)
+{
+	if (clusterStarts) clusterStarts->clear();
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0 || vertexCount == 0)
+		return;
+
+	// Vertex -> triangle adjacency (CSR) and live triangle counts
+	std::vector<UINT> live(vertexCount, 0);
+	for (size_t i = 0; i < triCount * 3; ++i)
+		++live[indices[i]];
+	std::vector<UINT> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + live[v];
+	std::vector<UINT> adjacency(triCount * 3);
+	{
+		std::vector<UINT> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triCount * 3; ++i)
+			adjacency[fill[indices[i]]++] = (UINT)(i / 3);
+	}
+
+	std::vector<UINT> cacheTime(vertexCount, 0);
+	std::vector<char> emitted(triCount, 0);
+	std::vector<UINT> deadEnd;
+	deadEnd.reserve(triCount * 3);
+	std::vector<UINT> candidates;
+	std::vector<UINT> out;
+	out.reserve(triCount * 3);
+
+	const UINT k = CacheSize;
+	UINT time = k + 1;
+	size_t cursor = 0;
+	UINT fanning = 0;
+	while (live[fanning] == 0 && fanning + 1 < vertexCount) ++fanning;
+	if (clusterStarts) clusterStarts->push_back(0);
+
+	while (fanning != InvalidIndex)
+	{
+		// Emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (UINT a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+		{
+			const UINT t = adjacency[a];
+			if (emitted[t]) continue;
+			emitted[t] = 1;
+			for (int c = 0; c < 3; ++c)
+			{
+				const UINT v = indices[t * 3 + c];
+				out.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - cacheTime[v] > k)
+					cacheTime[v] = time++;
+			}
+		}
+
+		// Next fanning vertex: the oldest candidate that stays in cache
+		// while its remaining triangles are emitted.
+		UINT next = InvalidIndex;
+		int bestPriority = -1;
+		for (UINT v : candidates)
+		{
+			if (live[v] == 0) continue;
+			int priority = 0;
+			if (time - cacheTime[v] + 2 * live[v] <= k)
+				priority = (int)(time - cacheTime[v]);
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		if (next == InvalidIndex)
+		{
+			// Dead end: recent vertices first, then scan input order
+			while (!deadEnd.empty())
+			{
+				const UINT d = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[d] > 0)
+				{
+					next = d;
+					break;
+				}
+			}
+			while (next == InvalidIndex && cursor < vertexCount)
+			{
+				if (live[cursor] > 0)
+					next = (UINT)cursor;
+				else
+					++cursor;
+			}
+			if (next != InvalidIndex && clusterStarts)
+				clusterStarts->push_back((UINT)(out.size() / 3));
+		}
+		fanning = next;
+	}
+
+	std::copy(out.begin(), out.end(), indices);
+}
+
+// -------------------------------------------------------
+// Overdraw (cluster sort)
+// -------------------------------------------------------
+size_t MeshOptimizer::OptimizeOverdraw(UINT* indices, size_t indexCount,
+	const XMFLOAT3* positions, size_t vertexCount, const std::vector<UINT>& hardClusters)
+{
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0 || hardClusters.empty())
+		return 0;
+
+	// Split hard clusters at soft boundaries where a cache flush costs
+	// little compared to the cluster's own ACMR.
+	std::vector<UINT> clusters;
+	FifoCache cache(vertexCount);
+	for (size_t h = 0; h < hardClusters.size(); ++h)
+	{
+		const size_t begin = hardClusters[h];
+		const size_t end = (h + 1 < hardClusters.size()) ? hardClusters[h + 1] : triCount;
+		if (begin >= end) continue;
+
+		cache.Flush();
+		size_t hardMisses = 0;
+		for (size_t t = begin; t < end; ++t)
+			hardMisses += TriangleMisses(cache, indices + t * 3);
+		const float threshold = OverdrawThreshold * (float)hardMisses / (float)(end - begin);
+
+		cache.Flush();
+		clusters.push_back((UINT)begin);
+		size_t runMisses = 0;
+		size_t runTris = 0;
+		for (size_t t = begin; t < end; ++t)
+		{
+			runMisses += TriangleMisses(cache, indices + t * 3);
+			++runTris;
+			if (t + 1 < end && (float)runMisses <= threshold * (float)runTris)
+			{
+				clusters.push_back((UINT)(t + 1));
+				cache.Flush();
+				runMisses = 0;
+				runTris = 0;
+			}
+		}
+	}
+
+	// Area-weighted centroid and normal per cluster
+	const size_t clusterCount = clusters.size();
+	std::vector<XMFLOAT3> centroids(clusterCount, XMFLOAT3(0.f, 0.f, 0.f));
+	std::vector<XMFLOAT3> normals(clusterCount, XMFLOAT3(0.f, 0.f, 0.f));
+	XMFLOAT3 meshCentroid(0.f, 0.f, 0.f);
+	float meshArea = 0.f;
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		const size_t end = (c + 1 < clusterCount) ? clusters[c + 1] : triCount;
+		float area = 0.f;
+		for (size_t t = clusters[c]; t < end; ++t)
+		{
+			const XMFLOAT3& p0 = positions[indices[t * 3 + 0]];
+			const XMFLOAT3& p1 = positions[indices[t * 3 + 1]];
+			const XMFLOAT3& p2 = positions[indices[t * 3 + 2]];
+			const float e1x = p1.x - p0.x, e1y = p1.y - p0.y, e1z = p1.z - p0.z;
+			const float e2x = p2.x - p0.x, e2y = p2.y - p0.y, e2z = p2.z - p0.z;
+			const float nx = e1y * e2z - e1z * e2y;
+			const float ny = e1z * e2x - e1x * e2z;
+			const float nz = e1x * e2y - e1y * e2x;
+			const float a = std::sqrt(nx * nx + ny * ny + nz * nz);
+			centroids[c].x += (p0.x + p1.x + p2.x) * a;
+			centroids[c].y += (p0.y + p1.y + p2.y) * a;
+			centroids[c].z += (p0.z + p1.z + p2.z) * a;
+			normals[c].x += nx;
+			normals[c].y += ny;
+			normals[c].z += nz;
+			area += a;
+		}
+		meshCentroid.x += centroids[c].x;
+		meshCentroid.y += centroids[c].y;
+		meshCentroid.z += centroids[c].z;
+		meshArea += area;
+		const float inv = (area > 0.f) ? 1.f / (3.f * area) : 0.f;
+		centroids[c].x *= inv;
+		centroids[c].y *= inv;
+		centroids[c].z *= inv;
+	}
+	const float invMesh = (meshArea > 0.f) ? 1.f / (3.f * meshArea) : 0.f;
+	meshCentroid.x *= invMesh;
+	meshCentroid.y *= invMesh;
+	meshCentroid.z *= invMesh;
+
+	// Clusters facing away from the centre are likely occluders: draw them first
+	std::vector<float> keys(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		const XMFLOAT3& n = normals[c];
+		const float len = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+		const float dx = centroids[c].x - meshCentroid.x;
+		const float dy = centroids[c].y - meshCentroid.y;
+		const float dz = centroids[c].z - meshCentroid.z;
+		keys[c] = (len > 0.f) ? (dx * n.x + dy * n.y + dz * n.z) / len : 0.f;
+	}
+	std::vector<UINT> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c) order[c] = (UINT)c;
+	std::stable_sort(order.begin(), order.end(), [&](UINT a, UINT b) { return keys[a] > keys[b]; });
+
+	std::vector<UINT> out;
+	out.reserve(triCount * 3);
+	for (UINT c : order)
+	{
+		const size_t end = (c + 1 < clusterCount) ? clusters[c + 1] : triCount;
+		out.insert(out.end(), indices + clusters[c] * 3, indices + end * 3);
+	}
+	std::copy(out.begin(), out.end(), indices);
+	return clusterCount;
+}
+
+// -------------------------------------------------------
+// Vertex fetch
+// -------------------------------------------------------
+void MeshOptimizer::OptimizeVertexFetch(ObjMesh& mesh)
+{
+	std::vector<UINT> remap(mesh.vertices.size(), InvalidIndex);
+	std::vector<ObjMesh::Vertex> out;
+	out.reserve(mesh.vertices.size());
+	for (MeshSubset& s : mesh.subsets)
+	{
+		s.vertexStart = (UINT)out.size();
+		UINT* idx = mesh.indices.data() + s.indexStart;
+		for (UINT i = 0; i < s.indexCount; ++i)
+		{
+			const UINT v = idx[i];
+			if (remap[v] == InvalidIndex || remap[v] < s.vertexStart)
+			{
+				remap[v] = (UINT)out.size();
+				out.push_back(mesh.vertices[v]);
+			}
+			idx[i] = remap[v];
+		}
+		s.vertexCount = (UINT)out.size() - s.vertexStart;
+	}
+	mesh.vertices.swap(out);
+}
+
+// -------------------------------------------------------
+// Driver
+// -------------------------------------------------------
+MeshOptimizer::Stats MeshOptimizer::Optimize(ObjMesh& mesh)
+{
+	Stats stats;
+	const auto start = std::chrono::steady_clock::now();
+	stats.triangleCount = mesh.indices.size() / 3;
+
+	size_t misses = 0;
+	size_t referenced = 0;
+	SimulateSubsets(mesh, misses, referenced);
+	stats.acmrBefore = stats.triangleCount ? (float)misses / (float)stats.triangleCount : 0.f;
+	stats.atvrBefore = referenced ? (float)misses / (float)referenced : 0.f;
+
+	// Each subset is optimized in a compact local vertex space
+	std::vector<UINT> globalToLocal(mesh.vertices.size(), InvalidIndex);
+	std::vector<UINT> localToGlobal;
+	std::vector<UINT> local;
+	std::vector<XMFLOAT3> localPositions;
+	std::vector<UINT> hardClusters;
+	for (const MeshSubset& s : mesh.subsets)
+	{
+		UINT* idx = mesh.indices.data() + s.indexStart;
+		const size_t count = s.indexCount - s.indexCount % 3;
+		localToGlobal.clear();
+		local.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			UINT& l = globalToLocal[idx[i]];
+			if (l == InvalidIndex)
+			{
+				l = (UINT)localToGlobal.size();
+				localToGlobal.push_back(idx[i]);
+			}
+			local[i] = l;
+		}
+		localPositions.resize(localToGlobal.size());
+		for (size_t v = 0; v < localToGlobal.size(); ++v)
+			localPositions[v] = mesh.vertices[localToGlobal[v]].Position;
+
+		OptimizeVertexCache(local.data(), count, localToGlobal.size(), &hardClusters);
+		stats.clusterCount += OptimizeOverdraw(local.data(), count, localPositions.data(),
+			localToGlobal.size(), hardClusters);
+
+		for (size_t i = 0; i < count; ++i)
+			idx[i] = localToGlobal[local[i]];
+		for (UINT g : localToGlobal)
+			globalToLocal[g] = InvalidIndex;
+	}
+
+	OptimizeVertexFetch(mesh);
+	stats.vertexCount = mesh.vertices.size();
+
+	SimulateSubsets(mesh, misses, referenced);
+	stats.acmrAfter = stats.triangleCount ? (float)misses / (float)stats.triangleCount : 0.f;
+	stats.atvrAfter = referenced ? (float)misses / (float)referenced : 0.f;
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+float MeshOptimizer::ComputeAcmr(const ObjMesh& mesh)
+{
+	size_t misses = 0;
+	size_t referenced = 0;
+	SimulateSubsets(mesh, misses, referenced);
+	const size_t triCount = mesh.indices.size() / 3;
+	return triCount ? (float)misses / (float)triCount : 0.f;
+}
+
+float MeshOptimizer::ComputeAcmr(const UINT* indices, size_t indexCount, size_t vertexCount)
+{
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0 || vertexCount == 0)
+		return 0.f;
+	FifoCache cache(vertexCount);
+	size_t misses = 0;
+	for (size_t t = 0; t < triCount; ++t)
+		misses += TriangleMisses(cache, indices + t * 3);
+	return (float)misses / (float)triCount;
+}
+
+std::string MeshOptimizer::Format(const Stats& s)
+{
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[MeshOpt] triangles=%zu vertices=%zu ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, clusters=%zu, %.1f ms\n",
+		s.triangleCount,
+		s.vertexCount,
+		s.acmrBefore,
+		s.acmrAfter,
+		s.atvrBefore,
+		s.atvrAfter,
+		s.clusterCount,
+		s.milliseconds);
+	return buf;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "ObjLoader.h"
+#include <string>
+// Index/vertex reordering for the GPU. Every pass works per MeshSubset, so
+// subset ranges and materials are left untouched.
+class MeshOptimizer
+{
+public:
+	// FIFO size used both for Tipsify and for ACMR simulation.
+	static constexpr unsigned CacheSize = 16;
+	// Soft cluster boundaries are allowed while the running ACMR stays
+	// within this factor of the hard cluster's ACMR.
+	static constexpr float OverdrawThreshold = 1.05f;
+
+	struct Stats
+	{
+		size_t triangleCount = 0;
+		size_t vertexCount = 0; // after per-subset partitioning
+		float acmrBefore = 0.f; // post-transform cache misses per triangle
+		float acmrAfter = 0.f;
+		float atvrBefore = 0.f; // cache misses per unique vertex
+		float atvrAfter = 0.f;
+		size_t clusterCount = 0;
+		double milliseconds = 0.0;
+	};
+
+	// Tipsify + overdraw cluster sort per subset, then vertex-fetch reorder.
+	static Stats Optimize(ObjMesh& mesh);
+
+	// Reorders triangles of one index range for the post-transform cache
+	// (Sander et al., Tipsify). clusterStarts receives the first triangle
+	// of every hard boundary (cache flush) in the new order.
+	static void OptimizeVertexCache(UINT* indices, size_t indexCount, size_t vertexCount,
+		std::vector<UINT>* clusterStarts = nullptr);
+	// Sorts the clusters of a Tipsify-ordered range so outward-facing
+	// clusters are drawn first. Returns the number of clusters drawn.
+	static size_t OptimizeOverdraw(UINT* indices, size_t indexCount,
+		const XMFLOAT3* positions, size_t vertexCount, const std::vector<UINT>& hardClusters);
+	// Renumbers vertices in first-use order per subset and drops unused ones.
+	// Vertices shared between subsets are duplicated, so every subset owns
+	// the contiguous range [vertexStart, vertexStart + vertexCount).
+	static void OptimizeVertexFetch(ObjMesh& mesh);
+
+	// Subsets are drawn separately, so the cache is flushed at every subset.
+	static float ComputeAcmr(const ObjMesh& mesh);
+	static float ComputeAcmr(const UINT* indices, size_t indexCount, size_t vertexCount);
+	static std::string Format(const Stats& s);
+};
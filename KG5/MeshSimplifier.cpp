@@ -0,0 +1,416 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// -------------------------------------------------------
+// Quadrics
+// -------------------------------------------------------
+// Sum of area-weighted squared plane distances; Evaluate() divides by the
+// total weight, so sqrt(Evaluate) is an RMS distance in object units.
+struct Quadric
+{
+	double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+	double b0 = 0, b1 = 0, b2 = 0;
+	double c = 0;
+	double w = 0;
+};
+
+struct Vec3d
+{
+	double x, y, z;
+};
+
+static void AddPlane(Quadric& q, const Vec3d& n, double d, double weight)
+{
+	q.a00 += weight * n.x * n.x;
+	q.a11 += weight * n.y * n.y;
+	q.a22 += weight * n.z * n.z;
+	q.a01 += weight * n.x * n.y;
+	q.a02 += weight * n.x * n.z;
+	q.a12 += weight * n.y * n.z;
+	q.b0 += weight * n.x * d;
+	q.b1 += weight * n.y * d;
+	q.b2 += weight * n.z * d;
+	q.c += weight * d * d;
+	q.w += weight;
+}
+
+static void AddQuadric(Quadric& q, const Quadric& o)
+{
+	q.a00 += o.a00; q.a11 += o.a11; q.a22 += o.a22;
+	q.a01 += o.a01; q.a02 += o.a02; q.a12 += o.a12;
+	q.b0 += o.b0; q.b1 += o.b1; q.b2 += o.b2;
+	q.c += o.c;
+	q.w += o.w;
+}
+
+static double Evaluate(const Quadric& q, const Vec3d& p)
+{
+	const double r =
+		q.a00 * p.x * p.x + q.a11 * p.y * p.y + q.a22 * p.z * p.z +
+		2.0 * (q.a01 * p.x * p.y + q.a02 * p.x * p.z + q.a12 * p.y * p.z) +
+		2.0 * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+	return (q.w > 0.0) ? std::max(r, 0.0) / q.w : 0.0;
+}
+
+static Vec3d Cross(const Vec3d& a, const Vec3d& b, const Vec3d& c)
+{
+	const double e1x = b.x - a.x, e1y = b.y - a.y, e1z = b.z - a.z;
+	const double e2x = c.x - a.x, e2y = c.y - a.y, e2z = c.z - a.z;
+	return Vec3d{ e1y * e2z - e1z * e2y, e1z * e2x - e1x * e2z, e1x * e2y - e1y * e2x };
+}
+
+// -------------------------------------------------------
+// Edge collapse on one subset (local vertex space)
+// -------------------------------------------------------
+class SubsetSimplifier
+{
+public:
+	SubsetSimplifier(const ObjMesh& mesh, const MeshSubset& s)
+		: m_positions(s.vertexCount), m_quadrics(s.vertexCount), m_locked(s.vertexCount, 0), m_remap(s.vertexCount)
+	{
+		const size_t count = s.indexCount - s.indexCount % 3;
+		m_indices.resize(count);
+		for (size_t i = 0; i < count; ++i)
+			m_indices[i] = mesh.indices[s.indexStart + i] - s.vertexStart;
+
+		// Positions relative to the AABB centre keep the quadrics well conditioned
+		XMFLOAT3 mn = mesh.vertices[s.vertexStart].Position;
+		XMFLOAT3 mx = mn;
+		for (UINT v = 0; v < s.vertexCount; ++v)
+		{
+			const XMFLOAT3& p = mesh.vertices[s.vertexStart + v].Position;
+			mn.x = std::min(mn.x, p.x); mn.y = std::min(mn.y, p.y); mn.z = std::min(mn.z, p.z);
+			mx.x = std::max(mx.x, p.x); mx.y = std::max(mx.y, p.y); mx.z = std::max(mx.z, p.z);
+		}
+		const double cx = 0.5 * ((double)mn.x + mx.x), cy = 0.5 * ((double)mn.y + mx.y), cz = 0.5 * ((double)mn.z + mx.z);
+		for (UINT v = 0; v < s.vertexCount; ++v)
+		{
+			const XMFLOAT3& p = mesh.vertices[s.vertexStart + v].Position;
+			m_positions[v] = Vec3d{ p.x - cx, p.y - cy, p.z - cz };
+			m_remap[v] = v;
+		}
+		const double dx = (double)mx.x - mn.x, dy = (double)mx.y - mn.y, dz = (double)mx.z - mn.z;
+		m_diagonal = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+		for (size_t i = 0; i < m_indices.size(); i += 3)
+		{
+			const UINT* tri = m_indices.data() + i;
+			Vec3d n = Cross(m_positions[tri[0]], m_positions[tri[1]], m_positions[tri[2]]);
+			const double len = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+			if (len <= 0.0)
+				continue;
+			n.x /= len; n.y /= len; n.z /= len;
+			const Vec3d& p0 = m_positions[tri[0]];
+			const double d = -(n.x * p0.x + n.y * p0.y + n.z * p0.z);
+			for (int c = 0; c < 3; ++c)
+				AddPlane(m_quadrics[tri[c]], n, d, 0.5 * len);
+		}
+		LockSeams();
+	}
+
+	double Diagonal() const { return m_diagonal; }
+	size_t TriangleCount() const { return m_indices.size() / 3; }
+	const std::vector<UINT>& Indices() const { return m_indices; }
+	float Error() const { return (float)std::sqrt(m_errorSq); }
+
+	// Collapses edges until targetTriangles is reached, the cheapest
+	// remaining collapse costs more than maxError, or nothing is legal.
+	void Simplify(size_t targetTriangles, double maxError)
+	{
+		const double maxErrorSq = maxError * maxError;
+		while (TriangleCount() > targetTriangles)
+		{
+			if (CollapsePass(TriangleCount() - targetTriangles, maxErrorSq) == 0)
+				break;
+		}
+	}
+
+private:
+	struct Collapse
+	{
+		UINT from;
+		UINT to;
+		double cost;
+	};
+
+	void BuildAdjacency()
+	{
+		const size_t vertexCount = m_positions.size();
+		m_adjOffsets.assign(vertexCount + 1, 0);
+		for (UINT v : m_indices)
+			++m_adjOffsets[v + 1];
+		for (size_t v = 0; v < vertexCount; ++v)
+			m_adjOffsets[v + 1] += m_adjOffsets[v];
+		m_adjTriangles.resize(m_indices.size());
+		std::vector<UINT> cursor(m_adjOffsets.begin(), m_adjOffsets.end() - 1);
+		for (size_t i = 0; i < m_indices.size(); ++i)
+			m_adjTriangles[cursor[m_indices[i]]++] = (UINT)(i / 3);
+	}
+
+	bool HasDirectedEdge(UINT a, UINT b) const
+	{
+		for (UINT k = m_adjOffsets[a]; k < m_adjOffsets[a + 1]; ++k)
+		{
+			const UINT* tri = m_indices.data() + m_adjTriangles[k] * 3;
+			for (int c = 0; c < 3; ++c)
+				if (tri[c] == a && tri[(c + 1) % 3] == b)
+					return true;
+		}
+		return false;
+	}
+
+	// Open edges (subset/material boundaries, mesh borders) and vertices that
+	// share a position with another vertex (UV or normal seams) never move.
+	void LockSeams()
+	{
+		BuildAdjacency();
+		for (size_t i = 0; i < m_indices.size(); i += 3)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const UINT a = m_indices[i + c];
+				const UINT b = m_indices[i + (c + 1) % 3];
+				if (!HasDirectedEdge(b, a))
+					m_locked[a] = m_locked[b] = 1;
+			}
+		}
+
+		std::vector<UINT> order(m_positions.size());
+		for (UINT v = 0; v < (UINT)order.size(); ++v)
+			order[v] = v;
+		auto less = [&](UINT a, UINT b)
+		{
+			const Vec3d& p = m_positions[a];
+			const Vec3d& q = m_positions[b];
+			if (p.x != q.x) return p.x < q.x;
+			if (p.y != q.y) return p.y < q.y;
+			return p.z < q.z;
+		};
+		std::sort(order.begin(), order.end(), less);
+		for (size_t i = 1; i < order.size(); ++i)
+		{
+			if (!less(order[i - 1], order[i]))
+				m_locked[order[i - 1]] = m_locked[order[i]] = 1;
+		}
+	}
+
+	// Rejects a collapse that would flip any remaining triangle around 'from'.
+	bool PreservesOrientation(UINT from, UINT to) const
+	{
+		for (UINT k = m_adjOffsets[from]; k < m_adjOffsets[from + 1]; ++k)
+		{
+			const UINT* tri = m_indices.data() + m_adjTriangles[k] * 3;
+			if (tri[0] == to || tri[1] == to || tri[2] == to)
+				continue;
+			Vec3d p[3];
+			for (int c = 0; c < 3; ++c)
+				p[c] = m_positions[tri[c]];
+			const Vec3d before = Cross(p[0], p[1], p[2]);
+			for (int c = 0; c < 3; ++c)
+				if (tri[c] == from) p[c] = m_positions[to];
+			const Vec3d after = Cross(p[0], p[1], p[2]);
+			if (before.x * after.x + before.y * after.y + before.z * after.z <= 0.0)
+				return false;
+		}
+		return true;
+	}
+
+	size_t CollapsePass(size_t trianglesToRemove, double maxErrorSq)
+	{
+		BuildAdjacency();
+
+		// Every interior edge is seen once, from the triangle where it runs low -> high
+		m_collapses.clear();
+		for (size_t i = 0; i < m_indices.size(); i += 3)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const UINT a = m_indices[i + c];
+				const UINT b = m_indices[i + (c + 1) % 3];
+				if (a > b || (m_locked[a] && m_locked[b]))
+					continue;
+				Quadric q = m_quadrics[a];
+				AddQuadric(q, m_quadrics[b]);
+				const double costAB = m_locked[a] ? HUGE_VAL : Evaluate(q, m_positions[b]);
+				const double costBA = m_locked[b] ? HUGE_VAL : Evaluate(q, m_positions[a]);
+				if (costAB <= costBA)
+					m_collapses.push_back(Collapse{ a, b, costAB });
+				else
+					m_collapses.push_back(Collapse{ b, a, costBA });
+			}
+		}
+		std::sort(m_collapses.begin(), m_collapses.end(),
+			[](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		// A collapse freezes the whole 1-ring of 'from' for the rest of the
+		// pass, so the orientation checks always see current triangles.
+		m_dirty.assign(m_positions.size(), 0);
+		size_t collapsed = 0;
+		size_t removed = 0;
+		for (const Collapse& e : m_collapses)
+		{
+			if (removed >= trianglesToRemove || e.cost > maxErrorSq)
+				break;
+			if (m_dirty[e.from] || m_dirty[e.to] || !PreservesOrientation(e.from, e.to))
+				continue;
+
+			for (UINT k = m_adjOffsets[e.from]; k < m_adjOffsets[e.from + 1]; ++k)
+			{
+				const UINT* tri = m_indices.data() + m_adjTriangles[k] * 3;
+				bool hasTo = false;
+				for (int c = 0; c < 3; ++c)
+				{
+					m_dirty[tri[c]] = 1;
+					hasTo = hasTo || tri[c] == e.to;
+				}
+				removed += hasTo ? 1 : 0;
+			}
+			m_remap[e.from] = e.to;
+			AddQuadric(m_quadrics[e.to], m_quadrics[e.from]);
+			m_errorSq = std::max(m_errorSq, e.cost);
+			++collapsed;
+		}
+		if (collapsed == 0)
+			return 0;
+
+		size_t out = 0;
+		for (size_t i = 0; i < m_indices.size(); i += 3)
+		{
+			UINT tri[3];
+			for (int c = 0; c < 3; ++c)
+			{
+				UINT v = m_indices[i + c];
+				while (m_remap[v] != v)
+					v = m_remap[v];
+				tri[c] = v;
+			}
+			if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+				continue;
+			m_indices[out++] = tri[0];
+			m_indices[out++] = tri[1];
+			m_indices[out++] = tri[2];
+		}
+		m_indices.resize(out);
+		return collapsed;
+	}
+
+	std::vector<Vec3d> m_positions;
+	std::vector<Quadric> m_quadrics;
+	std::vector<char> m_locked;
+	std::vector<UINT> m_remap;
+	std::vector<UINT> m_indices;
+	std::vector<UINT> m_adjOffsets;
+	std::vector<UINT> m_adjTriangles;
+	std::vector<Collapse> m_collapses;
+	std::vector<char> m_dirty;
+	double m_diagonal = 0.0;
+	double m_errorSq = 0.0;
+};
+
+// -------------------------------------------------------
+// LOD chain
+// -------------------------------------------------------
+MeshSimplifier::Stats MeshSimplifier::BuildLods(ObjMesh& mesh)
+{
+	Stats stats;
+	const auto start = std::chrono::steady_clock::now();
+	stats.subsetCount = mesh.subsets.size();
+
+	// Drop the LODs of a previous run
+	size_t baseIndexCount = 0;
+	for (const MeshSubset& s : mesh.subsets)
+		baseIndexCount = std::max(baseIndexCount, (size_t)s.indexStart + s.indexCount);
+	mesh.indices.resize(std::min(mesh.indices.size(), baseIndexCount));
+	mesh.lods.clear();
+
+	std::vector<UINT> lodIndices;
+	for (size_t si = 0; si < mesh.subsets.size(); ++si)
+	{
+		MeshSubset& s = mesh.subsets[si];
+		s.lodStart = (UINT)mesh.lods.size();
+		s.lodCount = 0;
+		size_t triangles = s.indexCount / 3;
+		stats.triangles[0] += triangles;
+		if (triangles >= MinTriangles && s.vertexCount > 0 &&
+			(size_t)s.vertexStart + s.vertexCount <= mesh.vertices.size() &&
+			(size_t)s.indexStart + s.indexCount <= baseIndexCount)
+		{
+			// Each level continues collapsing where the previous one stopped
+			SubsetSimplifier simplifier(mesh, s);
+			const double maxError = MaxRelativeError * simplifier.Diagonal();
+			for (UINT level = 1; level <= MaxLods; ++level)
+			{
+				simplifier.Simplify((size_t)((float)triangles * LodRatio), maxError);
+				// Not worth another draw range below a 20% reduction
+				if ((float)simplifier.TriangleCount() > (float)triangles * 0.8f)
+					break;
+
+				lodIndices = simplifier.Indices();
+				MeshOptimizer::OptimizeVertexCache(lodIndices.data(), lodIndices.size(), s.vertexCount);
+				MeshLod lod;
+				lod.indexStart = (UINT)mesh.indices.size();
+				lod.indexCount = (UINT)lodIndices.size();
+				lod.error = simplifier.Error();
+				lod.subset = (UINT)si;
+				for (UINT v : lodIndices)
+					mesh.indices.push_back(v + s.vertexStart);
+				mesh.lods.push_back(lod);
+				++s.lodCount;
+
+				triangles = simplifier.TriangleCount();
+				stats.maxError[level] = std::max(stats.maxError[level], lod.error);
+			}
+		}
+		for (UINT level = 1; level <= MaxLods; ++level)
+		{
+			const UINT used = std::min(level, s.lodCount);
+			stats.triangles[level] += used ? mesh.lods[s.lodStart + used - 1].indexCount / 3 : s.indexCount / 3;
+		}
+		stats.subsetsWithLods += (s.lodCount > 0) ? 1 : 0;
+	}
+	stats.lodCount = mesh.lods.size();
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+UINT MeshSimplifier::SelectLod(const MeshSubset& s, const std::vector<MeshLod>& lods, float worldScale,
+	float distance, float pixelsPerUnit, float maxPixelError)
+{
+	if (s.lodCount == 0 || (size_t)s.lodStart + s.lodCount > lods.size())
+		return 0;
+	// Camera inside the bounds
+	if (distance <= 0.f || pixelsPerUnit <= 0.f || worldScale <= 0.f)
+		return 0;
+	// error * worldScale * pixelsPerUnit / distance <= maxPixelError
+	const float allowedError = maxPixelError * distance / (pixelsPerUnit * worldScale);
+	UINT level = 0;
+	while (level < s.lodCount && lods[s.lodStart + level].error <= allowedError)
+		++level;
+	return level;
+}
+
+std::string MeshSimplifier::Format(const Stats& s)
+{
+	char buf[384];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[MeshLod] %zu/%zu subsets simplified, %zu LODs, triangles %zu -> %zu -> %zu -> %zu, "
+		"max error %.4f / %.4f / %.4f, %.1f ms\n",
+		s.subsetsWithLods,
+		s.subsetCount,
+		s.lodCount,
+		s.triangles[0],
+		s.triangles[1],
+		s.triangles[2],
+		s.triangles[3],
+		s.maxError[1],
+		s.maxError[2],
+		s.maxError[3],
+		s.milliseconds);
+	return buf;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "ObjLoader.h"
+#include <string>
+// Quadric error metric simplification (Garland & Heckbert) for LOD chains.
+// Edges collapse onto one of their existing endpoints, so a LOD is only a new
+// index list over the subset's vertex range: attributes are never
+// interpolated and the vertex buffer is shared by every level.
+// Vertices on an open edge (material seams between subsets, mesh borders)
+// and vertices split by a UV/normal seam are locked.
+class MeshSimplifier
+{
+public:
+	static constexpr UINT MaxLods = 3;            // levels 1..3, level 0 is the subset itself
+	static constexpr float LodRatio = 0.5f;       // triangles kept by each level
+	static constexpr UINT MinTriangles = 64;      // smaller subsets get no LODs
+	static constexpr float MaxRelativeError = 0.02f; // of the subset's AABB diagonal
+
+	struct Stats
+	{
+		size_t subsetCount = 0;
+		size_t subsetsWithLods = 0;
+		size_t lodCount = 0;
+		size_t triangles[MaxLods + 1] = {}; // per level, subsets without that level count their coarsest one
+		float maxError[MaxLods + 1] = {};
+		double milliseconds = 0.0;
+	};
+
+	// Appends every LOD's indices to mesh.indices (after all subset ranges)
+	// and fills mesh.lods and MeshSubset::lodStart/lodCount. Needs the vertex
+	// ranges from MeshOptimizer::OptimizeVertexFetch; LOD triangles are
+	// reordered with MeshOptimizer::OptimizeVertexCache.
+	static Stats BuildLods(ObjMesh& mesh);
+
+	// Coarsest level whose error, scaled by worldScale and projected at
+	// 'distance', stays within maxPixelError. pixelsPerUnit is the projected
+	// size of one unit at distance 1: viewportHeight / (2 * tan(fovY / 2)).
+	// Returns 0 (full detail) .. s.lodCount.
+	static UINT SelectLod(const MeshSubset& s, const std::vector<MeshLod>& lods, float worldScale,
+		float distance, float pixelsPerUnit, float maxPixelError);
+
+	static std::string Format(const Stats& s);
+};
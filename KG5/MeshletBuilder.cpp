@@ -0,0 +1,211 @@
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const UINT InvalidIndex = 0xFFFFFFFFu;
+
+static XMFLOAT3 TriangleNormal(const ObjMesh& mesh, const UINT* tri, float& length)
+{
+	const XMFLOAT3& p0 = mesh.vertices[tri[0]].Position;
+	const XMFLOAT3& p1 = mesh.vertices[tri[1]].Position;
+	const XMFLOAT3& p2 = mesh.vertices[tri[2]].Position;
+	const float e1x = p1.x - p0.x, e1y = p1.y - p0.y, e1z = p1.z - p0.z;
+	const float e2x = p2.x - p0.x, e2y = p2.y - p0.y, e2z = p2.z - p0.z;
+	XMFLOAT3 n(e1y * e2z - e1z * e2y, e1z * e2x - e1x * e2z, e1x * e2y - e1y * e2x);
+	length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+	if (length > 0.f)
+	{
+		n.x /= length;
+		n.y /= length;
+		n.z /= length;
+	}
+	return n;
+}
+
+void MeshletBuilder::ComputeBounds(const ObjMesh& mesh, Meshlet& m)
+{
+	const UINT* idx = mesh.indices.data() + m.indexStart;
+
+	// Sphere around the AABB centre
+	XMFLOAT3 mn = mesh.vertices[idx[0]].Position;
+	XMFLOAT3 mx = mn;
+	for (UINT i = 1; i < m.indexCount; ++i)
+	{
+		const XMFLOAT3& p = mesh.vertices[idx[i]].Position;
+		mn.x = std::min(mn.x, p.x); mn.y = std::min(mn.y, p.y); mn.z = std::min(mn.z, p.z);
+		mx.x = std::max(mx.x, p.x); mx.y = std::max(mx.y, p.y); mx.z = std::max(mx.z, p.z);
+	}
+	m.center = XMFLOAT3((mn.x + mx.x) * 0.5f, (mn.y + mx.y) * 0.5f, (mn.z + mx.z) * 0.5f);
+	float radiusSq = 0.f;
+	for (UINT i = 0; i < m.indexCount; ++i)
+	{
+		const XMFLOAT3& p = mesh.vertices[idx[i]].Position;
+		const float dx = p.x - m.center.x, dy = p.y - m.center.y, dz = p.z - m.center.z;
+		radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+	}
+	m.radius = std::sqrt(radiusSq);
+
+	// Normal cone: axis = mean face normal, half-angle from the widest normal
+	XMFLOAT3 axis(0.f, 0.f, 0.f);
+	for (UINT i = 0; i + 2 < m.indexCount; i += 3)
+	{
+		float len = 0.f;
+		const XMFLOAT3 n = TriangleNormal(mesh, idx + i, len);
+		axis.x += n.x;
+		axis.y += n.y;
+		axis.z += n.z;
+	}
+	const float axisLen = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+	m.coneAxis = (axisLen > 0.f) ? XMFLOAT3(axis.x / axisLen, axis.y / axisLen, axis.z / axisLen) : XMFLOAT3(0.f, 0.f, 1.f);
+	m.coneApex = m.center;
+	m.coneCutoff = 1.f;
+	if (axisLen <= 0.f)
+		return;
+
+	float minDot = 1.f;
+	for (UINT i = 0; i + 2 < m.indexCount; i += 3)
+	{
+		float len = 0.f;
+		const XMFLOAT3 n = TriangleNormal(mesh, idx + i, len);
+		if (len > 0.f)
+			minDot = std::min(minDot, n.x * m.coneAxis.x + n.y * m.coneAxis.y + n.z * m.coneAxis.z);
+	}
+	// Wider than ~84 degrees: the test would almost never pass
+	if (minDot <= 0.1f)
+		return;
+
+	// Move the apex back along the axis until it lies behind every triangle plane
+	float maxT = 0.f;
+	for (UINT i = 0; i + 2 < m.indexCount; i += 3)
+	{
+		float len = 0.f;
+		const XMFLOAT3 n = TriangleNormal(mesh, idx + i, len);
+		if (len <= 0.f) continue;
+		const XMFLOAT3& p0 = mesh.vertices[idx[i]].Position;
+		const float dc = (m.center.x - p0.x) * n.x + (m.center.y - p0.y) * n.y + (m.center.z - p0.z) * n.z;
+		const float dn = m.coneAxis.x * n.x + m.coneAxis.y * n.y + m.coneAxis.z * n.z;
+		maxT = std::max(maxT, dc / dn);
+	}
+	m.coneApex = XMFLOAT3(m.center.x - m.coneAxis.x * maxT, m.center.y - m.coneAxis.y * maxT, m.center.z - m.coneAxis.z * maxT);
+	m.coneCutoff = std::sqrt(1.f - minDot * minDot);
+}
+
+size_t MeshletBuilder::Build(ObjMesh& mesh)
+{
+	mesh.meshlets.clear();
+	std::vector<UINT> owner(mesh.vertices.size(), InvalidIndex);
+	UINT meshletId = 0;
+
+	for (size_t si = 0; si < mesh.subsets.size(); ++si)
+	{
+		MeshSubset& s = mesh.subsets[si];
+		s.meshletStart = (UINT)mesh.meshlets.size();
+		const UINT end = s.indexStart + s.indexCount - s.indexCount % 3;
+
+		Meshlet current{};
+		current.indexStart = s.indexStart;
+		current.subset = (UINT)si;
+		XMFLOAT3 normalSum(0.f, 0.f, 0.f);
+		auto flush = [&](UINT indexEnd)
+		{
+			current.indexCount = indexEnd - current.indexStart;
+			if (current.indexCount == 0) return;
+			ComputeBounds(mesh, current);
+			mesh.meshlets.push_back(current);
+			current = Meshlet{};
+			current.indexStart = indexEnd;
+			current.subset = (UINT)si;
+			normalSum = XMFLOAT3(0.f, 0.f, 0.f);
+			++meshletId;
+		};
+
+		for (UINT i = s.indexStart; i < end; i += 3)
+		{
+			const UINT* tri = mesh.indices.data() + i;
+			UINT newVertices = 0;
+			for (int c = 0; c < 3; ++c)
+			{
+				const bool repeat = (c > 0 && tri[c] == tri[0]) || (c > 1 && tri[c] == tri[1]);
+				if (owner[tri[c]] != meshletId && !repeat) ++newVertices;
+			}
+			float len = 0.f;
+			const XMFLOAT3 n = TriangleNormal(mesh, tri, len);
+
+			const UINT triangles = (i - current.indexStart) / 3;
+			bool split = triangles >= MaxTriangles || current.vertexCount + newVertices > MaxVertices;
+			if (!split && triangles >= MinConeTriangles && len > 0.f)
+			{
+				const float sumLen = std::sqrt(normalSum.x * normalSum.x + normalSum.y * normalSum.y + normalSum.z * normalSum.z);
+				if (sumLen > 0.f &&
+					(n.x * normalSum.x + n.y * normalSum.y + n.z * normalSum.z) < ConeSplitDot * sumLen)
+					split = true;
+			}
+			if (split)
+			{
+				flush(i);
+				newVertices = 0;
+				for (int c = 0; c < 3; ++c)
+				{
+					const bool repeat = (c > 0 && tri[c] == tri[0]) || (c > 1 && tri[c] == tri[1]);
+					if (!repeat) ++newVertices;
+				}
+			}
+
+			for (int c = 0; c < 3; ++c)
+				owner[tri[c]] = meshletId;
+			current.vertexCount += newVertices;
+			normalSum.x += n.x;
+			normalSum.y += n.y;
+			normalSum.z += n.z;
+		}
+		flush(end);
+		s.meshletCount = (UINT)mesh.meshlets.size() - s.meshletStart;
+	}
+	return mesh.meshlets.size();
+}
+
+bool MeshletBuilder::IsVisible(const Meshlet& m, const XMFLOAT4* planes, size_t planeCount,
+	const XMFLOAT3& eye, float margin, bool cullBackfacing)
+{
+	const float radius = m.radius + margin;
+	for (size_t i = 0; i < planeCount; ++i)
+	{
+		const XMFLOAT4& p = planes[i];
+		if (p.x * m.center.x + p.y * m.center.y + p.z * m.center.z + p.w < -radius)
+			return false;
+	}
+	if (cullBackfacing && m.coneCutoff < 1.f)
+	{
+		const float vx = m.coneApex.x - eye.x, vy = m.coneApex.y - eye.y, vz = m.coneApex.z - eye.z;
+		const float len = std::sqrt(vx * vx + vy * vy + vz * vz);
+		if (len > 0.f && (vx * m.coneAxis.x + vy * m.coneAxis.y + vz * m.coneAxis.z) >= m.coneCutoff * len)
+			return false;
+	}
+	return true;
+}
+
+std::string MeshletBuilder::Format(const ObjMesh& mesh)
+{
+	size_t vertices = 0;
+	size_t triangles = 0;
+	size_t cones = 0;
+	for (const Meshlet& m : mesh.meshlets)
+	{
+		vertices += m.vertexCount;
+		triangles += m.indexCount / 3;
+		cones += (m.coneCutoff < 1.f) ? 1 : 0;
+	}
+	const double count = mesh.meshlets.empty() ? 1.0 : (double)mesh.meshlets.size();
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[Meshlets] %zu meshlets, avg %.1f vertices / %.1f triangles, usable cones %zu (%.0f%%)\n",
+		mesh.meshlets.size(),
+		(double)vertices / count,
+		(double)triangles / count,
+		cones,
+		100.0 * (double)cones / count);
+	return buf;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "ObjLoader.h"
+#include <string>
+// Splits every MeshSubset into meshlets: contiguous runs of its (already
+// cache-optimized) triangles with at most MaxVertices unique vertices and
+// MaxTriangles triangles. Triangles are not reordered, so a meshlet is also
+// a plain DrawIndexedInstanced range and visible neighbours can be merged.
+class MeshletBuilder
+{
+public:
+	static constexpr UINT MaxVertices = 64;
+	static constexpr UINT MaxTriangles = 124;
+	// A meshlet is also closed early once it has MinConeTriangles and the next
+	// triangle deviates from its average normal by more than ~60 degrees, so
+	// the normal cones stay usable for backface culling.
+	static constexpr UINT MinConeTriangles = 16;
+	static constexpr float ConeSplitDot = 0.5f;
+
+	// Fills mesh.meshlets and MeshSubset::meshletStart/meshletCount.
+	static size_t Build(ObjMesh& mesh);
+	static void ComputeBounds(const ObjMesh& mesh, Meshlet& m);
+
+	// Frustum test against 'planeCount' inward-facing normalized planes with
+	// the sphere grown by 'margin', plus the normal-cone backface test.
+	static bool IsVisible(const Meshlet& m, const XMFLOAT4* planes, size_t planeCount,
+		const XMFLOAT3& eye, float margin, bool cullBackfacing);
+
+	static std::string Format(const ObjMesh& mesh);
+};
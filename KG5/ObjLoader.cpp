@@ -1,11 +1,17 @@
 #include "ObjLoader.h"
+#include "MappedFile.h"
+#include "TangentBuilder.h"
 #include <fstream>
 #include <sstream>
-#include <map>
-#include <tuple>
 #include <algorithm>
 #include <cmath>
 #include <cctype>
+#include <cfloat>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
 // -------------------------------------------------------
 // String helpers
 // -------------------------------------------------------
@@ -26,6 +32,157 @@ static int ResolveIndex(int idx, int total)
 	return idx - 1;
 }
 // -------------------------------------------------------
+// Byte-level tokenizer for the mapped parser
+// -------------------------------------------------------
+static inline bool IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+static inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+static inline const char* SkipBlanks(const char* p, const char* end)
+{
+	while (p < end && IsBlank(*p)) ++p;
+	return p;
+}
+static inline const char* SkipWord(const char* p, const char* end)
+{
+	while (p < end && !IsBlank(*p) && *p != '\n') ++p;
+	return p;
+}
+static inline const char* SkipLine(const char* p, const char* end)
+{
+	const void* nl = std::memchr(p, '\n', (size_t)(end - p));
+	return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+static const char* ParseInt(const char* p, const char* end, int& out)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+	int value = 0;
+	while (p < end && IsDigit(*p))
+	{
+		value = value * 10 + (*p - '0');
+		++p;
+	}
+	out = negative ? -value : value;
+	return p;
+}
+// Decimal float parser. Accumulates the digits into an integer mantissa and
+// scales by an exact power of ten in double precision (Clinger's fast path),
+// which is correctly rounded. The double->float narrowing is only exact when
+// the double does not land on a float rounding midpoint, so those values (and
+// anything with too many digits or a large exponent) go to std::from_chars.
+static const char* ParseFloat(const char* p, const char* end, float& out)
+{
+	static const double kPow10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+	const char* numBegin = p;
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exp10 = 0;
+	bool truncated = false;
+	bool any = false;
+	while (p < end && IsDigit(*p))
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+			if (mantissa != 0) ++digits;
+		}
+		else
+		{
+			++exp10;
+			truncated = true;
+		}
+		any = true;
+		++p;
+	}
+	if (p < end && *p == '.')
+	{
+		++p;
+		while (p < end && IsDigit(*p))
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+				if (mantissa != 0) ++digits;
+				--exp10;
+			}
+			else
+			{
+				truncated = true;
+			}
+			any = true;
+			++p;
+		}
+	}
+	if (!any)
+	{
+		// Not a plain decimal (e.g. "inf"/"nan"); let the library decide.
+		float value = 0.f;
+		const std::from_chars_result r = std::from_chars(numBegin, end, value);
+		out = negative ? -value : value;
+		return (r.ec == std::errc()) ? r.ptr : numBegin;
+	}
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* e = p + 1;
+		bool expNegative = false;
+		if (e < end && (*e == '-' || *e == '+'))
+		{
+			expNegative = (*e == '-');
+			++e;
+		}
+		if (e < end && IsDigit(*e))
+		{
+			int expValue = 0;
+			while (e < end && IsDigit(*e))
+			{
+				if (expValue < 10000) expValue = expValue * 10 + (*e - '0');
+				++e;
+			}
+			exp10 += expNegative ? -expValue : expValue;
+			p = e;
+		}
+	}
+	if (!truncated && mantissa <= (1ull << 53) && exp10 >= -22 && exp10 <= 22)
+	{
+		const double d = (exp10 < 0)
+			? (double)mantissa / kPow10[-exp10]
+			: (double)mantissa * kPow10[exp10];
+		uint64_t bits = 0;
+		std::memcpy(&bits, &d, sizeof(bits));
+		const uint64_t lowBits = bits & ((1ull << 29) - 1);
+		const bool inFloatNormalRange = (d == 0.0) || (d >= 1.2e-38 && d <= 3.4e38);
+		if (inFloatNormalRange && lowBits != (1ull << 28))
+		{
+			const float value = (float)d;
+			out = negative ? -value : value;
+			return p;
+		}
+	}
+	float value = 0.f;
+	const std::from_chars_result r = std::from_chars(numBegin, end, value);
+	out = negative ? -value : value;
+	return (r.ec == std::errc()) ? r.ptr : p;
+}
+// -------------------------------------------------------
 // MTL loader
 // -------------------------------------------------------
 bool ObjLoader::LoadMtl(const std::string& mtlPath, std::vector<Material>& mats)
@@ -104,41 +261,588 @@ bool ObjLoader::LoadMtl(const std::string& mtlPath, std::vector<Material>& mats)
 	return true;
 }
 // -------------------------------------------------------
-// OBJ loader
+// Subset bounds
 // -------------------------------------------------------
-bool ObjLoader::Load(const std::string& path, ObjMesh& out)
+void ObjLoader::ComputeBounds(ObjMesh& mesh)
 {
-	std::ifstream f(path);
-	if (!f.is_open()) return false;
-	const std::string dir = DirOf(path);
+	for (MeshSubset& s : mesh.subsets)
+	{
+		const size_t first = s.indexStart;
+		const size_t last = (std::min)((size_t)s.indexStart + s.indexCount, mesh.indices.size());
+		XMFLOAT3 mn(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 mx(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (size_t i = first; i < last; ++i)
+		{
+			if (mesh.indices[i] >= mesh.vertices.size()) continue;
+			const XMFLOAT3& p = mesh.vertices[mesh.indices[i]].Position;
+			mn.x = (std::min)(mn.x, p.x); mn.y = (std::min)(mn.y, p.y); mn.z = (std::min)(mn.z, p.z);
+			mx.x = (std::max)(mx.x, p.x); mx.y = (std::max)(mx.y, p.y); mx.z = (std::max)(mx.z, p.z);
+		}
+		if (mn.x > mx.x)
+		{
+			s.boundsMin = s.boundsMax = s.boundsCenter = XMFLOAT3(0.f, 0.f, 0.f);
+			s.boundsRadius = 0.f;
+			continue;
+		}
+		s.boundsMin = mn;
+		s.boundsMax = mx;
+		s.boundsCenter = XMFLOAT3((mn.x + mx.x) * 0.5f, (mn.y + mx.y) * 0.5f, (mn.z + mx.z) * 0.5f);
+		float radiusSq = 0.f;
+		for (size_t i = first; i < last; ++i)
+		{
+			if (mesh.indices[i] >= mesh.vertices.size()) continue;
+			const XMFLOAT3& p = mesh.vertices[mesh.indices[i]].Position;
+			const float dx = p.x - s.boundsCenter.x, dy = p.y - s.boundsCenter.y, dz = p.z - s.boundsCenter.z;
+			radiusSq = (std::max)(radiusSq, dx * dx + dy * dy + dz * dz);
+		}
+		s.boundsRadius = std::sqrt(radiusSq);
+	}
+}
+// -------------------------------------------------------
+// Vertex welding map
+// -------------------------------------------------------
+// Open-addressing (linear probing) map from a resolved (pos, uv, normal)
+// index triple to the output vertex index. Slots are 16 bytes in one flat
+// array, so a lookup is a hash plus a short scan of adjacent cache lines
+// instead of a std::map node walk, and there is no per-entry allocation.
+class VertexWeldMap
+{
+public:
+	static constexpr UINT Empty = 0xFFFFFFFFu;
+	void Reserve(size_t count)
+	{
+		// Keep the load factor at or below 1/2
+		size_t capacity = 16;
+		while (capacity < count * 2) capacity <<= 1;
+		if (capacity > m_slots.size())
+			Rehash(capacity);
+	}
+	// Returns the existing value for the key, or inserts 'value' and
+	// returns Empty.
+	UINT FindOrInsert(int p, int t, int n, UINT value)
+	{
+		if ((m_count + 1) * 2 > m_slots.size())
+			Rehash((std::max)(m_slots.size() * 2, (size_t)16));
+		const size_t mask = m_slots.size() - 1;
+		for (size_t i = Hash(p, t, n) & mask;; i = (i + 1) & mask)
+		{
+			Slot& slot = m_slots[i];
+			if (slot.value == Empty)
+			{
+				slot = { p, t, n, value };
+				++m_count;
+				return Empty;
+			}
+			if (slot.p == p && slot.t == t && slot.n == n)
+				return slot.value;
+		}
+	}
+private:
+	struct Slot
+	{
+		int p = 0;
+		int t = 0;
+		int n = 0;
+		UINT value = Empty;
+	};
+	static size_t Hash(int p, int t, int n)
+	{
+		uint32_t h = (uint32_t)p * 0x9E3779B1u;
+		h ^= (uint32_t)t * 0x85EBCA77u + (h << 6) + (h >> 2);
+		h ^= (uint32_t)n * 0xC2B2AE3Du + (h << 6) + (h >> 2);
+		// murmur3 finalizer
+		h ^= h >> 16;
+		h *= 0x85EBCA6Bu;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35u;
+		h ^= h >> 16;
+		return h;
+	}
+	void Rehash(size_t capacity)
+	{
+		std::vector<Slot> old;
+		old.swap(m_slots);
+		m_slots.assign(capacity, Slot{});
+		const size_t mask = capacity - 1;
+		for (const Slot& slot : old)
+		{
+			if (slot.value == Empty) continue;
+			size_t i = Hash(slot.p, slot.t, slot.n) & mask;
+			while (m_slots[i].value != Empty) i = (i + 1) & mask;
+			m_slots[i] = slot;
+		}
+	}
+	std::vector<Slot> m_slots;
+	size_t m_count = 0;
+};
+// -------------------------------------------------------
+// Mesh assembly shared by both OBJ parsers
+// -------------------------------------------------------
+// Collects v/vt/vn arrays, welds face corners into output vertices and
+// tracks usemtl subsets. Both parsers feed it the same way, so they
+// produce identical ObjMesh output. 'tangents' = nullptr runs the original
+// scalar tangent loop (TangentBuilder::BuildReference). 'onSubset' is called
+// for every non-empty subset when it closes.
+class ObjMeshBuilder
+{
+public:
+	ObjMeshBuilder(ObjMesh& out, const TangentOptions* tangents, const ObjSubsetCallback* onSubset = nullptr)
+		: m_out(out), m_tangents(tangents), m_onSubset(onSubset)
+	{
+		// Open default subset
+		OpenSubset(-1);
+	}
 	std::vector<XMFLOAT3> positions;
 	std::vector<XMFLOAT3> normals;
 	std::vector<XMFLOAT2> uvs;
+	// Pre-size the weld map and vertex array for an expected vertex count
+	void ReserveVertices(size_t count)
+	{
+		m_vertexMap.Reserve(count);
+		m_out.vertices.reserve(count);
+	}
+	void UseMaterial(const std::string& matName)
+	{
+		int idx = -1;
+		for (int i = 0; i < (int)m_out.materials.size(); ++i)
+		{
+			if (m_out.materials[i].name == matName)
+			{
+				idx = i;
+				break;
+			}
+		}
+		if (idx != m_curMatIdx)
+			OpenSubset(idx);
+	}
+	// pi/ti/ni are raw OBJ indices (1-based, negative = relative, 0 = absent)
+	UINT AddCorner(int pi, int ti, int ni)
+	{
+		return AddCorner(pi, ti, ni, (int)positions.size(), (int)uvs.size(), (int)normals.size());
+	}
+	// Same, with the v/vt/vn counts as they were when the face was read.
+	// The parallel merge appends whole chunks of attributes up front.
+	UINT AddCorner(int pi, int ti, int ni, int posCount, int uvCount, int nrmCount)
+	{
+		int pIdx = ResolveIndex(pi, posCount);
+		int tIdx = (ti != 0) ? ResolveIndex(ti, uvCount) : -1;
+		int nIdx = (ni != 0) ? ResolveIndex(ni, nrmCount) : -1;
+		const UINT newIdx = (UINT)m_out.vertices.size();
+		const UINT existing = m_vertexMap.FindOrInsert(pIdx, tIdx, nIdx, newIdx);
+		if (existing != VertexWeldMap::Empty)
+			return existing;
+		ObjMesh::Vertex v;
+		v.Position = (pIdx >= 0 && pIdx < posCount)
+			? positions[pIdx] : XMFLOAT3(0, 0, 0);
+		v.TexCoord = (tIdx >= 0 && tIdx < uvCount)
+			? uvs[tIdx] : XMFLOAT2(0, 0);
+		v.Normal = (nIdx >= 0 && nIdx < nrmCount)
+			? normals[nIdx] : XMFLOAT3(0, 1, 0);
+		v.Tangent = XMFLOAT3(1, 0, 0);
+		v.Bitangent = XMFLOAT3(0, 0, 1);
+		m_out.vertices.push_back(v);
+		return newIdx;
+	}
+	void AddFace(const std::vector<UINT>& faceVerts)
+	{
+		// Triangulate (fan)
+		for (size_t i = 1; i + 1 < faceVerts.size(); ++i)
+		{
+			m_out.indices.push_back(faceVerts[0]);
+			m_out.indices.push_back(faceVerts[i]);
+			m_out.indices.push_back(faceVerts[i + 1]);
+		}
+	}
+	bool Finish()
+	{
+		// Close last subset
+		CloseSubset();
+
+		// Build tangents/bitangents from indexed triangles.
+		if (m_tangents)
+			TangentBuilder::Build(m_out, *m_tangents);
+		else
+			TangentBuilder::BuildReference(m_out);
+
+		// Remove empty subsets
+		std::vector<MeshSubset> nonEmpty;
+		for (size_t i = 0; i < m_out.subsets.size(); ++i)
+		{
+			if (m_out.subsets[i].indexCount > 0)
+				nonEmpty.push_back(m_out.subsets[i]);
+		}
+		m_out.subsets = nonEmpty;
+		ObjLoader::ComputeBounds(m_out);
+		return !m_out.vertices.empty();
+	}
+private:
+	// Close current subset and set its indexCount
+	void CloseSubset()
+	{
+		if (!m_out.subsets.empty())
+		{
+			MeshSubset& last = m_out.subsets.back();
+			last.indexCount = (UINT)m_out.indices.size() - last.indexStart;
+			if (m_onSubset && last.indexCount > 0)
+				EmitSubset(last);
+		}
+	}
+	void EmitSubset(const MeshSubset& s)
+	{
+		ObjMesh piece;
+		piece.indices.reserve(s.indexCount);
+		m_pieceRemap.resize(m_out.vertices.size(), VertexWeldMap::Empty);
+		for (UINT i = s.indexStart; i < s.indexStart + s.indexCount; ++i)
+		{
+			UINT& local = m_pieceRemap[m_out.indices[i]];
+			if (local == VertexWeldMap::Empty)
+			{
+				local = (UINT)piece.vertices.size();
+				piece.vertices.push_back(m_out.vertices[m_out.indices[i]]);
+			}
+			piece.indices.push_back(local);
+		}
+		for (UINT i = s.indexStart; i < s.indexStart + s.indexCount; ++i)
+			m_pieceRemap[m_out.indices[i]] = VertexWeldMap::Empty;
+
+		MeshSubset pieceSubset;
+		pieceSubset.indexCount = s.indexCount;
+		pieceSubset.materialIdx = s.materialIdx;
+		piece.subsets.push_back(pieceSubset);
+		TangentOptions pieceTangents;
+		pieceTangents.mikkTSpace = m_tangents && m_tangents->mikkTSpace;
+		TangentBuilder::Build(piece, pieceTangents);
+		ObjLoader::ComputeBounds(piece);
+		(*m_onSubset)(m_emittedSubsets++, piece, m_out.materials);
+	}
+	void OpenSubset(int matIdx)
+	{
+		CloseSubset();
+		MeshSubset s;
+		s.indexStart = (UINT)m_out.indices.size();
+		s.indexCount = 0;
+		s.materialIdx = matIdx;
+		m_out.subsets.push_back(s);
+		m_curMatIdx = matIdx;
+	}
+	ObjMesh& m_out;
+	const TangentOptions* m_tangents;
+	const ObjSubsetCallback* m_onSubset;
+	UINT m_emittedSubsets = 0;
+	// Global -> piece vertex index while a subset is emitted, Empty otherwise
+	std::vector<UINT> m_pieceRemap;
 	// Key: (posIdx, uvIdx, normIdx) -> output vertex index
-	std::map<std::tuple<int, int, int>, UINT> vertexMap;
-	int curMatIdx = -1;
-	// Helper: close current subset and set its indexCount
-	auto CloseSubset = [&]()
+	VertexWeldMap m_vertexMap;
+	int m_curMatIdx = -1;
+};
+// -------------------------------------------------------
+// OBJ loader (memory-mapped)
+// -------------------------------------------------------
+// Walks [p, end) line by line and reports records to the sink. The range
+// must start at a line boundary.
+template <typename Sink>
+static void ParseObjRange(const char* p, const char* const end, Sink& sink)
+{
+	std::vector<int> corners;
+	while (p < end)
+	{
+		p = SkipBlanks(p, end);
+		const char* word = p;
+		p = SkipWord(p, end);
+		const size_t wordLen = (size_t)(p - word);
+		if (wordLen == 1 && word[0] == 'v')
+		{
+			XMFLOAT3 v = {};
+			p = ParseFloat(SkipBlanks(p, end), end, v.x);
+			p = ParseFloat(SkipBlanks(p, end), end, v.y);
+			p = ParseFloat(SkipBlanks(p, end), end, v.z);
+			sink.Position(v);
+		}
+		else if (wordLen == 2 && word[0] == 'v' && word[1] == 'n')
+		{
+			XMFLOAT3 n = {};
+			p = ParseFloat(SkipBlanks(p, end), end, n.x);
+			p = ParseFloat(SkipBlanks(p, end), end, n.y);
+			p = ParseFloat(SkipBlanks(p, end), end, n.z);
+			sink.Normal(n);
+		}
+		else if (wordLen == 2 && word[0] == 'v' && word[1] == 't')
+		{
+			XMFLOAT2 uv = {};
+			p = ParseFloat(SkipBlanks(p, end), end, uv.x);
+			p = ParseFloat(SkipBlanks(p, end), end, uv.y);
+			uv.y = 1.f - uv.y; // flip Y
+			sink.TexCoord(uv);
+		}
+		else if (wordLen == 1 && word[0] == 'f')
+		{
+			// Raw (pos, uv, normal) index triples
+			corners.clear();
+			for (;;)
+			{
+				p = SkipBlanks(p, end);
+				if (p >= end || *p == '\n' || *p == '#') break;
+				// v, v/vt, v//vn or v/vt/vn
+				int pi = 0, ti = 0, ni = 0;
+				p = ParseInt(p, end, pi);
+				if (p < end && *p == '/')
+				{
+					++p;
+					if (p < end && *p != '/')
+						p = ParseInt(p, end, ti);
+					if (p < end && *p == '/')
+						p = ParseInt(p + 1, end, ni);
+				}
+				p = SkipWord(p, end);
+				corners.push_back(pi);
+				corners.push_back(ti);
+				corners.push_back(ni);
+			}
+			sink.Face(corners);
+		}
+		else if (wordLen == 6 && std::memcmp(word, "usemtl", 6) == 0)
+		{
+			const char* name = SkipBlanks(p, end);
+			p = SkipWord(name, end);
+			sink.UseMaterial(std::string(name, p));
+		}
+		else if (wordLen == 6 && std::memcmp(word, "mtllib", 6) == 0)
+		{
+			const char* name = SkipBlanks(p, end);
+			p = SkipWord(name, end);
+			sink.MaterialLibrary(std::string(name, p));
+		}
+		p = SkipLine(p, end);
+	}
+}
+// Feeds records straight into the builder.
+struct ObjSerialSink
+{
+	ObjMeshBuilder& builder;
+	ObjMesh& out;
+	const std::string& dir;
+	std::vector<UINT> faceVerts;
+	void Position(const XMFLOAT3& v) { builder.positions.push_back(v); }
+	void Normal(const XMFLOAT3& n) { builder.normals.push_back(n); }
+	void TexCoord(const XMFLOAT2& uv) { builder.uvs.push_back(uv); }
+	void Face(const std::vector<int>& corners)
+	{
+		faceVerts.clear();
+		for (size_t i = 0; i + 2 < corners.size(); i += 3)
+			faceVerts.push_back(builder.AddCorner(corners[i], corners[i + 1], corners[i + 2]));
+		builder.AddFace(faceVerts);
+	}
+	void UseMaterial(const std::string& name) { builder.UseMaterial(name); }
+	void MaterialLibrary(const std::string& name)
+	{
+		out.materialLibraries.push_back(dir + name);
+		ObjLoader::LoadMtl(dir + name, out.materials);
+	}
+};
+// Records produced by one worker over one line-aligned slice of the file.
+struct ObjChunk
+{
+	struct FaceRecord
+	{
+		UINT firstCorner = 0;
+		UINT cornerCount = 0;
+		// Chunk-local v/vt/vn counts when the face was read
+		int posCount = 0;
+		int uvCount = 0;
+		int nrmCount = 0;
+	};
+	// usemtl/mtllib, applied before faces[faceIndex]
+	struct Directive
+	{
+		size_t faceIndex = 0;
+		bool isLibrary = false;
+		std::string name;
+	};
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<FaceRecord> faces;
+	std::vector<int> corners;
+	std::vector<Directive> directives;
+
+	void Position(const XMFLOAT3& v) { positions.push_back(v); }
+	void Normal(const XMFLOAT3& n) { normals.push_back(n); }
+	void TexCoord(const XMFLOAT2& uv) { uvs.push_back(uv); }
+	void Face(const std::vector<int>& faceCorners)
+	{
+		FaceRecord f;
+		f.firstCorner = (UINT)(corners.size() / 3);
+		f.cornerCount = (UINT)(faceCorners.size() / 3);
+		f.posCount = (int)positions.size();
+		f.uvCount = (int)uvs.size();
+		f.nrmCount = (int)normals.size();
+		faces.push_back(f);
+		corners.insert(corners.end(), faceCorners.begin(), faceCorners.end());
+	}
+	void UseMaterial(const std::string& name) { directives.push_back({ faces.size(), false, name }); }
+	void MaterialLibrary(const std::string& name) { directives.push_back({ faces.size(), true, name }); }
+};
+// Negative OBJ indices are relative to the running attribute count, so a
+// face can only be resolved once the sizes of all earlier chunks are known.
+// Replaying the chunks in file order reproduces the serial ResolveIndex,
+// vertex welding order and usemtl subset boundaries exactly.
+static void MergeObjChunk(const ObjChunk& chunk, ObjMeshBuilder& builder, ObjMesh& out,
+	const std::string& dir, std::vector<UINT>& faceVerts)
+{
+	const int posBase = (int)builder.positions.size();
+	const int uvBase = (int)builder.uvs.size();
+	const int nrmBase = (int)builder.normals.size();
+	builder.positions.insert(builder.positions.end(), chunk.positions.begin(), chunk.positions.end());
+	builder.uvs.insert(builder.uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+	builder.normals.insert(builder.normals.end(), chunk.normals.begin(), chunk.normals.end());
+
+	size_t nextDirective = 0;
+	for (size_t faceIndex = 0; faceIndex <= chunk.faces.size(); ++faceIndex)
+	{
+		while (nextDirective < chunk.directives.size() &&
+			chunk.directives[nextDirective].faceIndex == faceIndex)
 		{
-			if (!out.subsets.empty())
+			const ObjChunk::Directive& d = chunk.directives[nextDirective++];
+			if (d.isLibrary)
 			{
-				MeshSubset& last = out.subsets.back();
-				last.indexCount = (UINT)out.indices.size() - last.indexStart;
+				out.materialLibraries.push_back(dir + d.name);
+				ObjLoader::LoadMtl(dir + d.name, out.materials);
 			}
-		};
-	// Helper: open a new subset
-	auto OpenSubset = [&](int matIdx)
-		{
-			CloseSubset();
-			MeshSubset s;
-			s.indexStart = (UINT)out.indices.size();
-			s.indexCount = 0;
-			s.materialIdx = matIdx;
-			out.subsets.push_back(s);
-			curMatIdx = matIdx;
-		};
-	// Open default subset
-	OpenSubset(-1);
+			else
+				builder.UseMaterial(d.name);
+		}
+		if (faceIndex == chunk.faces.size())
+			break;
+
+		const ObjChunk::FaceRecord& f = chunk.faces[faceIndex];
+		faceVerts.clear();
+		for (UINT c = 0; c < f.cornerCount; ++c)
+		{
+			const int* corner = &chunk.corners[(size_t)(f.firstCorner + c) * 3];
+			faceVerts.push_back(builder.AddCorner(
+				corner[0], corner[1], corner[2],
+				posBase + f.posCount, uvBase + f.uvCount, nrmBase + f.nrmCount));
+		}
+		builder.AddFace(faceVerts);
+	}
+}
+bool ObjLoader::Load(const std::string& path, ObjMesh& out, const ObjLoadOptions& options)
+{
+	MappedFile file;
+	if (!file.Open(path)) return false;
+	const std::string dir = DirOf(path);
+	TangentOptions tangents;
+	if (options.parallel)
+		tangents.threadCount = options.threadCount ? options.threadCount : std::thread::hardware_concurrency();
+	tangents.mikkTSpace = options.mikkTSpaceTangents;
+	ObjMeshBuilder builder(out, &tangents);
+	const char* const begin = file.Data();
+	const char* const end = begin + file.Size();
+
+	unsigned threadCount = options.threadCount ? options.threadCount : std::thread::hardware_concurrency();
+	// Below ~1 MB per worker the thread start-up outweighs the parse.
+	const size_t minChunkBytes = 1u << 20;
+	threadCount = (unsigned)(std::min)((size_t)(std::max)(threadCount, 1u), file.Size() / minChunkBytes);
+	ObjLoadTimings timings;
+	auto stageStart = std::chrono::steady_clock::now();
+	auto endStage = [&](double& ms)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		ms = std::chrono::duration<double, std::milli>(now - stageStart).count();
+		stageStart = now;
+	};
+	if (!options.parallel || threadCount < 2)
+	{
+		// Rough guess from the file size (Sponza-like files spend ~150
+		// bytes of v/vt/vn/f text per welded vertex); the map grows if low.
+		builder.ReserveVertices(file.Size() / 160);
+		ObjSerialSink sink{ builder, out, dir, {} };
+		ParseObjRange(begin, end, sink);
+		endStage(timings.parseMs);
+		const bool loaded = builder.Finish();
+		endStage(timings.finishMs);
+		if (options.timings) *options.timings = timings;
+		return loaded;
+	}
+
+	// Split at line boundaries
+	std::vector<const char*> bounds(threadCount + 1, end);
+	bounds[0] = begin;
+	for (unsigned i = 1; i < threadCount; ++i)
+	{
+		const char* p = begin + file.Size() * i / threadCount;
+		p = (std::max)(p, bounds[i - 1]);
+		bounds[i] = (p < end) ? SkipLine(p, end) : end;
+	}
+
+	std::vector<ObjChunk> chunks(threadCount);
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount - 1);
+	for (unsigned i = 1; i < threadCount; ++i)
+		workers.emplace_back([&, i]() { ParseObjRange(bounds[i], bounds[i + 1], chunks[i]); });
+	ParseObjRange(bounds[0], bounds[1], chunks[0]);
+	for (std::thread& t : workers)
+		t.join();
+	endStage(timings.parseMs);
+
+	// Every face corner references one v; welded vertices rarely exceed
+	// the largest attribute count by much.
+	size_t positionCount = 0, uvCount = 0, normalCount = 0;
+	for (const ObjChunk& chunk : chunks)
+	{
+		positionCount += chunk.positions.size();
+		uvCount += chunk.uvs.size();
+		normalCount += chunk.normals.size();
+	}
+	builder.ReserveVertices((std::max)((std::max)(positionCount, uvCount), normalCount));
+
+	std::vector<UINT> faceVerts;
+	for (ObjChunk& chunk : chunks)
+	{
+		MergeObjChunk(chunk, builder, out, dir, faceVerts);
+		chunk = ObjChunk{};
+	}
+	endStage(timings.weldMs);
+	const bool loaded = builder.Finish();
+	endStage(timings.finishMs);
+	if (options.timings) *options.timings = timings;
+	return loaded;
+}
+bool ObjLoader::LoadStreaming(const std::string& path, ObjMesh& out,
+	const ObjSubsetCallback& onSubset, const ObjLoadOptions& options)
+{
+	MappedFile file;
+	if (!file.Open(path)) return false;
+	const std::string dir = DirOf(path);
+	TangentOptions tangents;
+	if (options.parallel)
+		tangents.threadCount = options.threadCount ? options.threadCount : std::thread::hardware_concurrency();
+	tangents.mikkTSpace = options.mikkTSpaceTangents;
+	ObjMeshBuilder builder(out, &tangents, onSubset ? &onSubset : nullptr);
+	builder.ReserveVertices(file.Size() / 160);
+	ObjSerialSink sink{ builder, out, dir, {} };
+	const auto start = std::chrono::steady_clock::now();
+	ParseObjRange(file.Data(), file.Data() + file.Size(), sink);
+	const auto parsed = std::chrono::steady_clock::now();
+	const bool loaded = builder.Finish();
+	if (options.timings)
+	{
+		options.timings->parseMs = std::chrono::duration<double, std::milli>(parsed - start).count();
+		options.timings->weldMs = 0.0;
+		options.timings->finishMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - parsed).count();
+	}
+	return loaded;
+}
+// -------------------------------------------------------
+// OBJ loader (iostream baseline)
+// -------------------------------------------------------
+bool ObjLoader::LoadLegacy(const std::string& path, ObjMesh& out)
+{
+	std::ifstream f(path);
+	if (!f.is_open()) return false;
+	const std::string dir = DirOf(path);
+	ObjMeshBuilder builder(out, nullptr);
 	std::string line;
 	while (std::getline(f, line))
 	{
@@ -151,42 +855,33 @@ bool ObjLoader::Load(const std::string& path, ObjMesh& out)
 		{
 			XMFLOAT3 p = {};
 			ss >> p.x >> p.y >> p.z;
-			positions.push_back(p);
+			builder.positions.push_back(p);
 		}
 		else if (token == "vn")
 		{
 			XMFLOAT3 n = {};
 			ss >> n.x >> n.y >> n.z;
-			normals.push_back(n);
+			builder.normals.push_back(n);
 		}
 		else if (token == "vt")
 		{
 			XMFLOAT2 uv = {};
 			ss >> uv.x >> uv.y;
 			uv.y = 1.f - uv.y; // flip Y
-			uvs.push_back(uv);
+			builder.uvs.push_back(uv);
 		}
 		else if (token == "mtllib")
 		{
 			std::string mtlFile;
 			ss >> mtlFile;
+			out.materialLibraries.push_back(dir + mtlFile);
 			LoadMtl(dir + mtlFile, out.materials);
 		}
 		else if (token == "usemtl")
 		{
 			std::string matName;
 			ss >> matName;
-			int idx = -1;
-			for (int i = 0; i < (int)out.materials.size(); ++i)
-			{
-				if (out.materials[i].name == matName)
-				{
-					idx = i;
-					break;
-				}
-			}
-			if (idx != curMatIdx)
-				OpenSubset(idx);
+			builder.UseMaterial(matName);
 		}
 		else if (token == "f")
 		{
@@ -195,146 +890,16 @@ bool ObjLoader::Load(const std::string& path, ObjMesh& out)
 			std::string vert;
 			while (ss >> vert)
 			{
-				// Replace '/' with space for easy parsing
-				for (char& c : vert) if (c == '/') c = ' ';
+				// Split on '/' so an empty field (v//vn) stays 0
 				std::istringstream vs(vert);
-				int pi = 0, ti = 0, ni = 0;
-				vs >> pi;
-				if (!vs.eof()) vs >> ti;
-				if (!vs.eof()) vs >> ni;
-				int pIdx = ResolveIndex(pi, (int)positions.size());
-				int tIdx = (ti != 0) ? ResolveIndex(ti, (int)uvs.size()) : -1;
-				int nIdx = (ni != 0) ? ResolveIndex(ni, (int)normals.size()) : -1;
-				std::tuple<int, int, int> key(pIdx, tIdx, nIdx);
-				std::map<std::tuple<int, int, int>, UINT>::iterator it = vertexMap.find(key);
-				if (it == vertexMap.end())
-				{
-					ObjMesh::Vertex v;
-					v.Position = (pIdx >= 0 && pIdx < (int)positions.size())
-						? positions[pIdx] : XMFLOAT3(0, 0, 0);
-					v.TexCoord = (tIdx >= 0 && tIdx < (int)uvs.size())
-						? uvs[tIdx] : XMFLOAT2(0, 0);
-					v.Normal = (nIdx >= 0 && nIdx < (int)normals.size())
-						? normals[nIdx] : XMFLOAT3(0, 1, 0);
-					v.Tangent = XMFLOAT3(1, 0, 0);
-					v.Bitangent = XMFLOAT3(0, 0, 1);
-					UINT newIdx = (UINT)out.vertices.size();
-					out.vertices.push_back(v);
-					vertexMap[key] = newIdx;
-					faceVerts.push_back(newIdx);
-				}
-				else
-				{
-					faceVerts.push_back(it->second);
-				}
-			}
-			// Triangulate (fan)
-			for (size_t i = 1; i + 1 < faceVerts.size(); ++i)
-			{
-				out.indices.push_back(faceVerts[0]);
-				out.indices.push_back(faceVerts[i]);
-				out.indices.push_back(faceVerts[i + 1]);
+				std::string field;
+				int idx[3] = {};
+				for (int k = 0; k < 3 && std::getline(vs, field, '/'); ++k)
+					std::istringstream(field) >> idx[k];
+				faceVerts.push_back(builder.AddCorner(idx[0], idx[1], idx[2]));
 			}
+			builder.AddFace(faceVerts);
 		}
 	}
-	// Close last subset
-	CloseSubset();
-
-	// Build tangents/bitangents from indexed triangles.
-	if (!out.vertices.empty() && !out.indices.empty())
-	{
-		std::vector<XMFLOAT3> tanAccum(out.vertices.size(), XMFLOAT3(0.f, 0.f, 0.f));
-		std::vector<XMFLOAT3> bitanAccum(out.vertices.size(), XMFLOAT3(0.f, 0.f, 0.f));
-
-		for (size_t i = 0; i + 2 < out.indices.size(); i += 3)
-		{
-			const UINT i0 = out.indices[i + 0];
-			const UINT i1 = out.indices[i + 1];
-			const UINT i2 = out.indices[i + 2];
-
-			if (i0 >= out.vertices.size() || i1 >= out.vertices.size() || i2 >= out.vertices.size())
-				continue;
-
-			const ObjMesh::Vertex& v0 = out.vertices[i0];
-			const ObjMesh::Vertex& v1 = out.vertices[i1];
-			const ObjMesh::Vertex& v2 = out.vertices[i2];
-
-			const XMVECTOR p0 = XMLoadFloat3(&v0.Position);
-			const XMVECTOR p1 = XMLoadFloat3(&v1.Position);
-			const XMVECTOR p2 = XMLoadFloat3(&v2.Position);
-
-			const XMFLOAT2 uv0 = v0.TexCoord;
-			const XMFLOAT2 uv1 = v1.TexCoord;
-			const XMFLOAT2 uv2 = v2.TexCoord;
-
-			const float x1 = XMVectorGetX(p1) - XMVectorGetX(p0);
-			const float y1 = XMVectorGetY(p1) - XMVectorGetY(p0);
-			const float z1 = XMVectorGetZ(p1) - XMVectorGetZ(p0);
-			const float x2 = XMVectorGetX(p2) - XMVectorGetX(p0);
-			const float y2 = XMVectorGetY(p2) - XMVectorGetY(p0);
-			const float z2 = XMVectorGetZ(p2) - XMVectorGetZ(p0);
-
-			const float s1 = uv1.x - uv0.x;
-			const float t1 = uv1.y - uv0.y;
-			const float s2 = uv2.x - uv0.x;
-			const float t2 = uv2.y - uv0.y;
-
-			const float det = s1 * t2 - s2 * t1;
-			if (std::abs(det) < 1e-8f)
-				continue;
-
-			const float r = 1.0f / det;
-			const XMFLOAT3 triTangent(
-				(t2 * x1 - t1 * x2) * r,
-				(t2 * y1 - t1 * y2) * r,
-				(t2 * z1 - t1 * z2) * r);
-			const XMFLOAT3 triBitangent(
-				(s1 * x2 - s2 * x1) * r,
-				(s1 * y2 - s2 * y1) * r,
-				(s1 * z2 - s2 * z1) * r);
-
-			auto add = [](XMFLOAT3& a, const XMFLOAT3& b)
-			{
-				a.x += b.x; a.y += b.y; a.z += b.z;
-			};
-
-			add(tanAccum[i0], triTangent);
-			add(tanAccum[i1], triTangent);
-			add(tanAccum[i2], triTangent);
-			add(bitanAccum[i0], triBitangent);
-			add(bitanAccum[i1], triBitangent);
-			add(bitanAccum[i2], triBitangent);
-		}
-
-		for (size_t i = 0; i < out.vertices.size(); ++i)
-		{
-			const XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&out.vertices[i].Normal));
-			XMVECTOR t = XMLoadFloat3(&tanAccum[i]);
-			XMVECTOR b = XMLoadFloat3(&bitanAccum[i]);
-
-			if (XMVectorGetX(XMVector3LengthSq(t)) < 1e-10f)
-				t = XMVectorSet(1.f, 0.f, 0.f, 0.f);
-
-			const XMVECTOR ntDot = XMVector3Dot(n, t);
-			t = XMVector3Normalize(XMVectorSubtract(t, XMVectorMultiply(n, ntDot)));
-
-			if (XMVectorGetX(XMVector3LengthSq(b)) < 1e-10f)
-				b = XMVector3Normalize(XMVector3Cross(n, t));
-			else
-				b = XMVector3Normalize(b);
-
-			XMStoreFloat3(&out.vertices[i].Tangent, t);
-			XMStoreFloat3(&out.vertices[i].Bitangent, b);
-		}
-	}
-
-	// Remove empty subsets
-	std::vector<MeshSubset> nonEmpty;
-	for (size_t i = 0; i < out.subsets.size(); ++i)
-	{
-		if (out.subsets[i].indexCount > 0)
-			nonEmpty.push_back(out.subsets[i]);
-	}
-	out.subsets = nonEmpty;
-	return !out.vertices.empty();
+	return builder.Finish();
 }
@@ -1,10 +1,8 @@
 #pragma once
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
+#include "AssetTypes.h"
+#include <functional>
 #include <string>
 #include <vector>
-#include <DirectXMath.h>
-using namespace DirectX;
 struct Material
 {
 	std::string name;
@@ -20,6 +18,58 @@ struct MeshSubset
 	UINT indexStart = 0;
 	UINT indexCount = 0;
 	int materialIdx = -1;
+	// Vertex range owned by the subset; filled by MeshOptimizer (0/0 = unknown)
+	UINT vertexStart = 0;
+	UINT vertexCount = 0;
+	// Range in ObjMesh::meshlets; filled by MeshletBuilder
+	UINT meshletStart = 0;
+	UINT meshletCount = 0;
+	// Range in ObjMesh::lods (levels 1..lodCount); filled by MeshSimplifier
+	UINT lodStart = 0;
+	UINT lodCount = 0;
+	// Object-space bounds of the subset's triangles (ObjLoader::ComputeBounds).
+	// Undisplaced: culling grows them by the material's displacement.
+	XMFLOAT3 boundsMin = { 0.f, 0.f, 0.f };
+	XMFLOAT3 boundsMax = { 0.f, 0.f, 0.f };
+	XMFLOAT3 boundsCenter = { 0.f, 0.f, 0.f };
+	float boundsRadius = 0.f;
+	// Range in ObjMesh::instances; filled by InstanceDetector (0 = drawn once as is)
+	UINT instanceStart = 0;
+	UINT instanceCount = 0;
+};
+// A contiguous run of a subset's triangles (see MeshletBuilder).
+struct Meshlet
+{
+	XMFLOAT3 center;
+	float radius;
+	// Backface cone: the whole meshlet faces away from a viewer at 'eye' when
+	// dot(normalize(coneApex - eye), coneAxis) >= coneCutoff (1 = never).
+	XMFLOAT3 coneAxis;
+	float coneCutoff;
+	XMFLOAT3 coneApex;
+	UINT indexStart; // into ObjMesh::indices
+	UINT indexCount;
+	UINT vertexCount; // unique vertices
+	UINT subset;
+	UINT pad;
+};
+// A simplified copy of a subset's triangles (see MeshSimplifier). It uses the
+// subset's vertex range, so it shares the subset's draw state.
+struct MeshLod
+{
+	UINT indexStart; // into ObjMesh::indices, after every subset range
+	UINT indexCount;
+	float error; // object-space RMS distance to the full-detail surface
+	UINT subset;
+};
+// One placement of an instanced subset (see InstanceDetector). The transform
+// is rigid (rotation + translation), row-vector convention like the scene
+// world matrices, and maps the subset's vertices into model space.
+struct MeshInstance
+{
+	XMFLOAT4X4 transform;
+	UINT subset;
+	UINT pad[3];
 };
 struct ObjMesh
 {
@@ -35,12 +85,64 @@ struct ObjMesh
 	std::vector<UINT> indices;
 	std::vector<MeshSubset> subsets;
 	std::vector<Material> materials;
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshLod> lods;
+	std::vector<MeshInstance> instances;
+	// mtllib files as resolved next to the OBJ (cache dependencies)
+	std::vector<std::string> materialLibraries;
+};
+// Wall time of the stages of one ObjLoader::Load call. The serial parser
+// welds face corners as it reads them, so there weldMs stays 0 and parseMs
+// includes it; the parallel path parses on the workers and welds in the merge.
+struct ObjLoadTimings
+{
+	double parseMs = 0.0;  // text -> v/vt/vn/f records
+	double weldMs = 0.0;   // records -> welded vertices and indices
+	double finishMs = 0.0; // tangent frames, empty subsets, bounds
+};
+struct ObjLoadOptions
+{
+	// Parse v/vt/vn/f records and build tangents on worker threads. The
+	// merge replays the chunks in file order, so the result is
+	// bit-identical to serial.
+	bool parallel = false;
+	// 0 = std::thread::hardware_concurrency()
+	unsigned threadCount = 0;
+	// Angle-weighted, MikkTSpace-style tangent frames (see TangentOptions).
+	// Off by default, so Load() output stays identical to LoadLegacy().
+	bool mikkTSpaceTangents = false;
+	// Filled when set (Load and LoadStreaming)
+	ObjLoadTimings* timings = nullptr;
 };
+// A finished usemtl subset, reported by ObjLoader::LoadStreaming while the
+// rest of the file is still being parsed. 'piece' is self-contained: its
+// vertices are the ones the subset references (in first-use order), its
+// indices are local to them and it has a single subset at indexStart 0.
+// Tangents are built from the piece alone, so a vertex shared with a later
+// subset may differ slightly from the final mesh. The callback may move
+// from 'piece'. 'materials' holds every mtllib read so far.
+using ObjSubsetCallback = std::function<void(UINT subsetIndex, ObjMesh& piece,
+	const std::vector<Material>& materials)>;
 class ObjLoader
 {
 public:
-	static bool Load(const std::string& path, ObjMesh& out);
-private:
+	// Memory-mapped parser that walks the file bytes directly.
+	static bool Load(const std::string& path, ObjMesh& out,
+		const ObjLoadOptions& options = ObjLoadOptions());
+	// Same output as Load(), and calls onSubset for every non-empty subset
+	// as soon as the parser moves past it, on the calling thread. subsetIndex
+	// is the subset's position in out.subsets. Always parses serially
+	// (options.parallel only affects the final tangent pass): parallel
+	// chunks could not report anything before the merge.
+	static bool LoadStreaming(const std::string& path, ObjMesh& out,
+		const ObjSubsetCallback& onSubset, const ObjLoadOptions& options = ObjLoadOptions());
+	// Original getline/istringstream parser, kept as the baseline for
+	// AssetBenchmark. Produces the same ObjMesh for v, v/vt, v//vn and
+	// v/vt/vn faces; no parallel pass, no streaming.
+	static bool LoadLegacy(const std::string& path, ObjMesh& out);
 	static bool LoadMtl(const std::string& mtlPath,
 		std::vector<Material>& materials);
+	// Fills every subset's AABB and bounding sphere (centred on the AABB)
+	// from its index range. Every loader calls it after tangents.
+	static void ComputeBounds(ObjMesh& mesh);
 };
\ No newline at end of file
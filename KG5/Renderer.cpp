@@ -1,9 +1,21 @@
 ﻿#include "Renderer.h"
+#include "InstanceDetector.h"
+#include "SubsetPartitioner.h"
+#include "TextureDecodePool.h"
+#include "TextureManifest.h"
+#include "TextureRegistry.h"
+#include "VertexWelder.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
 #include <stdexcept>
 #include <filesystem>
 #include <algorithm>
 #include <cctype>
 #include <cstdint>
+#include <array>
+#include <map>
 
 static void ThrowIfFailedRenderer(HRESULT hr)
 {
@@ -30,6 +42,7 @@ bool Renderer::Init(HWND hwnd, int width, int height)
         CreateRenderTargetViews();
         CreateDepthStencilView();
         CreateFence();
+        CreateStagingRing();
         CreateDefaultTexture();
 
         m_viewport = { 0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height), 0.0f, 1.0f };
@@ -164,6 +177,31 @@ void Renderer::CreateDescriptorHeaps()
     m_cbvSrvDescSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 }
 
+void Renderer::CreateStagingRing()
+{
+    // Only called while m_cmdList records on m_cmdAllocators[0] (texture loads)
+    auto flush = [this]()
+    {
+        ExecuteStagedCopies();
+        ThrowIfFailedRenderer(m_cmdAllocators[0]->Reset());
+        ThrowIfFailedRenderer(m_cmdList->Reset(m_cmdAllocators[0].Get(), nullptr));
+    };
+    if (!m_staging.Init(m_device.Get(), StagingRingSize, flush))
+    {
+        throw std::runtime_error("Failed to create staging ring");
+    }
+}
+
+void Renderer::ExecuteStagedCopies()
+{
+    ThrowIfFailedRenderer(m_cmdList->Close());
+    ID3D12CommandList* cmdLists[] = { m_cmdList.Get() };
+    m_cmdQueue->ExecuteCommandLists(1, cmdLists);
+    m_staging.Submit(m_fenceValues[m_frameIndex]);
+    WaitForGPU();
+    m_staging.Retire(m_fence->GetCompletedValue());
+}
+
 void Renderer::CreateDefaultTexture()
 {
     TextureLoader::TextureData defaultTex;
@@ -176,12 +214,14 @@ void Renderer::CreateDefaultTexture()
     ThrowIfFailedRenderer(m_cmdAllocators[0]->Reset());
     ThrowIfFailedRenderer(m_cmdList->Reset(m_cmdAllocators[0].Get(), nullptr));
 
+    TextureMipLevel single;
     if (!TextureLoader::CreateTexture(
         m_device.Get(),
         m_cmdList.Get(),
-        defaultTex,
-        m_defaultWhiteTexture,
-        m_defaultWhiteUpload))
+        ViewOf(defaultTex, single),
+        defaultTex.format,
+        m_staging,
+        m_defaultWhiteTexture))
     {
         throw std::runtime_error("Failed to create default texture");
     }
@@ -195,10 +235,7 @@ void Renderer::CreateDefaultTexture()
     auto cpuHandle = m_cbvSrvHeap->GetCPUDescriptorHandleForHeapStart();
     m_device->CreateShaderResourceView(m_defaultWhiteTexture.Get(), &srvDesc, cpuHandle);
 
-    ThrowIfFailedRenderer(m_cmdList->Close());
-    ID3D12CommandList* cmdLists[] = { m_cmdList.Get() };
-    m_cmdQueue->ExecuteCommandLists(1, cmdLists);
-    WaitForGPU();
+    ExecuteStagedCopies();
 }
 
 void Renderer::CreateRenderTargetViews()
@@ -341,6 +378,26 @@ void Renderer::CreateBuffer(const void* data, UINT size, ID3D12Resource** resour
     }
 }
 
+void Renderer::UploadIndices(const UINT* indices, size_t indexCount)
+{
+    PackedIndexData packed;
+    VertexPacking::PackIndices(indices, indexCount, m_subsets, m_lods, packed);
+    m_subsetDraws = packed.draws;
+    m_lodDraws = packed.lodDraws;
+    m_indexCount = packed.narrowCount + packed.wideCount;
+    OutputDebugStringA(VertexPacking::FormatIndices(packed).c_str());
+
+    CreateBuffer(packed.bytes.data(), static_cast<UINT>(packed.bytes.size()), &m_indexBuffer);
+
+    m_ibView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
+    m_ibView.Format = DXGI_FORMAT_R16_UINT;
+    m_ibView.SizeInBytes = packed.narrowCount * static_cast<UINT>(sizeof(uint16_t));
+
+    m_ibView32.BufferLocation = m_indexBuffer->GetGPUVirtualAddress() + packed.wideOffset;
+    m_ibView32.Format = DXGI_FORMAT_R32_UINT;
+    m_ibView32.SizeInBytes = packed.wideCount * static_cast<UINT>(sizeof(UINT));
+}
+
 void Renderer::MoveToNextFrame()
 {
     const UINT64 currentFenceValue = m_fenceValues[m_frameIndex];
@@ -399,25 +456,70 @@ void Renderer::OnResize(int width, int height)
 
 bool Renderer::LoadObj(const std::string& path)
 {
+    // Prefer the binary cache; the mapped arrays feed the packer and index upload directly.
     ObjMesh mesh;
-    if (!ObjLoader::Load(path, mesh))
-        return false;
-
-    std::vector<Vertex> verts;
-    verts.reserve(mesh.vertices.size());
-
-    for (const auto& v : mesh.vertices)
+    MeshCache meshCache;
+    const ObjMesh::Vertex* vertexData = nullptr;
+    const UINT* indexData = nullptr;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    const uint32_t cacheSettings = SubsetPartitioner::SettingsKey(m_subsetSplitOptions, m_mergeSubsets, m_weldVertices);
+    if (meshCache.Open(path, cacheSettings))
+    {
+        meshCache.ReadTables(mesh);
+        vertexData = meshCache.Vertices();
+        vertexCount = meshCache.VertexCount();
+        indexData = meshCache.Indices();
+        indexCount = meshCache.IndexCount();
+        OutputDebugStringA(("[MeshCache] hit: " + MeshCache::PathFor(path) + "\n").c_str());
+    }
+    else
     {
-        Vertex vv{};
-        vv.Position = v.Position;
-        vv.Normal = v.Normal;
-        vv.TexCoord = v.TexCoord;
-        vv.Tangent = v.Tangent;
-        vv.Bitangent = v.Bitangent;
-        verts.push_back(vv);
+        ObjLoadOptions loadOptions;
+        loadOptions.parallel = true;
+        if (!ObjLoader::Load(path, mesh, loadOptions))
+            return false;
+        if (m_weldVertices)
+        {
+            WeldOptions weldOptions;
+            weldOptions.tangents.threadCount = 0;
+            weldOptions.tangents.mikkTSpace = loadOptions.mikkTSpaceTangents;
+            const VertexWelder::Stats weldStats = VertexWelder::Weld(mesh, weldOptions);
+            OutputDebugStringA(VertexWelder::Format(weldStats).c_str());
+        }
+        if (m_mergeSubsets)
+        {
+            const SubsetPartitioner::Stats mergeStats = SubsetPartitioner::MergeByMaterial(mesh);
+            OutputDebugStringA(SubsetPartitioner::Format(mergeStats).c_str());
+        }
+        const InstanceDetector::Stats instanceStats = InstanceDetector::Detect(mesh);
+        OutputDebugStringA(InstanceDetector::Format(instanceStats).c_str());
+        const SubsetPartitioner::Stats splitStats = SubsetPartitioner::SplitOversized(mesh, m_subsetSplitOptions);
+        OutputDebugStringA(SubsetPartitioner::FormatSplit(splitStats).c_str());
+        const MeshOptimizer::Stats optStats = MeshOptimizer::Optimize(mesh);
+        OutputDebugStringA(MeshOptimizer::Format(optStats).c_str());
+        MeshletBuilder::Build(mesh);
+        OutputDebugStringA(MeshletBuilder::Format(mesh).c_str());
+        const MeshSimplifier::Stats lodStats = MeshSimplifier::BuildLods(mesh);
+        OutputDebugStringA(MeshSimplifier::Format(lodStats).c_str());
+        if (!MeshCache::Write(path, mesh, cacheSettings))
+            OutputDebugStringA(("[MeshCache] failed to write " + MeshCache::PathFor(path) + "\n").c_str());
+        vertexData = mesh.vertices.data();
+        vertexCount = mesh.vertices.size();
+        indexData = mesh.indices.data();
+        indexCount = mesh.indices.size();
     }
 
     m_subsets = mesh.subsets;
+    m_meshlets = std::move(mesh.meshlets);
+    m_lods = std::move(mesh.lods);
+    m_instances = std::move(mesh.instances);
+
+    PackedVertexData packed;
+    if (!VertexPacking::Pack(vertexData, vertexCount, m_subsets, m_vertexFormat, packed))
+        return false;
+    m_subsetDequant = packed.subsetDequant;
+
     m_gpuMaterials.clear();
     m_gpuMaterials.resize(mesh.materials.size());
     m_nextSrvIndex = 8;
@@ -433,7 +535,7 @@ bool Renderer::LoadObj(const std::string& path)
         srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
         srvDesc.Format = format;
         srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
+        srvDesc.Texture2D.MipLevels = resource->GetDesc().MipLevels;
 
         D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(
             m_cbvSrvHeap->GetCPUDescriptorHandleForHeapStart(),
@@ -443,172 +545,175 @@ bool Renderer::LoadObj(const std::string& path)
         m_device->CreateShaderResourceView(resource, &srvDesc, cpuHandle);
     };
 
-    auto tryLoadTexture = [&](const std::filesystem::path& texPath,
-                              ComPtr<ID3D12Resource>& outTexture,
-                              ComPtr<ID3D12Resource>& outUpload,
-                              DXGI_FORMAT& outFormat) -> bool
+    // Upload of a slot decoded by TextureDecodePool; false when no candidate
+    // decoded. Slots that TextureRegistry pointed at another job get that
+    // job's resource, uploaded once.
+    struct UploadedTexture
     {
-        TextureLoader::TextureData texData;
-        if (!TextureLoader::LoadFromFile(texPath.wstring(), texData))
-            return false;
-
-        if (!TextureLoader::CreateTexture(
-            m_device.Get(),
-            m_cmdList.Get(),
-            texData,
-            outTexture,
-            outUpload))
+        ComPtr<ID3D12Resource> texture;
+        DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        bool attempted = false;
+    };
+    std::vector<TextureDecodeJob> decodeJobs;
+    std::vector<UploadedTexture> uploadedTextures;
+    auto ownerOf = [&](size_t job) -> size_t
+    {
+        return decodeJobs[job].sharedWith >= 0 ? static_cast<size_t>(decodeJobs[job].sharedWith) : job;
+    };
+    auto uploadDecoded = [&](size_t jobIndex,
+                             ComPtr<ID3D12Resource>& outTexture,
+                             DXGI_FORMAT& outFormat) -> bool
+    {
+        UploadedTexture& uploaded = uploadedTextures[ownerOf(jobIndex)];
+        TextureDecodeJob& job = decodeJobs[ownerOf(jobIndex)];
+        if (!uploaded.attempted && job.PixelsPending())
         {
-            return false;
+            // Decoded straight into staging memory. The pool only read the
+            // header, so a file that does not decode falls through to the
+            // later candidates, and decodedCandidate follows for the manifest.
+            uploaded.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+            const size_t first = static_cast<size_t>(job.decodedCandidate);
+            job.decodedCandidate = -1;
+            for (size_t c = first; c < job.candidates.size(); ++c)
+            {
+                if (TextureLoader::CreateTextureFromFile(
+                    m_device.Get(),
+                    m_cmdList.Get(),
+                    job.candidates[c],
+                    m_staging,
+                    uploaded.texture))
+                {
+                    job.decodedCandidate = static_cast<int>(c);
+                    break;
+                }
+                uploaded.texture.Reset();
+            }
+        }
+        else if (!uploaded.attempted && job.decodedCandidate >= 0)
+        {
+            // Either the decoded image or the mapped cache file
+            TextureMipLevel single;
+            const TextureView view = job.View(single);
+            uploaded.format = TextureLoader::FormatFor(view.encoding);
+            if (!TextureLoader::CreateTexture(
+                m_device.Get(),
+                m_cmdList.Get(),
+                view,
+                uploaded.format,
+                m_staging,
+                uploaded.texture))
+            {
+                uploaded.texture.Reset();
+            }
+            job.cooked.reset();
+            job.image = TextureImage();
         }
+        uploaded.attempted = true;
+        if (!uploaded.texture)
+            return false;
 
-        outFormat = texData.format;
+        outTexture = uploaded.texture;
+        outFormat = uploaded.format;
         return true;
     };
 
-    auto tryLoadTextureCandidates = [&](const std::vector<std::filesystem::path>& candidates,
-                                        ComPtr<ID3D12Resource>& outTexture,
-                                        ComPtr<ID3D12Resource>& outUpload,
-                                        DXGI_FORMAT& outFormat) -> bool
+    auto toLowerCopy = [](std::string value) -> std::string
     {
-        for (const auto& candidate : candidates)
-        {
-            if (tryLoadTexture(candidate, outTexture, outUpload, outFormat))
-                return true;
-        }
-        return false;
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return value;
     };
 
-    bool hasGlobalOverrideNormal = false;
-    bool hasGlobalOverrideDisplacement = false;
-    DXGI_FORMAT globalOverrideNormalFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-    DXGI_FORMAT globalOverrideDisplacementFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    auto looksLikeNormalMapName = [&](const std::string& s) -> bool
+    {
+        const std::string lower = toLowerCopy(s);
+        return lower.find("_ddn") != std::string::npos ||
+            lower.find("_nrm") != std::string::npos ||
+            lower.find("_normal") != std::string::npos ||
+            lower.find("normal") != std::string::npos;
+    };
 
-    if (m_forceSponzaDiagnosticMaterialOverride)
+    auto looksLikeDisplacementMapName = [&](const std::string& s) -> bool
     {
-        m_globalOverrideNormalTexture.Reset();
-        m_globalOverrideNormalUpload.Reset();
-        m_globalOverrideDisplacementTexture.Reset();
-        m_globalOverrideDisplacementUpload.Reset();
+        const std::string lower = toLowerCopy(s);
+        return lower.find("_disp") != std::string::npos ||
+            lower.find("_displacement") != std::string::npos ||
+            lower.find("_height") != std::string::npos ||
+            lower.find("displacement") != std::string::npos ||
+            lower.find("height") != std::string::npos;
+    };
 
+    // One decode job per texture slot: three per material, then the two
+    // diagnostic overrides. Only materials that get SRVs are decoded.
+    enum TextureSlot { SlotDiffuse, SlotNormal, SlotDisplacement, SlotCount };
+    const size_t overrideJobBase = mesh.materials.size() * SlotCount;
+    decodeJobs.resize(overrideJobBase + 2);
+    uploadedTextures.resize(decodeJobs.size());
+    auto addCandidate = [&](size_t job, const std::filesystem::path& candidate)
+    {
+        decodeJobs[job].candidates.push_back(candidate.string());
+    };
+    // Diffuse and normal maps get full mip chains. Displacement is only read
+    // with SampleLevel(0), so it stays single-level. Block compression:
+    // BC1/BC3 diffuse, BC5 normals, BC4 displacement. Slots left single-level
+    // and uncompressed are decoded at upload, into the staging ring.
+    for (size_t job = 0; job < decodeJobs.size(); ++job)
+    {
+        const bool overrideJob = job >= overrideJobBase;
+        const size_t slot = overrideJob ? SlotNormal + (job - overrideJobBase) : job % SlotCount;
+        decodeJobs[job].useCache = m_cacheTextures;
+        decodeJobs[job].generateMips = slot != SlotDisplacement;
+        decodeJobs[job].mipFilter = (slot == SlotNormal) ? TextureMipFilter::NormalMap : TextureMipFilter::Srgb;
+        if (m_compressTextures)
+        {
+            decodeJobs[job].compression = (slot == SlotDiffuse) ? TextureCompression::Color :
+                (slot == SlotNormal) ? TextureCompression::NormalMap : TextureCompression::Height;
+        }
+        decodeJobs[job].decodeAtUpload = !decodeJobs[job].generateMips &&
+            decodeJobs[job].compression == TextureCompression::None;
+    }
+
+    const bool useOverrides = m_forceSponzaDiagnosticMaterialOverride;
+    if (useOverrides)
+    {
         const std::filesystem::path overrideNormalAbs = LR"(E:\_Projects\VS Projects\CG_Lab5_test\KG5\assets\N_jardinera_1_displacement_2.png)";
         const std::filesystem::path overrideDispAbs = LR"(E:\_Projects\VS Projects\CG_Lab5_test\KG5\assets\jardinera_1_displacement_2.png)";
 
-        const std::vector<std::filesystem::path> overrideNormalCandidates = {
-            overrideNormalAbs,
-            baseDir / "N_jardinera_1_displacement_2.png",
-            baseDir / "assets" / "N_jardinera_1_displacement_2.png",
-            baseDir.parent_path() / "assets" / "N_jardinera_1_displacement_2.png"
-        };
-        const std::vector<std::filesystem::path> overrideDisplacementCandidates = {
-            overrideDispAbs,
-            baseDir / "jardinera_1_displacement_2.png",
-            baseDir / "assets" / "jardinera_1_displacement_2.png",
-            baseDir.parent_path() / "assets" / "jardinera_1_displacement_2.png"
-        };
-
-        hasGlobalOverrideNormal = tryLoadTextureCandidates(
-            overrideNormalCandidates,
-            m_globalOverrideNormalTexture,
-            m_globalOverrideNormalUpload,
-            globalOverrideNormalFormat);
+        addCandidate(overrideJobBase + 0, overrideNormalAbs);
+        addCandidate(overrideJobBase + 0, baseDir / "N_jardinera_1_displacement_2.png");
+        addCandidate(overrideJobBase + 0, baseDir / "assets" / "N_jardinera_1_displacement_2.png");
+        addCandidate(overrideJobBase + 0, baseDir.parent_path() / "assets" / "N_jardinera_1_displacement_2.png");
 
-        hasGlobalOverrideDisplacement = tryLoadTextureCandidates(
-            overrideDisplacementCandidates,
-            m_globalOverrideDisplacementTexture,
-            m_globalOverrideDisplacementUpload,
-            globalOverrideDisplacementFormat);
+        addCandidate(overrideJobBase + 1, overrideDispAbs);
+        addCandidate(overrideJobBase + 1, baseDir / "jardinera_1_displacement_2.png");
+        addCandidate(overrideJobBase + 1, baseDir / "assets" / "jardinera_1_displacement_2.png");
+        addCandidate(overrideJobBase + 1, baseDir.parent_path() / "assets" / "jardinera_1_displacement_2.png");
     }
 
+    // Every material gets candidates: with shared triplets the SRV heap
+    // limit is only known once the SRVs are allocated below
     for (size_t i = 0; i < mesh.materials.size(); ++i)
     {
-        m_gpuMaterials[i].diffuse = mesh.materials[i].diffuse;
-        m_gpuMaterials[i].specular = mesh.materials[i].specular;
-        m_gpuMaterials[i].specPower = mesh.materials[i].shininess;
-        m_gpuMaterials[i].hasNormalMap = false;
-        m_gpuMaterials[i].hasDisplacementMap = false;
-        m_gpuMaterials[i].displacementScale = 0.0f;
-        m_gpuMaterials[i].displacementBias = 0.0f;
+        const Material& material = mesh.materials[i];
+        const size_t diffuseJob = i * SlotCount + SlotDiffuse;
+        const size_t normalJob = i * SlotCount + SlotNormal;
+        const size_t displacementJob = i * SlotCount + SlotDisplacement;
 
-        if (m_nextSrvIndex + 2 >= 256)
-            continue;
-
-        const UINT diffuseSrv = m_nextSrvIndex++;
-        const UINT normalSrv = m_nextSrvIndex++;
-        const UINT displacementSrv = m_nextSrvIndex++;
-        m_gpuMaterials[i].diffuseSrvHeapIndex = static_cast<int>(diffuseSrv);
-        m_gpuMaterials[i].normalSrvHeapIndex = static_cast<int>(normalSrv);
-        m_gpuMaterials[i].displacementSrvHeapIndex = static_cast<int>(displacementSrv);
+        if (!material.diffuseTexture.empty())
+            addCandidate(diffuseJob, baseDir / material.diffuseTexture);
 
-        bool hasDiffuse = false;
-        DXGI_FORMAT diffuseFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-        if (!mesh.materials[i].diffuseTexture.empty())
+        // Normal map: map_bump, then names derived from the diffuse map. Also
+        // decoded under the diagnostic override, which may fail to load.
         {
-            std::filesystem::path texPath = baseDir / mesh.materials[i].diffuseTexture;
-            if (tryLoadTexture(
-                texPath,
-                m_gpuMaterials[i].diffuseTexture,
-                m_gpuMaterials[i].diffuseTextureUpload,
-                diffuseFormat))
+            if (!material.normalTexture.empty())
             {
-                hasDiffuse = true;
-            }
-        }
-
-        createSrvAt(
-            diffuseSrv,
-            hasDiffuse ? m_gpuMaterials[i].diffuseTexture.Get() : m_defaultWhiteTexture.Get(),
-            hasDiffuse ? diffuseFormat : DXGI_FORMAT_R8G8B8A8_UNORM);
-
-        auto toLowerCopy = [](std::string value) -> std::string
-        {
-            std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-            return value;
-        };
-
-        auto looksLikeNormalMapName = [&](const std::string& s) -> bool
-        {
-            const std::string lower = toLowerCopy(s);
-            return lower.find("_ddn") != std::string::npos ||
-                lower.find("_nrm") != std::string::npos ||
-                lower.find("_normal") != std::string::npos ||
-                lower.find("normal") != std::string::npos;
-        };
-
-        auto looksLikeDisplacementMapName = [&](const std::string& s) -> bool
-        {
-            const std::string lower = toLowerCopy(s);
-            return lower.find("_disp") != std::string::npos ||
-                lower.find("_displacement") != std::string::npos ||
-                lower.find("_height") != std::string::npos ||
-                lower.find("displacement") != std::string::npos ||
-                lower.find("height") != std::string::npos;
-        };
-
-        bool hasNormal = false;
-        DXGI_FORMAT normalFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-        {
-            if (m_forceSponzaDiagnosticMaterialOverride && hasGlobalOverrideNormal)
-            {
-                hasNormal = true;
-                normalFormat = globalOverrideNormalFormat;
-                m_gpuMaterials[i].normalTexture = m_globalOverrideNormalTexture;
-                m_gpuMaterials[i].normalTextureUpload = m_globalOverrideNormalUpload;
-                m_gpuMaterials[i].hasNormalMap = true;
-            }
-
-            std::vector<std::filesystem::path> normalCandidates;
-
-            if (!hasNormal && !mesh.materials[i].normalTexture.empty())
-            {
-                const std::filesystem::path normalRel(mesh.materials[i].normalTexture);
+                const std::filesystem::path normalRel(material.normalTexture);
                 if (!looksLikeDisplacementMapName(normalRel.stem().string()))
-                    normalCandidates.push_back(baseDir / normalRel);
+                    addCandidate(normalJob, baseDir / normalRel);
             }
 
-            if (!hasNormal && !mesh.materials[i].diffuseTexture.empty())
+            if (!material.diffuseTexture.empty())
             {
-                std::filesystem::path diffuseRel(mesh.materials[i].diffuseTexture);
+                std::filesystem::path diffuseRel(material.diffuseTexture);
                 std::string diffuseStem = diffuseRel.stem().string();
                 const std::string diffuseExt = diffuseRel.extension().string();
                 const std::filesystem::path diffuseParent = diffuseRel.parent_path();
@@ -617,7 +722,7 @@ bool Renderer::LoadObj(const std::string& path)
                 {
                     if (stemName.empty())
                         return;
-                    normalCandidates.push_back(baseDir / (diffuseParent / (stemName + diffuseExt)));
+                    addCandidate(normalJob, baseDir / (diffuseParent / (stemName + diffuseExt)));
                 };
 
                 pushNormalCandidate(diffuseStem + "_ddn");
@@ -638,51 +743,22 @@ bool Renderer::LoadObj(const std::string& path)
                     pushNormalCandidate(replaced);
                 }
             }
-
-            if (!hasNormal && tryLoadTextureCandidates(
-                normalCandidates,
-                m_gpuMaterials[i].normalTexture,
-                m_gpuMaterials[i].normalTextureUpload,
-                normalFormat))
-            {
-                hasNormal = true;
-                m_gpuMaterials[i].hasNormalMap = true;
-            }
         }
 
-        createSrvAt(
-            normalSrv,
-            hasNormal ? m_gpuMaterials[i].normalTexture.Get() : m_defaultWhiteTexture.Get(),
-            hasNormal ? normalFormat : DXGI_FORMAT_R8G8B8A8_UNORM);
-
-        bool hasDisplacement = false;
-        DXGI_FORMAT displacementFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+        // Displacement map: map_Disp, then names derived from the diffuse map.
         {
-            if (m_forceSponzaDiagnosticMaterialOverride && hasGlobalOverrideDisplacement)
+            if (!material.displacementTexture.empty())
             {
-                hasDisplacement = true;
-                displacementFormat = globalOverrideDisplacementFormat;
-                m_gpuMaterials[i].displacementTexture = m_globalOverrideDisplacementTexture;
-                m_gpuMaterials[i].displacementTextureUpload = m_globalOverrideDisplacementUpload;
-                m_gpuMaterials[i].displacementScale = 1.5f;
-                m_gpuMaterials[i].displacementBias = -0.06f;
-                m_gpuMaterials[i].hasDisplacementMap = true;
-            }
-
-            std::vector<std::filesystem::path> displacementCandidates;
-
-            if (!hasDisplacement && !mesh.materials[i].displacementTexture.empty())
-            {
-                std::filesystem::path dispRel(mesh.materials[i].displacementTexture);
+                std::filesystem::path dispRel(material.displacementTexture);
                 if (!looksLikeNormalMapName(dispRel.stem().string()))
                 {
-                    displacementCandidates.push_back(baseDir / dispRel);
+                    addCandidate(displacementJob, baseDir / dispRel);
                 }
             }
 
-            if (!hasDisplacement && !mesh.materials[i].diffuseTexture.empty())
+            if (!material.diffuseTexture.empty())
             {
-                std::filesystem::path diffuseRel(mesh.materials[i].diffuseTexture);
+                std::filesystem::path diffuseRel(material.diffuseTexture);
                 std::string diffuseStem = diffuseRel.stem().string();
                 const std::string diffuseExt = diffuseRel.extension().string();
                 const std::filesystem::path diffuseParent = diffuseRel.parent_path();
@@ -691,7 +767,7 @@ bool Renderer::LoadObj(const std::string& path)
                 {
                     if (stemName.empty())
                         return;
-                    displacementCandidates.push_back(baseDir / (diffuseParent / (stemName + diffuseExt)));
+                    addCandidate(displacementJob, baseDir / (diffuseParent / (stemName + diffuseExt)));
                 };
 
                 const size_t diffPos = diffuseStem.find("_diff");
@@ -716,72 +792,182 @@ bool Renderer::LoadObj(const std::string& path)
             }
 
             // Fallback only for column-like materials (does not override whole scene).
-            std::string materialKey = mesh.materials[i].name + "|" + mesh.materials[i].diffuseTexture;
-            std::string materialKeyLower = materialKey;
-            std::transform(materialKeyLower.begin(), materialKeyLower.end(), materialKeyLower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-            if (!hasDisplacement && materialKeyLower.find("column") != std::string::npos)
+            const std::string materialKeyLower = toLowerCopy(material.name + "|" + material.diffuseTexture);
+            if (materialKeyLower.find("column") != std::string::npos)
             {
-                displacementCandidates.push_back(baseDir.parent_path() / "column_a_displacement_3_inv.png");
-                displacementCandidates.push_back(baseDir / "column_a_displacement_3_inv.png");
+                addCandidate(displacementJob, baseDir.parent_path() / "column_a_displacement_3_inv.png");
+                addCandidate(displacementJob, baseDir / "column_a_displacement_3_inv.png");
             }
+        }
+    }
+
+    // Only files that exist are decoded: the candidates the last load
+    // settled on (TextureManifest), or those in the folder listings
+    AssetDirectoryIndex assetIndex;
+    TextureManifest manifest;
+    const bool manifestHit = manifest.Resolve(path, decodeJobs, assetIndex);
+
+    TextureRegistry::Stats shareStats = TextureRegistry::Share(decodeJobs);
+    const TextureDecodePool::Stats decodeStats = TextureDecodePool::Decode(decodeJobs);
+    TextureRegistry::AddSavings(decodeJobs, shareStats);
+    OutputDebugStringA(AssetDirectoryIndex::Format(assetIndex.GetStats()).c_str());
+    OutputDebugStringA(TextureDecodePool::Format(decodeStats).c_str());
+    if (m_compressTextures)
+        OutputDebugStringA(TextureCompressor::Format(decodeStats.compression).c_str());
+
+    bool hasGlobalOverrideNormal = false;
+    bool hasGlobalOverrideDisplacement = false;
+    DXGI_FORMAT globalOverrideNormalFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    DXGI_FORMAT globalOverrideDisplacementFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+    if (useOverrides)
+    {
+        m_globalOverrideNormalTexture.Reset();
+        m_globalOverrideDisplacementTexture.Reset();
+
+        hasGlobalOverrideNormal = uploadDecoded(
+            overrideJobBase + 0,
+            m_globalOverrideNormalTexture,
+            globalOverrideNormalFormat);
+
+        hasGlobalOverrideDisplacement = uploadDecoded(
+            overrideJobBase + 1,
+            m_globalOverrideDisplacementTexture,
+            globalOverrideDisplacementFormat);
+    }
+
+    // Uploads and SRVs in material order. Materials that end up with the
+    // same three textures share one SRV triplet; once the heap is full, only
+    // materials that can share one get textures.
+    std::map<std::array<int, 3>, UINT> srvTriplets;
+    size_t materialsWithoutSrvs = 0;
+    for (size_t i = 0; i < mesh.materials.size(); ++i)
+    {
+        m_gpuMaterials[i].diffuse = mesh.materials[i].diffuse;
+        m_gpuMaterials[i].specular = mesh.materials[i].specular;
+        m_gpuMaterials[i].specPower = mesh.materials[i].shininess;
+        m_gpuMaterials[i].hasNormalMap = false;
+        m_gpuMaterials[i].hasDisplacementMap = false;
+        m_gpuMaterials[i].displacementScale = 0.0f;
+        m_gpuMaterials[i].displacementBias = 0.0f;
+
+        DXGI_FORMAT diffuseFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+        const bool hasDiffuse = uploadDecoded(
+            i * SlotCount + SlotDiffuse,
+            m_gpuMaterials[i].diffuseTexture,
+            diffuseFormat);
+
+        bool hasNormal = false;
+        size_t normalOwner = 0;
+        DXGI_FORMAT normalFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+        if (useOverrides && hasGlobalOverrideNormal)
+        {
+            hasNormal = true;
+            normalOwner = ownerOf(overrideJobBase + 0);
+            normalFormat = globalOverrideNormalFormat;
+            m_gpuMaterials[i].normalTexture = m_globalOverrideNormalTexture;
+        }
+        else
+        {
+            normalOwner = ownerOf(i * SlotCount + SlotNormal);
+            hasNormal = uploadDecoded(
+                i * SlotCount + SlotNormal,
+                m_gpuMaterials[i].normalTexture,
+                normalFormat);
+        }
+        m_gpuMaterials[i].hasNormalMap = hasNormal;
 
-            if (!hasDisplacement && tryLoadTextureCandidates(
-                displacementCandidates,
+        bool hasDisplacement = false;
+        size_t displacementOwner = 0;
+        DXGI_FORMAT displacementFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+        if (useOverrides && hasGlobalOverrideDisplacement)
+        {
+            hasDisplacement = true;
+            displacementOwner = ownerOf(overrideJobBase + 1);
+            displacementFormat = globalOverrideDisplacementFormat;
+            m_gpuMaterials[i].displacementTexture = m_globalOverrideDisplacementTexture;
+        }
+        else
+        {
+            displacementOwner = ownerOf(i * SlotCount + SlotDisplacement);
+            hasDisplacement = uploadDecoded(
+                i * SlotCount + SlotDisplacement,
                 m_gpuMaterials[i].displacementTexture,
-                m_gpuMaterials[i].displacementTextureUpload,
-                displacementFormat))
-            {
-                hasDisplacement = true;
-                m_gpuMaterials[i].displacementScale = 1.5f;
-                m_gpuMaterials[i].displacementBias = -0.06f;
-                m_gpuMaterials[i].hasDisplacementMap = true;
-            }
+                displacementFormat);
+        }
+        if (hasDisplacement)
+        {
+            m_gpuMaterials[i].displacementScale = 1.5f;
+            m_gpuMaterials[i].displacementBias = -0.06f;
+            m_gpuMaterials[i].hasDisplacementMap = true;
         }
 
+        const std::array<int, 3> srvKey =
+        {
+            hasDiffuse ? static_cast<int>(ownerOf(i * SlotCount + SlotDiffuse)) : -1,
+            hasNormal ? static_cast<int>(normalOwner) : -1,
+            hasDisplacement ? static_cast<int>(displacementOwner) : -1,
+        };
+        if (m_nextSrvIndex + 2 >= 256 && srvTriplets.find(srvKey) == srvTriplets.end())
+        {
+            m_gpuMaterials[i].hasNormalMap = false;
+            m_gpuMaterials[i].hasDisplacementMap = false;
+            ++materialsWithoutSrvs;
+            continue;
+        }
+        const auto triplet = srvTriplets.emplace(srvKey, m_nextSrvIndex);
+        const UINT diffuseSrv = triplet.first->second;
+        m_gpuMaterials[i].diffuseSrvHeapIndex = static_cast<int>(diffuseSrv);
+        m_gpuMaterials[i].normalSrvHeapIndex = static_cast<int>(diffuseSrv + 1);
+        m_gpuMaterials[i].displacementSrvHeapIndex = static_cast<int>(diffuseSrv + 2);
+        if (!triplet.second)
+        {
+            ++shareStats.sharedSrvMaterials;
+            continue;
+        }
+        m_nextSrvIndex += 3;
+
+        createSrvAt(
+            diffuseSrv,
+            hasDiffuse ? m_gpuMaterials[i].diffuseTexture.Get() : m_defaultWhiteTexture.Get(),
+            hasDiffuse ? diffuseFormat : DXGI_FORMAT_R8G8B8A8_UNORM);
         createSrvAt(
-            displacementSrv,
+            diffuseSrv + 1,
+            hasNormal ? m_gpuMaterials[i].normalTexture.Get() : m_defaultWhiteTexture.Get(),
+            hasNormal ? normalFormat : DXGI_FORMAT_R8G8B8A8_UNORM);
+        createSrvAt(
+            diffuseSrv + 2,
             hasDisplacement ? m_gpuMaterials[i].displacementTexture.Get() : m_defaultWhiteTexture.Get(),
             hasDisplacement ? displacementFormat : DXGI_FORMAT_R8G8B8A8_UNORM);
     }
+    OutputDebugStringA(TextureRegistry::Format(shareStats).c_str());
+    // After the uploads: decodeAtUpload slots settle on their candidate there
+    if (!manifestHit && !manifest.Write(decodeJobs))
+        OutputDebugStringA(("[TextureManifest] failed to write " + TextureManifest::PathFor(path) + "\n").c_str());
+    OutputDebugStringA(TextureManifest::Format(manifest.GetStats()).c_str());
+    if (materialsWithoutSrvs > 0)
+        OutputDebugStringA(("[Textures] SRV heap full: " + std::to_string(materialsWithoutSrvs) + " materials left untextured\n").c_str());
 
     CreateBuffer(
-        verts.data(),
-        static_cast<UINT>(verts.size() * sizeof(Vertex)),
+        packed.bytes.data(),
+        static_cast<UINT>(packed.bytes.size()),
         &m_vertexBuffer);
 
-    CreateBuffer(
-        mesh.indices.data(),
-        static_cast<UINT>(mesh.indices.size() * sizeof(UINT)),
-        &m_indexBuffer);
+    UploadIndices(indexData, indexCount);
 
     m_vbView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
-    m_vbView.StrideInBytes = sizeof(Vertex);
-    m_vbView.SizeInBytes = static_cast<UINT>(verts.size() * sizeof(Vertex));
-
-    m_ibView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
-    m_ibView.Format = DXGI_FORMAT_R32_UINT;
-    m_ibView.SizeInBytes = static_cast<UINT>(mesh.indices.size() * sizeof(UINT));
+    m_vbView.StrideInBytes = packed.stride;
+    m_vbView.SizeInBytes = static_cast<UINT>(packed.bytes.size());
 
-    ThrowIfFailedRenderer(m_cmdList->Close());
-    ID3D12CommandList* cmdLists[] = { m_cmdList.Get() };
-    m_cmdQueue->ExecuteCommandLists(1, cmdLists);
-    WaitForGPU();
+    ExecuteStagedCopies();
+    OutputDebugStringA(UploadRing::Format(m_staging.GetStats()).c_str());
 
     return true;
 }
 
 bool Renderer::LoadPrimitiveCubeScene()
 {
-    struct PrimitiveVertex
-    {
-        XMFLOAT3 p;
-        XMFLOAT3 n;
-        XMFLOAT2 uv;
-        XMFLOAT3 t;
-        XMFLOAT3 b;
-    };
-
-    const PrimitiveVertex vertices[] =
+    const ObjMesh::Vertex vertices[] =
     {
         {{-0.5f, -0.5f, -0.5f}, {0, 0,-1}, {0,1}, {1,0,0}, {0,1,0}}, {{ 0.5f, -0.5f, -0.5f}, {0, 0,-1}, {1,1}, {1,0,0}, {0,1,0}}, {{ 0.5f,  0.5f, -0.5f}, {0, 0,-1}, {1,0}, {1,0,0}, {0,1,0}}, {{-0.5f,  0.5f, -0.5f}, {0, 0,-1}, {0,0}, {1,0,0}, {0,1,0}},
         {{-0.5f, -0.5f,  0.5f}, {0, 0, 1}, {0,1}, {-1,0,0}, {0,1,0}}, {{-0.5f,  0.5f,  0.5f}, {0, 0, 1}, {0,0}, {-1,0,0}, {0,1,0}}, {{ 0.5f,  0.5f,  0.5f}, {0, 0, 1}, {1,0}, {-1,0,0}, {0,1,0}}, {{ 0.5f, -0.5f,  0.5f}, {0, 0, 1}, {1,1}, {-1,0,0}, {0,1,0}},
@@ -797,26 +983,23 @@ bool Renderer::LoadPrimitiveCubeScene()
         12,13,14, 12,14,15, 16,17,18, 16,18,19, 20,21,22, 20,22,23
     };
 
-    std::vector<Vertex> verts;
-    verts.reserve(_countof(vertices));
-    for (const auto& v : vertices)
-    {
-        Vertex out{};
-        out.Position = v.p;
-        out.Normal = v.n;
-        out.TexCoord = v.uv;
-        out.Tangent = v.t;
-        out.Bitangent = v.b;
-        verts.push_back(out);
-    }
-
     m_subsets.clear();
+    m_meshlets.clear();
+    m_lods.clear();
+    m_instances.clear();
     MeshSubset s{};
     s.indexStart = 0;
     s.indexCount = _countof(indices);
     s.materialIdx = 0;
+    s.vertexStart = 0;
+    s.vertexCount = _countof(vertices);
     m_subsets.push_back(s);
 
+    PackedVertexData packed;
+    if (!VertexPacking::Pack(vertices, _countof(vertices), m_subsets, m_vertexFormat, packed))
+        return false;
+    m_subsetDequant = packed.subsetDequant;
+
     m_gpuMaterials.clear();
     m_gpuMaterials.resize(1);
     m_gpuMaterials[0].diffuse = XMFLOAT4(0.72f, 0.72f, 0.78f, 1.0f);
@@ -828,16 +1011,12 @@ bool Renderer::LoadPrimitiveCubeScene()
     m_gpuMaterials[0].hasNormalMap = false;
     m_gpuMaterials[0].hasDisplacementMap = false;
 
-    CreateBuffer(verts.data(), static_cast<UINT>(verts.size() * sizeof(Vertex)), &m_vertexBuffer);
-    CreateBuffer(indices, sizeof(indices), &m_indexBuffer);
+    CreateBuffer(packed.bytes.data(), static_cast<UINT>(packed.bytes.size()), &m_vertexBuffer);
+    UploadIndices(indices, _countof(indices));
 
     m_vbView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
-    m_vbView.StrideInBytes = sizeof(Vertex);
-    m_vbView.SizeInBytes = static_cast<UINT>(verts.size() * sizeof(Vertex));
-
-    m_ibView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
-    m_ibView.Format = DXGI_FORMAT_R32_UINT;
-    m_ibView.SizeInBytes = sizeof(indices);
+    m_vbView.StrideInBytes = packed.stride;
+    m_vbView.SizeInBytes = static_cast<UINT>(packed.bytes.size());
     return true;
 }
 
@@ -11,19 +11,13 @@
 #include <stdexcept>
 #include "d3dx12.h"
 #include "ObjLoader.h"
+#include "VertexPacking.h"
+#include "SubsetPartitioner.h"
 #include "TextureLoader.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
 
-struct Vertex {
-    XMFLOAT3 Position;
-    XMFLOAT3 Normal;
-    XMFLOAT2 TexCoord;
-    XMFLOAT3 Tangent;
-    XMFLOAT3 Bitangent;
-};
-
 // Geometry pass constants are intentionally split:
 // - transform constants (per draw)
 // - frame/view constants (per frame)
@@ -33,6 +27,12 @@ struct ObjectTransformConstants
     XMFLOAT4X4 World;
     XMFLOAT4X4 WorldInvTranspose;
     XMFLOAT4 ColorTint = XMFLOAT4(1, 1, 1, 1);
+    // Dequantization for VertexFormat::PackedQuantized (identity otherwise)
+    XMFLOAT4 PositionScale = XMFLOAT4(1, 1, 1, 0);
+    XMFLOAT4 PositionOffset = XMFLOAT4(0, 0, 0, 0);
+    // First entry of this draw in the instance transform buffer (0 = identity)
+    UINT InstanceBase = 0;
+    UINT InstancePad[3] = { 0, 0, 0 };
 };
 
 struct GeometryFrameConstants
@@ -68,11 +68,8 @@ static_assert(sizeof(MaterialConstants) % 16 == 0, "MaterialConstants must be 16
 
 struct GpuMaterial {
     ComPtr<ID3D12Resource> diffuseTexture;
-    ComPtr<ID3D12Resource> diffuseTextureUpload;
     ComPtr<ID3D12Resource> normalTexture;
-    ComPtr<ID3D12Resource> normalTextureUpload;
     ComPtr<ID3D12Resource> displacementTexture;
-    ComPtr<ID3D12Resource> displacementTextureUpload;
     int diffuseSrvHeapIndex = -1;
     int normalSrvHeapIndex = -1;
     int displacementSrvHeapIndex = -1;
@@ -92,6 +89,16 @@ public:
     void EndFrame();
     void OnResize(int width, int height);
     bool LoadObj(const std::string& path);
+    // Applied on the next LoadObj; cached meshes built with other options are re-cooked.
+    void SetSubsetSplitOptions(const SubsetSplitOptions& options) { m_subsetSplitOptions = options; }
+    // Optional passes right after parsing: VertexWelder::Weld and
+    // SubsetPartitioner::MergeByMaterial. Same rules as the split options.
+    void SetVertexWelding(bool enabled) { m_weldVertices = enabled; }
+    void SetSubsetMerge(bool enabled) { m_mergeSubsets = enabled; }
+    // BC1/BC3/BC4/BC5 material textures instead of RGBA8; applied on the next LoadObj.
+    void SetTextureCompression(bool enabled) { m_compressTextures = enabled; }
+    // Reuse cooked textures (<image>.kg5tex) and write them after decoding; applied on the next LoadObj.
+    void SetTextureCache(bool enabled) { m_cacheTextures = enabled; }
     bool LoadPrimitiveCubeScene();
     bool LoadMassPrimitiveScene();
     void WaitForIdle() { WaitForGPU(); }
@@ -134,11 +141,22 @@ public:
         return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cbvSrvHeap->GetCPUDescriptorHandleForHeapStart(), 4, m_cbvSrvDescSize);
     }
     const D3D12_VERTEX_BUFFER_VIEW* GetVbView() const { return &m_vbView; }
-    const D3D12_INDEX_BUFFER_VIEW* GetIbView() const { return &m_ibView; }
+    // 16-bit view for rebased subsets, 32-bit view for oversized ones (same buffer)
+    const D3D12_INDEX_BUFFER_VIEW* GetIbView(bool wideIndices = false) const { return wideIndices ? &m_ibView32 : &m_ibView; }
     const std::vector<MeshSubset>& GetSubsets() const { return m_subsets; }
+    // Empty when the scene has no meshlets (cube scene); see MeshSubset::meshletStart.
+    const std::vector<Meshlet>& GetMeshlets() const { return m_meshlets; }
+    // Simplified levels per subset (MeshSubset::lodStart/lodCount) and their draw ranges.
+    const std::vector<MeshLod>& GetLods() const { return m_lods; }
+    const std::vector<SubsetDrawArgs>& GetLodDraws() const { return m_lodDraws; }
+    // Placements of instanced subsets (MeshSubset::instanceStart/instanceCount).
+    const std::vector<MeshInstance>& GetInstances() const { return m_instances; }
     const std::vector<GpuMaterial>& GetMaterials() const { return m_gpuMaterials; }
+    VertexFormat GetVertexFormat() const { return m_vertexFormat; }
+    const std::vector<PositionDequant>& GetSubsetDequant() const { return m_subsetDequant; }
+    const std::vector<SubsetDrawArgs>& GetSubsetDraws() const { return m_subsetDraws; }
     UINT GetVertexCount() const { return (m_vbView.StrideInBytes > 0) ? (m_vbView.SizeInBytes / m_vbView.StrideInBytes) : 0; }
-    UINT GetIndexCount() const { return m_ibView.SizeInBytes / sizeof(UINT); }
+    UINT GetIndexCount() const { return m_indexCount; }
 
     void CreateBuffer(const void* data, UINT size, ID3D12Resource** resource);
     void TransitionDepthToShaderResource();
@@ -151,7 +169,13 @@ private:
     void CreateRenderTargetViews();
     void CreateDepthStencilView();
     void CreateFence();
+    void CreateStagingRing();
     void CreateDefaultTexture();
+    // Executes m_cmdList, waits for it and returns its staging memory to m_staging
+    void ExecuteStagedCopies();
+    // Packs indices per m_subsets and m_lods (16/32-bit) and fills m_subsetDraws,
+    // m_lodDraws and the IB views.
+    void UploadIndices(const UINT* indices, size_t indexCount);
     void WaitForGPU();
     void MoveToNextFrame();
 
@@ -174,20 +198,36 @@ private:
     ComPtr<ID3D12Fence> m_fence;
     UINT64 m_fenceValues[2] = { 0, 0 };
     HANDLE m_fenceEvent = nullptr;
+    // Staging for every texture upload; upload-heap use stays at this size
+    static constexpr UINT64 StagingRingSize = 64ull * 1024 * 1024;
+    UploadRing m_staging;
 
     ComPtr<ID3D12Resource> m_vertexBuffer;
     ComPtr<ID3D12Resource> m_indexBuffer;
     ComPtr<ID3D12Resource> m_defaultWhiteTexture;
-    ComPtr<ID3D12Resource> m_defaultWhiteUpload;
     bool m_forceSponzaDiagnosticMaterialOverride = true;
     ComPtr<ID3D12Resource> m_globalOverrideNormalTexture;
-    ComPtr<ID3D12Resource> m_globalOverrideNormalUpload;
     ComPtr<ID3D12Resource> m_globalOverrideDisplacementTexture;
-    ComPtr<ID3D12Resource> m_globalOverrideDisplacementUpload;
     D3D12_VERTEX_BUFFER_VIEW m_vbView{};
     D3D12_INDEX_BUFFER_VIEW m_ibView{};
+    D3D12_INDEX_BUFFER_VIEW m_ibView32{};
+    UINT m_indexCount = 0;
     std::vector<MeshSubset> m_subsets;
+    std::vector<Meshlet> m_meshlets;
+    std::vector<MeshLod> m_lods;
+    std::vector<MeshInstance> m_instances;
+    SubsetSplitOptions m_subsetSplitOptions;
+    bool m_weldVertices = true;
+    bool m_mergeSubsets = true;
+    bool m_compressTextures = true;
+    bool m_cacheTextures = true;
     std::vector<GpuMaterial> m_gpuMaterials;
+    // PackedQuantized saves 4 more bytes per vertex, but subsets quantize
+    // shared edges independently (sub-millimetre seams on Sponza).
+    VertexFormat m_vertexFormat = VertexFormat::Packed;
+    std::vector<PositionDequant> m_subsetDequant;
+    std::vector<SubsetDrawArgs> m_subsetDraws;
+    std::vector<SubsetDrawArgs> m_lodDraws;
 
     int m_width = 1280, m_height = 720;
     bool m_initialized = false;
@@ -1,6 +1,10 @@
 #include "RenderingSystem.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
 #include <d3dcompiler.h>
 #include <cmath>
+#include <cfloat>
+#include <climits>
 #include <stdexcept>
 #include <cstdint>
 #include <algorithm>
@@ -78,9 +82,11 @@ bool RenderingSystem::Init(HWND hwnd, int width, int height)
     m_objectTransformCbStride = (sizeof(ObjectTransformConstants) + 255u) & ~255u;
     m_materialCbStride = (sizeof(MaterialConstants) + 255u) & ~255u;
     m_maxObjectCbCount = 8192;
+    m_maxInstanceCount = 4096;
 
     m_renderer.CreateBuffer(nullptr, m_objectTransformCbStride * m_maxObjectCbCount, &m_objectTransformCB);
     m_renderer.CreateBuffer(nullptr, m_materialCbStride * m_maxObjectCbCount, &m_materialCB);
+    m_renderer.CreateBuffer(nullptr, static_cast<UINT>(sizeof(XMFLOAT4X4)) * m_maxInstanceCount, &m_instanceBuffer);
     m_renderer.CreateBuffer(nullptr, sizeof(GeometryFrameConstants), &m_geometryFrameCB);
     m_renderer.CreateBuffer(nullptr, sizeof(LightingContract::LightingFrameConstants), &m_frameCB);
     m_renderer.CreateBuffer(nullptr, sizeof(LightingContract::LocalLightConstants), &m_localLightsCB);
@@ -318,7 +324,16 @@ void RenderingSystem::UpdateWindowTitle() const
         wchar_t title[256];
         swprintf_s(
             title,
-            L"[SPONZA] Deferred Renderer | Particles: %u %s %s",
+            L"[SPONZA] Deferred Renderer | Subsets: %u / %zu %s | Instances: %u / %zu | Clusters: %u / %zu %s | LOD %s | Particles: %u %s %s",
+            m_visibleSubsetCount,
+            m_renderer.GetSubsets().size(),
+            m_enableSubsetCulling ? L"ON" : L"OFF",
+            m_visibleInstanceCount,
+            m_renderer.GetInstances().size(),
+            m_visibleMeshletCount,
+            m_renderer.GetMeshlets().size(),
+            m_enableClusterCulling ? L"ON" : L"OFF",
+            m_enableLod ? L"ON" : L"OFF",
             m_particles.GetAliveCountForDraw(),
             m_particles.IsEnabled() ? L"ON" : L"OFF",
             m_particles.IsSortEnabled() ? L"SORT" : L"NOSORT");
@@ -441,6 +456,30 @@ void RenderingSystem::BuildSingleMainSceneObject()
     m_sceneObjects[0].Visible = true;
 
     m_visibleObjectCount = 1;
+    EnsureInstanceCapacity();
+}
+
+void RenderingSystem::EnsureInstanceCapacity()
+{
+    // Every drawn object copies all its subsets' instances, after the identity entry
+    const size_t objectCount = (std::max)(size_t(1), m_sceneObjects.size());
+    const size_t required = 1 + m_renderer.GetInstances().size() * objectCount;
+    if (required <= m_maxInstanceCount)
+        return;
+    if (required > UINT_MAX / sizeof(XMFLOAT4X4))
+    {
+        OutputDebugStringA("[Instancing] instance buffer would exceed 4 GB, keeping the old size\n");
+        return;
+    }
+
+    // Bound by command lists still in flight
+    m_renderer.WaitForIdle();
+    m_instanceBuffer.Reset();
+    m_maxInstanceCount = static_cast<UINT>(required);
+    m_renderer.CreateBuffer(nullptr, static_cast<UINT>(sizeof(XMFLOAT4X4)) * m_maxInstanceCount, &m_instanceBuffer);
+    char msg[128];
+    std::snprintf(msg, sizeof(msg), "[Instancing] instance buffer grown to %u transforms\n", m_maxInstanceCount);
+    OutputDebugStringA(msg);
 }
 
 void RenderingSystem::RegenerateSceneObjects()
@@ -519,6 +558,7 @@ void RenderingSystem::RegenerateSceneObjects()
             worldY + m_massObjectBoundsCenter.y * objectScale,
             worldZ + m_massObjectBoundsCenter.z * objectScale);
         object.BoundsRadius = m_massObjectBoundsRadius * objectScale;
+        object.Scale = objectScale;
         object.ColorTint = XMFLOAT4(
             0.70f + 0.50f * sceneUnitDist(sceneRng),
             0.70f + 0.50f * sceneUnitDist(sceneRng),
@@ -529,6 +569,7 @@ void RenderingSystem::RegenerateSceneObjects()
     }
 
     m_visibleObjectCount = static_cast<UINT>(m_sceneObjects.size());
+    EnsureInstanceCapacity();
     RebuildCullingDebugLines();
     UpdateObjectVisibility();
     UpdateWindowTitle();
@@ -606,6 +647,122 @@ void RenderingSystem::UpdateObjectVisibility()
     m_visibleObjectCount = visible;
 }
 
+void RenderingSystem::UpdateMeshletVisibility()
+{
+    const auto& meshlets = m_renderer.GetMeshlets();
+    const auto& subsets = m_renderer.GetSubsets();
+    const auto& instances = m_renderer.GetInstances();
+    m_subsetVisible.assign(subsets.size(), 1);
+    m_visibleSubsetCount = static_cast<UINT>(subsets.size());
+    m_instanceVisible.assign(instances.size(), 1);
+    m_visibleInstanceCount = static_cast<UINT>(instances.size());
+    m_meshletVisible.assign(meshlets.size(), 1);
+    m_visibleMeshletCount = static_cast<UINT>(meshlets.size());
+    m_subsetLodDistance.assign(subsets.size(), 0.0f);
+
+    // Subset and meshlet bounds are in model space; only the main model is drawn with an identity world.
+    const bool drawMainModel = m_renderMainSceneModel || m_sceneObjects.empty();
+    if (!drawMainModel)
+        return;
+
+    const auto& materials = m_renderer.GetMaterials();
+    const FrustumPlanes frustum = BuildFrustumPlanes();
+    const XMFLOAT4 planes[] = { frustum.Left, frustum.Right, frustum.Top, frustum.Bottom, frustum.Near, frustum.Far };
+    const float displacementBoost = (m_debugStrongDisplacement != 0) ? 3.0f : 1.0f;
+
+    UINT visible = 0;
+    UINT visibleSubsets = 0;
+    UINT visibleInstances = 0;
+    for (size_t subsetIndex = 0; subsetIndex < subsets.size(); ++subsetIndex)
+    {
+        const MeshSubset& s = subsets[subsetIndex];
+
+        // The domain shader moves vertices along the normal by up to
+        // (|scale| + |bias|) * boost: grow the spheres by that much and skip the
+        // normal cone, which only describes the undisplaced surface.
+        float margin = 0.0f;
+        if (m_useTessellationForScene && s.materialIdx >= 0 && s.materialIdx < static_cast<int>(materials.size()))
+        {
+            const auto& mat = materials[s.materialIdx];
+            if (mat.displacementSrvHeapIndex >= 0 && mat.hasDisplacementMap)
+                margin = (std::fabs(mat.displacementScale) + std::fabs(mat.displacementBias)) * displacementBoost;
+        }
+
+        // Instanced subsets are culled per copy and drawn without clusters;
+        // the nearest visible copy picks the LOD for all of them.
+        if (s.instanceCount > 0 && static_cast<size_t>(s.instanceStart) + s.instanceCount <= instances.size())
+        {
+            float nearest = FLT_MAX;
+            UINT visibleCopies = 0;
+            for (UINT i = s.instanceStart; i < s.instanceStart + s.instanceCount; ++i)
+            {
+                const XMMATRIX m = XMLoadFloat4x4(&instances[i].transform);
+                XMFLOAT3 center;
+                XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&s.boundsCenter), m));
+                const bool isVisible = !m_enableSubsetCulling || s.boundsRadius <= 0.0f ||
+                    IsSphereVisible(center, s.boundsRadius + margin, frustum);
+                m_instanceVisible[i] = isVisible ? 1 : 0;
+                if (!isVisible)
+                    continue;
+                ++visibleCopies;
+                const float dx = center.x - m_cameraPos.x;
+                const float dy = center.y - m_cameraPos.y;
+                const float dz = center.z - m_cameraPos.z;
+                nearest = std::min(nearest, std::sqrt(dx * dx + dy * dy + dz * dz) - s.boundsRadius - margin);
+            }
+            visibleInstances += visibleCopies;
+            const size_t end = std::min<size_t>(static_cast<size_t>(s.meshletStart) + s.meshletCount, meshlets.size());
+            for (size_t i = s.meshletStart; i < end; ++i)
+                m_meshletVisible[i] = 0;
+            if (visibleCopies == 0)
+            {
+                m_subsetVisible[subsetIndex] = 0;
+                continue;
+            }
+            ++visibleSubsets;
+            m_subsetLodDistance[subsetIndex] = std::max(nearest, 0.0f);
+            continue;
+        }
+
+        // A subset outside the frustum skips its meshlets and LOD selection
+        if (m_enableSubsetCulling && s.boundsRadius > 0.0f &&
+            !IsSphereVisible(s.boundsCenter, s.boundsRadius + margin, frustum))
+        {
+            m_subsetVisible[subsetIndex] = 0;
+            const size_t end = std::min<size_t>(static_cast<size_t>(s.meshletStart) + s.meshletCount, meshlets.size());
+            for (size_t i = s.meshletStart; i < end; ++i)
+                m_meshletVisible[i] = 0;
+            continue;
+        }
+        ++visibleSubsets;
+
+        // The nearest meshlet sphere is the subset's LOD distance
+        float nearest = FLT_MAX;
+        const size_t end = std::min<size_t>(static_cast<size_t>(s.meshletStart) + s.meshletCount, meshlets.size());
+        for (size_t i = s.meshletStart; i < end; ++i)
+        {
+            const Meshlet& meshlet = meshlets[i];
+            const float dx = meshlet.center.x - m_cameraPos.x;
+            const float dy = meshlet.center.y - m_cameraPos.y;
+            const float dz = meshlet.center.z - m_cameraPos.z;
+            nearest = std::min(nearest, std::sqrt(dx * dx + dy * dy + dz * dz) - meshlet.radius - margin);
+
+            if (!m_enableClusterCulling)
+                continue;
+            const bool isVisible = MeshletBuilder::IsVisible(
+                meshlet, planes, _countof(planes), m_cameraPos, margin, margin == 0.0f);
+            m_meshletVisible[i] = isVisible ? 1 : 0;
+            if (isVisible)
+                ++visible;
+        }
+        m_subsetLodDistance[subsetIndex] = (end > s.meshletStart) ? std::max(nearest, 0.0f) : 0.0f;
+    }
+    m_visibleSubsetCount = visibleSubsets;
+    m_visibleInstanceCount = visibleInstances;
+    if (m_enableClusterCulling && !meshlets.empty())
+        m_visibleMeshletCount = visible;
+}
+
 void RenderingSystem::OutputDirtySceneStats() const
 {
     const auto& subsets = m_renderer.GetSubsets();
@@ -813,6 +970,24 @@ void RenderingSystem::OnKeyDown(WPARAM key)
         UpdateWindowTitle();
         return;
     }
+    if (key == 'C')
+    {
+        m_enableClusterCulling = !m_enableClusterCulling;
+        UpdateWindowTitle();
+        return;
+    }
+    if (key == 'L')
+    {
+        m_enableLod = !m_enableLod;
+        UpdateWindowTitle();
+        return;
+    }
+    if (key == 'B')
+    {
+        m_enableSubsetCulling = !m_enableSubsetCulling;
+        UpdateWindowTitle();
+        return;
+    }
 
     if (m_activeSceneKind == DemoSceneKind::DirtyInstancing)
     {
@@ -1021,11 +1196,12 @@ void RenderingSystem::CreateRootSignatures()
         CD3DX12_DESCRIPTOR_RANGE srvRange;
         srvRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 3, 0);
 
-        CD3DX12_ROOT_PARAMETER params[4];
+        CD3DX12_ROOT_PARAMETER params[5];
         params[0].InitAsConstantBufferView(0); // ObjectTransformConstants
         params[1].InitAsConstantBufferView(1); // GeometryFrameConstants
         params[2].InitAsConstantBufferView(2); // MaterialConstants
         params[3].InitAsDescriptorTable(1, &srvRange, D3D12_SHADER_VISIBILITY_ALL);
+        params[4].InitAsShaderResourceView(3); // instance transforms
 
         CD3DX12_STATIC_SAMPLER_DESC sampler(
             0,
@@ -1035,7 +1211,7 @@ void RenderingSystem::CreateRootSignatures()
             D3D12_TEXTURE_ADDRESS_MODE_WRAP);
 
         CD3DX12_ROOT_SIGNATURE_DESC desc(
-            4,
+            5,
             params,
             1,
             &sampler,
@@ -1225,13 +1401,20 @@ void RenderingSystem::CreatePSOs()
         throw std::runtime_error("CreatePSOs: one or more mandatory shader blobs are null after compilation.");
     }
 
+    // PackedVertex / QuantizedVertex (VertexPacking.h); both feed the same shaders.
     D3D12_INPUT_ELEMENT_DESC geoLayout[] =
     {
-        { "POSITION",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "NORMAL",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD",  0, DXGI_FORMAT_R32G32_FLOAT,    0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "TANGENT",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 44, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT,    0, 0,  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL",   0, DXGI_FORMAT_R16G16_SNORM,       0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT,       0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TANGENT",  0, DXGI_FORMAT_R10G10B10A2_UNORM,  0, 20, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+    D3D12_INPUT_ELEMENT_DESC geoQuantizedLayout[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0,  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL",   0, DXGI_FORMAT_R16G16_SNORM,       0, 8,  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT,       0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TANGENT",  0, DXGI_FORMAT_R10G10B10A2_UNORM,  0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
     };
 
     D3D12_GRAPHICS_PIPELINE_STATE_DESC geoDesc{};
@@ -1263,6 +1446,14 @@ void RenderingSystem::CreatePSOs()
     geoNoTessDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
     RS_ThrowIfFailed(m_renderer.GetDevice()->CreateGraphicsPipelineState(&geoNoTessDesc, IID_PPV_ARGS(&m_geometryNoTessPSO)));
 
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC geoQuantizedDesc = geoDesc;
+    geoQuantizedDesc.InputLayout = { geoQuantizedLayout, _countof(geoQuantizedLayout) };
+    RS_ThrowIfFailed(m_renderer.GetDevice()->CreateGraphicsPipelineState(&geoQuantizedDesc, IID_PPV_ARGS(&m_geometryQuantizedPSO)));
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC geoNoTessQuantizedDesc = geoNoTessDesc;
+    geoNoTessQuantizedDesc.InputLayout = { geoQuantizedLayout, _countof(geoQuantizedLayout) };
+    RS_ThrowIfFailed(m_renderer.GetDevice()->CreateGraphicsPipelineState(&geoNoTessQuantizedDesc, IID_PPV_ARGS(&m_geometryNoTessQuantizedPSO)));
+
     auto makeFullscreenLightingPso = [&](const char* psEntry, bool additive, ID3D12RootSignature* rootSignature, ComPtr<ID3D12PipelineState>& outPSO)
     {
         ComPtr<ID3DBlob> psBlob;
@@ -1668,12 +1859,18 @@ void RenderingSystem::GeometryPass()
     cmdList->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
     cmdList->SetGraphicsRootSignature(m_geometryRS.Get());
-    cmdList->SetPipelineState(m_useTessellationForScene ? m_geometryPSO.Get() : m_geometryNoTessPSO.Get());
+    cmdList->SetGraphicsRootShaderResourceView(4, m_instanceBuffer->GetGPUVirtualAddress());
+    const bool quantizedPositions = m_renderer.GetVertexFormat() == VertexFormat::PackedQuantized;
+    if (quantizedPositions)
+        cmdList->SetPipelineState(m_useTessellationForScene ? m_geometryQuantizedPSO.Get() : m_geometryNoTessQuantizedPSO.Get());
+    else
+        cmdList->SetPipelineState(m_useTessellationForScene ? m_geometryPSO.Get() : m_geometryNoTessPSO.Get());
     cmdList->IASetPrimitiveTopology(m_useTessellationForScene
         ? D3D_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST
         : D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     cmdList->IASetVertexBuffers(0, 1, m_renderer.GetVbView());
-    cmdList->IASetIndexBuffer(m_renderer.GetIbView());
+    bool wideIndicesBound = false;
+    cmdList->IASetIndexBuffer(m_renderer.GetIbView(wideIndicesBound));
 
     ID3D12DescriptorHeap* heaps[] = { m_renderer.GetSrvHeap() };
     cmdList->SetDescriptorHeaps(1, heaps);
@@ -1694,6 +1891,12 @@ void RenderingSystem::GeometryPass()
 
     const auto& subsets = m_renderer.GetSubsets();
     const auto& materials = m_renderer.GetMaterials();
+    const auto& subsetDequant = m_renderer.GetSubsetDequant();
+    const auto& subsetDraws = m_renderer.GetSubsetDraws();
+    const auto& meshlets = m_renderer.GetMeshlets();
+    const auto& lods = m_renderer.GetLods();
+    const auto& lodDraws = m_renderer.GetLodDraws();
+    const auto& instances = m_renderer.GetInstances();
 
     if (subsets.empty())
         return;
@@ -1706,24 +1909,97 @@ void RenderingSystem::GeometryPass()
     std::uint8_t* transformBase = reinterpret_cast<std::uint8_t*>(transformMapped);
     std::uint8_t* materialBase = reinterpret_cast<std::uint8_t*>(materialMapped);
 
+    // Entry 0 is the identity used by every non-instanced draw
+    void* instanceMapped = nullptr;
+    m_instanceBuffer->Map(0, nullptr, &instanceMapped);
+    XMFLOAT4X4* instanceBase = reinterpret_cast<XMFLOAT4X4*>(instanceMapped);
+    XMStoreFloat4x4(&instanceBase[0], XMMatrixIdentity());
+    UINT nextInstance = 1;
+    UINT droppedInstances = 0;
+
     size_t drawIndex = 0;
     const bool drawMainModel = m_renderMainSceneModel || m_sceneObjects.empty();
     const size_t objectCount = drawMainModel ? 1 : m_sceneObjects.size();
     if (drawMainModel)
         m_visibleObjectCount = static_cast<UINT>(objectCount);
+    const bool clusterCulling = drawMainModel && m_enableClusterCulling &&
+        !meshlets.empty() && m_meshletVisible.size() == meshlets.size();
+    // Projected size of one unit at distance 1 (m_proj._22 = 1 / tan(fovY / 2))
+    const float pixelsPerUnit = 0.5f * static_cast<float>(m_renderer.GetHeight()) * m_proj._22;
 
     for (size_t objectIndex = 0; objectIndex < objectCount; ++objectIndex)
     {
         if (!drawMainModel && !m_sceneObjects[objectIndex].Visible)
             continue;
 
+        // Scene objects pick LODs from their bounding sphere, the main model per subset
+        float objectDistance = 0.0f;
+        float objectScale = 1.0f;
+        if (!drawMainModel)
+        {
+            const SceneObject& object = m_sceneObjects[objectIndex];
+            const float dx = object.BoundsCenter.x - m_cameraPos.x;
+            const float dy = object.BoundsCenter.y - m_cameraPos.y;
+            const float dz = object.BoundsCenter.z - m_cameraPos.z;
+            objectDistance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - object.BoundsRadius, 0.0f);
+            objectScale = object.Scale;
+        }
+
         for (size_t subsetIndex = 0; subsetIndex < subsets.size(); ++subsetIndex)
         {
             if (drawIndex >= m_maxObjectCbCount)
                 break;
 
+            if (drawMainModel && subsetIndex < m_subsetVisible.size() && !m_subsetVisible[subsetIndex])
+                continue;
+
             const auto& s = subsets[subsetIndex];
 
+            // Copy this subset's visible instances (all of them for scene objects)
+            UINT instanceBaseIndex = 0;
+            UINT drawInstanceCount = 1;
+            const bool instanced = s.instanceCount > 0 &&
+                static_cast<size_t>(s.instanceStart) + s.instanceCount <= instances.size();
+            if (instanced)
+            {
+                instanceBaseIndex = nextInstance;
+                drawInstanceCount = 0;
+                for (UINT i = s.instanceStart; i < s.instanceStart + s.instanceCount; ++i)
+                {
+                    if (drawMainModel && i < m_instanceVisible.size() && !m_instanceVisible[i])
+                        continue;
+                    if (nextInstance >= m_maxInstanceCount)
+                    {
+                        ++droppedInstances;
+                        continue;
+                    }
+                    XMStoreFloat4x4(&instanceBase[nextInstance++], XMMatrixTranspose(XMLoadFloat4x4(&instances[i].transform)));
+                    ++drawInstanceCount;
+                }
+                if (drawInstanceCount == 0)
+                    continue;
+            }
+
+            UINT lodLevel = 0;
+            if (m_enableLod && s.lodCount > 0)
+            {
+                const float distance = drawMainModel
+                    ? (subsetIndex < m_subsetLodDistance.size() ? m_subsetLodDistance[subsetIndex] : 0.0f)
+                    : objectDistance;
+                lodLevel = MeshSimplifier::SelectLod(s, lods, objectScale, distance, pixelsPerUnit, m_lodPixelError);
+                if (s.lodStart + lodLevel > lodDraws.size())
+                    lodLevel = 0;
+            }
+            // Meshlets only describe the full-detail triangles
+            const bool drawClusters = !instanced && lodLevel == 0 && clusterCulling && s.meshletCount > 0 &&
+                static_cast<size_t>(s.meshletStart) + s.meshletCount <= meshlets.size();
+            if (drawClusters)
+            {
+                const auto first = m_meshletVisible.begin() + s.meshletStart;
+                if (std::find(first, first + s.meshletCount, std::uint8_t(1)) == first + s.meshletCount)
+                    continue;
+            }
+
             ObjectTransformConstants transform{};
             if (drawMainModel)
             {
@@ -1739,6 +2015,12 @@ void RenderingSystem::GeometryPass()
                 transform.WorldInvTranspose = object.WorldInvTranspose;
                 transform.ColorTint = object.ColorTint;
             }
+            transform.InstanceBase = instanceBaseIndex;
+            if (quantizedPositions && subsetIndex < subsetDequant.size())
+            {
+                transform.PositionScale = subsetDequant[subsetIndex].Scale;
+                transform.PositionOffset = subsetDequant[subsetIndex].Offset;
+            }
 
             MaterialConstants material{};
             material.MaterialDiffuse = XMFLOAT4(1, 1, 1, 1);
@@ -1784,13 +2066,57 @@ void RenderingSystem::GeometryPass()
             cmdList->SetGraphicsRootConstantBufferView(1, m_geometryFrameCB->GetGPUVirtualAddress());
             cmdList->SetGraphicsRootConstantBufferView(2, m_materialCB->GetGPUVirtualAddress() + materialOffset);
             cmdList->SetGraphicsRootDescriptorTable(3, m_renderer.GetSrvGpuHandle(textureSrv));
-            cmdList->DrawIndexedInstanced(s.indexCount, 1, s.indexStart, 0, 0);
+            if (subsetIndex < subsetDraws.size())
+            {
+                const SubsetDrawArgs& draw = (lodLevel > 0) ? lodDraws[s.lodStart + lodLevel - 1] : subsetDraws[subsetIndex];
+                if (draw.wideIndices != wideIndicesBound)
+                {
+                    wideIndicesBound = draw.wideIndices;
+                    cmdList->IASetIndexBuffer(m_renderer.GetIbView(wideIndicesBound));
+                }
+                if (drawClusters)
+                {
+                    // Meshlets are consecutive slices of the subset's indices:
+                    // each run of visible ones is a single draw.
+                    const UINT end = s.meshletStart + s.meshletCount;
+                    UINT i = s.meshletStart;
+                    while (i < end)
+                    {
+                        if (!m_meshletVisible[i])
+                        {
+                            ++i;
+                            continue;
+                        }
+                        const UINT runStart = meshlets[i].indexStart - s.indexStart;
+                        UINT runCount = 0;
+                        while (i < end && m_meshletVisible[i])
+                            runCount += meshlets[i++].indexCount;
+                        cmdList->DrawIndexedInstanced(runCount, 1, draw.indexStart + runStart, draw.baseVertex, 0);
+                    }
+                }
+                else
+                {
+                    cmdList->DrawIndexedInstanced(draw.indexCount, drawInstanceCount, draw.indexStart, draw.baseVertex, 0);
+                }
+            }
             ++drawIndex;
         }
     }
 
     m_objectTransformCB->Unmap(0, nullptr);
     m_materialCB->Unmap(0, nullptr);
+    m_instanceBuffer->Unmap(0, nullptr);
+
+    // EnsureInstanceCapacity sizes the buffer for every copy; report any that did not fit
+    if (drawMainModel)
+        m_visibleInstanceCount -= (std::min)(droppedInstances, m_visibleInstanceCount);
+    if (droppedInstances != m_droppedInstanceCount)
+    {
+        char msg[128];
+        std::snprintf(msg, sizeof(msg), "[Instancing] %u instance copies dropped (buffer holds %u)\n", droppedInstances, m_maxInstanceCount);
+        OutputDebugStringA(msg);
+        m_droppedInstanceCount = droppedInstances;
+    }
 }
 
 void RenderingSystem::UpdateFrameConstants()
@@ -2009,6 +2335,7 @@ void RenderingSystem::DrawScene(float totalTime, float deltaTime)
     {
         UpdateObjectVisibility();
     }
+    UpdateMeshletVisibility();
 
     m_gbuffer.BeginGeometryPass(cmdList);
     m_gbuffer.Clear(cmdList);
@@ -2074,10 +2401,7 @@ void RenderingSystem::DrawScene(float totalTime, float deltaTime)
         }
     }
 
-    if (m_activeSceneKind == DemoSceneKind::DirtyInstancing)
-    {
-        UpdateWindowTitle();
-    }
+    UpdateWindowTitle();
 }
 
 void RenderingSystem::OnResize(int width, int height)
@@ -118,8 +118,11 @@ private:
     void UpdateWindowTitle() const;
     bool LoadMassPrimitiveScene();
     void BuildSingleMainSceneObject();
+    // Grows m_instanceBuffer to hold every instance copy of the current scene
+    void EnsureInstanceCapacity();
     void RegenerateSceneObjects();
     void UpdateObjectVisibility();
+    void UpdateMeshletVisibility();
     FrustumPlanes BuildFrustumPlanes() const;
     bool IsSphereVisible(const XMFLOAT3& center, float radius, const FrustumPlanes& frustum) const;
     void OutputDirtySceneStats() const;
@@ -151,6 +154,8 @@ private:
 
     ComPtr<ID3D12PipelineState> m_geometryPSO;
     ComPtr<ID3D12PipelineState> m_geometryNoTessPSO;
+    ComPtr<ID3D12PipelineState> m_geometryQuantizedPSO;
+    ComPtr<ID3D12PipelineState> m_geometryNoTessQuantizedPSO;
     ComPtr<ID3D12PipelineState> m_psoDirectional;
     ComPtr<ID3D12PipelineState> m_psoLocal;
     ComPtr<ID3D12PipelineState> m_psoRainProxy;
@@ -169,6 +174,7 @@ private:
     ComPtr<ID3D12Resource> m_objectTransformCB;
     ComPtr<ID3D12Resource> m_geometryFrameCB;
     ComPtr<ID3D12Resource> m_materialCB;
+    ComPtr<ID3D12Resource> m_instanceBuffer; // float4x4 per instance, bound as t3
     ComPtr<ID3D12Resource> m_frameCB;
     ComPtr<ID3D12Resource> m_localLightsCB;
     ComPtr<ID3D12Resource> m_rainProxyFrameCB;
@@ -179,6 +185,8 @@ private:
     UINT m_objectTransformCbStride = 0;
     UINT m_materialCbStride = 0;
     UINT m_maxObjectCbCount = 0;
+    UINT m_maxInstanceCount = 0;
+    UINT m_droppedInstanceCount = 0; // copies that did not fit last frame
 
     HWND m_hwnd = nullptr;
     DemoSceneKind m_activeSceneKind = DemoSceneKind::DirtyInstancing;
@@ -236,6 +244,7 @@ private:
         XMFLOAT4X4 WorldInvTranspose{};
         XMFLOAT3 BoundsCenter = { 0.0f, 0.0f, 0.0f };
         float BoundsRadius = 1.0f;
+        float Scale = 1.0f; // uniform world scale, applied to LOD errors
         XMFLOAT4 ColorTint = { 1.0f, 1.0f, 1.0f, 1.0f };
         bool Visible = true;
     };
@@ -243,6 +252,21 @@ private:
     MassPlacementMode m_massPlacementMode = MassPlacementMode::Grid;
     UINT m_sceneObjectCount = 1000;
     UINT m_visibleObjectCount = 0;
+    // Per-subset frustum visibility of the main model, rebuilt every frame (1 = draw).
+    std::vector<uint8_t> m_subsetVisible;
+    UINT m_visibleSubsetCount = 0;
+    bool m_enableSubsetCulling = true;
+    // Per-instance frustum visibility of instanced subsets (indexes Renderer::GetInstances()).
+    std::vector<uint8_t> m_instanceVisible;
+    UINT m_visibleInstanceCount = 0;
+    // Per-meshlet visibility of the main model, rebuilt every frame (1 = draw).
+    std::vector<uint8_t> m_meshletVisible;
+    UINT m_visibleMeshletCount = 0;
+    bool m_enableClusterCulling = true;
+    // Nearest meshlet distance per main-model subset, for LOD selection
+    std::vector<float> m_subsetLodDistance;
+    bool m_enableLod = true;
+    float m_lodPixelError = 1.0f; // max projected simplification error
     UINT m_sceneMaxDrawCallsBudget = 60000;
     XMFLOAT2 m_massPlacementMinXZ = { -360.0f, -360.0f };
     XMFLOAT2 m_massPlacementMaxXZ = { 360.0f, 360.0f };
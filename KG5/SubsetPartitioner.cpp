@@ -0,0 +1,372 @@
+#include "SubsetPartitioner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+// -------------------------------------------------------
+// Grouping
+// -------------------------------------------------------
+// 16 bits of material plus 16 bits per cell axis; cells far enough apart to
+// alias only share a subset, which is harmless for drawing.
+static uint64_t GroupKey(int materialIdx, int32_t x, int32_t y, int32_t z)
+{
+	return ((uint64_t)(uint16_t)materialIdx << 48) |
+		((uint64_t)(uint16_t)x << 32) |
+		((uint64_t)(uint16_t)y << 16) |
+		(uint64_t)(uint16_t)z;
+}
+
+static int32_t CellOf(float v, float invChunk)
+{
+	const float c = std::floor(v * invChunk);
+	return std::isfinite(c) ? (int32_t)(std::max)((std::min)(c, 1e9f), -1e9f) : 0;
+}
+
+SubsetPartitioner::Stats SubsetPartitioner::MergeByMaterial(ObjMesh& mesh, const SubsetMergeOptions& options)
+{
+	const auto start = std::chrono::steady_clock::now();
+	Stats stats;
+	stats.subsetsBefore = mesh.subsets.size();
+
+	// Group of every triangle, numbered by first appearance
+	const bool chunked = options.chunkSize > 0.f;
+	const float invChunk = chunked ? 1.f / options.chunkSize : 0.f;
+	std::unordered_map<uint64_t, UINT> groupOf;
+	std::vector<int> groupMaterial;
+	std::vector<UINT> groupTriangles;
+	std::vector<UINT> triangleGroup;
+	std::vector<UINT> triangleStart;
+	triangleGroup.reserve(mesh.indices.size() / 3);
+	triangleStart.reserve(mesh.indices.size() / 3);
+	std::vector<int> materials;
+	for (const MeshSubset& s : mesh.subsets)
+	{
+		if (std::find(materials.begin(), materials.end(), s.materialIdx) == materials.end())
+			materials.push_back(s.materialIdx);
+		const size_t last = (std::min)((size_t)s.indexStart + s.indexCount, mesh.indices.size());
+		for (size_t i = s.indexStart; i + 2 < last; i += 3)
+		{
+			int32_t x = 0, y = 0, z = 0;
+			if (chunked)
+			{
+				const XMFLOAT3& a = mesh.vertices[mesh.indices[i]].Position;
+				const XMFLOAT3& b = mesh.vertices[mesh.indices[i + 1]].Position;
+				const XMFLOAT3& c = mesh.vertices[mesh.indices[i + 2]].Position;
+				x = CellOf((a.x + b.x + c.x) / 3.f, invChunk);
+				y = CellOf((a.y + b.y + c.y) / 3.f, invChunk);
+				z = CellOf((a.z + b.z + c.z) / 3.f, invChunk);
+			}
+			const auto inserted = groupOf.emplace(GroupKey(s.materialIdx, x, y, z), (UINT)groupMaterial.size());
+			if (inserted.second)
+			{
+				groupMaterial.push_back(s.materialIdx);
+				groupTriangles.push_back(0);
+			}
+			const UINT group = inserted.first->second;
+			++groupTriangles[group];
+			triangleGroup.push_back(group);
+			triangleStart.push_back((UINT)i);
+		}
+	}
+	stats.materialCount = materials.size();
+
+	// Counting sort of the triangles by group
+	std::vector<MeshSubset> subsets(groupMaterial.size());
+	UINT offset = 0;
+	for (size_t g = 0; g < subsets.size(); ++g)
+	{
+		subsets[g].indexStart = offset;
+		subsets[g].indexCount = 0;
+		subsets[g].materialIdx = groupMaterial[g];
+		offset += groupTriangles[g] * 3;
+	}
+	std::vector<UINT> indices(offset);
+	for (size_t t = 0; t < triangleGroup.size(); ++t)
+	{
+		MeshSubset& s = subsets[triangleGroup[t]];
+		UINT* dst = indices.data() + s.indexStart + s.indexCount;
+		const UINT* src = mesh.indices.data() + triangleStart[t];
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+		s.indexCount += 3;
+	}
+
+	mesh.indices.swap(indices);
+	mesh.subsets.swap(subsets);
+	mesh.meshlets.clear();
+	mesh.lods.clear();
+	ObjLoader::ComputeBounds(mesh);
+
+	stats.subsetsAfter = mesh.subsets.size();
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+// -------------------------------------------------------
+// Oversized subsets
+// -------------------------------------------------------
+// Spreads the low 10 bits of v to every third bit
+static uint32_t SpreadBits(uint32_t v)
+{
+	v &= 0x3FF;
+	v = (v | (v << 16)) & 0x030000FF;
+	v = (v | (v << 8)) & 0x0300F00F;
+	v = (v | (v << 4)) & 0x030C30C3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+static uint32_t MortonCode(uint32_t x, uint32_t y, uint32_t z)
+{
+	return SpreadBits(x) | (SpreadBits(y) << 1) | (SpreadBits(z) << 2);
+}
+
+struct ChunkBounds
+{
+	XMFLOAT3 mn;
+	XMFLOAT3 mx;
+	void Reset(const XMFLOAT3& p)
+	{
+		mn = p;
+		mx = p;
+	}
+	void Add(const XMFLOAT3& p)
+	{
+		mn.x = (std::min)(mn.x, p.x);
+		mn.y = (std::min)(mn.y, p.y);
+		mn.z = (std::min)(mn.z, p.z);
+		mx.x = (std::max)(mx.x, p.x);
+		mx.y = (std::max)(mx.y, p.y);
+		mx.z = (std::max)(mx.z, p.z);
+	}
+	float Extent() const { return (std::max)((std::max)(mx.x - mn.x, mx.y - mn.y), mx.z - mn.z); }
+};
+
+struct KeyedTriangle
+{
+	uint32_t code;
+	UINT first; // offset into mesh.indices
+	XMFLOAT3 centroid;
+};
+
+// Morton mode: halves a run of sorted triangles at the highest bit where its
+// codes differ (as in an LBVH) until its centroids fit in maxExtent.
+static void BisectRun(const std::vector<KeyedTriangle>& keyed, size_t begin, size_t end, float maxExtent,
+	std::vector<size_t>& starts)
+{
+	ChunkBounds bounds{};
+	bounds.Reset(keyed[begin].centroid);
+	for (size_t t = begin + 1; t < end; ++t)
+		bounds.Add(keyed[t].centroid);
+	const uint32_t firstCode = keyed[begin].code;
+	const uint32_t lastCode = keyed[end - 1].code;
+	if (bounds.Extent() <= maxExtent || firstCode == lastCode)
+	{
+		starts.push_back(begin);
+		return;
+	}
+	uint32_t bit = 1u << 31;
+	while (!((firstCode ^ lastCode) & bit))
+		bit >>= 1;
+	const uint32_t prefix = lastCode & ~(bit - 1);
+	const size_t mid = std::lower_bound(keyed.begin() + begin, keyed.begin() + end, prefix,
+		[](const KeyedTriangle& k, uint32_t code) { return k.code < code; }) - keyed.begin();
+	BisectRun(keyed, begin, mid, maxExtent, starts);
+	BisectRun(keyed, mid, end, maxExtent, starts);
+}
+
+// Orders the triangles of one subset (offsets into mesh.indices) into
+// chunks and returns the first triangle of every chunk.
+static std::vector<size_t> ChunkTriangles(const ObjMesh& mesh, const MeshSubset& s, float maxExtent,
+	SubsetSplitOptions::Mode mode, std::vector<UINT>& triangles)
+{
+	const size_t count = triangles.size();
+	const XMFLOAT3 lo = s.boundsMin;
+	const float size = (std::max)((std::max)(s.boundsMax.x - lo.x, s.boundsMax.y - lo.y), s.boundsMax.z - lo.z);
+	const float cellSize = (mode == SubsetSplitOptions::Mode::Grid) ? maxExtent : size / 1024.f;
+	const float invCell = (cellSize > 0.f) ? 1.f / cellSize : 0.f;
+
+	// Sort key: Morton code of the centroid's cell (grid cells or a 1024^3 lattice)
+	std::vector<KeyedTriangle> keyed(count);
+	for (size_t t = 0; t < count; ++t)
+	{
+		const UINT* tri = mesh.indices.data() + triangles[t];
+		const XMFLOAT3& a = mesh.vertices[tri[0]].Position;
+		const XMFLOAT3& b = mesh.vertices[tri[1]].Position;
+		const XMFLOAT3& c = mesh.vertices[tri[2]].Position;
+		KeyedTriangle& k = keyed[t];
+		k.first = triangles[t];
+		k.centroid = XMFLOAT3((a.x + b.x + c.x) / 3.f, (a.y + b.y + c.y) / 3.f, (a.z + b.z + c.z) / 3.f);
+		const float cx = (k.centroid.x - lo.x) * invCell;
+		const float cy = (k.centroid.y - lo.y) * invCell;
+		const float cz = (k.centroid.z - lo.z) * invCell;
+		const uint32_t qx = (uint32_t)(std::min)((std::max)(cx, 0.f), 1023.f);
+		const uint32_t qy = (uint32_t)(std::min)((std::max)(cy, 0.f), 1023.f);
+		const uint32_t qz = (uint32_t)(std::min)((std::max)(cz, 0.f), 1023.f);
+		k.code = MortonCode(qx, qy, qz);
+	}
+	std::stable_sort(keyed.begin(), keyed.end(),
+		[](const KeyedTriangle& x, const KeyedTriangle& y) { return x.code < y.code; });
+	for (size_t t = 0; t < count; ++t)
+		triangles[t] = keyed[t].first;
+
+	std::vector<size_t> starts;
+	if (mode == SubsetSplitOptions::Mode::Grid)
+	{
+		// One chunk per cell
+		for (size_t t = 0; t < count; ++t)
+		{
+			if (t == 0 || keyed[t].code != keyed[t - 1].code)
+				starts.push_back(t);
+		}
+	}
+	else if (count > 0)
+	{
+		BisectRun(keyed, 0, count, maxExtent, starts);
+	}
+	return starts;
+}
+
+SubsetPartitioner::Stats SubsetPartitioner::SplitOversized(ObjMesh& mesh, const SubsetSplitOptions& options)
+{
+	const auto start = std::chrono::steady_clock::now();
+	Stats stats;
+	stats.subsetsBefore = mesh.subsets.size();
+	stats.subsetsAfter = mesh.subsets.size();
+	if (mesh.vertices.empty() || mesh.subsets.empty())
+		return stats;
+
+	ChunkBounds meshBounds{};
+	meshBounds.Reset(mesh.vertices[0].Position);
+	for (const ObjMesh::Vertex& v : mesh.vertices)
+		meshBounds.Add(v.Position);
+	const float maxExtent = meshBounds.Extent() * options.maxExtentFraction;
+	if (!(maxExtent > 0.f))
+		return stats;
+
+	std::vector<int> materials;
+	std::vector<UINT> indices;
+	indices.reserve(mesh.indices.size());
+	std::vector<MeshSubset> subsets;
+	subsets.reserve(mesh.subsets.size());
+	std::vector<UINT> newIndexOf(mesh.subsets.size());
+	std::vector<UINT> triangles;
+	for (size_t si = 0; si < mesh.subsets.size(); ++si)
+	{
+		const MeshSubset& s = mesh.subsets[si];
+		if (std::find(materials.begin(), materials.end(), s.materialIdx) == materials.end())
+			materials.push_back(s.materialIdx);
+		newIndexOf[si] = (UINT)subsets.size();
+
+		const size_t last = (std::min)((size_t)s.indexStart + s.indexCount, mesh.indices.size());
+		const float extent = (std::max)((std::max)(s.boundsMax.x - s.boundsMin.x, s.boundsMax.y - s.boundsMin.y),
+			s.boundsMax.z - s.boundsMin.z);
+		const bool split = s.instanceCount == 0 && extent > maxExtent && s.indexCount / 3 >= options.minTriangles;
+
+		triangles.clear();
+		for (size_t i = s.indexStart; i + 2 < last; i += 3)
+			triangles.push_back((UINT)i);
+		std::vector<size_t> starts(1, 0);
+		if (split)
+			starts = ChunkTriangles(mesh, s, maxExtent, options.mode, triangles);
+		starts.push_back(triangles.size());
+
+		for (size_t c = 0; c + 1 < starts.size(); ++c)
+		{
+			MeshSubset chunk = s;
+			chunk.indexStart = (UINT)indices.size();
+			for (size_t t = starts[c]; t < starts[c + 1]; ++t)
+			{
+				const UINT* tri = mesh.indices.data() + triangles[t];
+				indices.insert(indices.end(), tri, tri + 3);
+			}
+			chunk.indexCount = (UINT)indices.size() - chunk.indexStart;
+			chunk.vertexStart = chunk.vertexCount = 0;
+			chunk.meshletStart = chunk.meshletCount = 0;
+			chunk.lodStart = chunk.lodCount = 0;
+			subsets.push_back(chunk);
+		}
+		if (split && starts.size() > 2)
+			++stats.splitSubsets;
+	}
+	stats.materialCount = materials.size();
+
+	mesh.indices.swap(indices);
+	mesh.subsets.swap(subsets);
+	for (MeshInstance& instance : mesh.instances)
+	{
+		if (instance.subset < newIndexOf.size())
+			instance.subset = newIndexOf[instance.subset];
+	}
+	mesh.meshlets.clear();
+	mesh.lods.clear();
+	ObjLoader::ComputeBounds(mesh);
+
+	stats.subsetsAfter = mesh.subsets.size();
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+uint32_t SubsetPartitioner::SettingsKey(const SubsetSplitOptions& options)
+{
+	if (!(options.maxExtentFraction > 0.f))
+		return 0;
+	uint32_t fraction = 0;
+	std::memcpy(&fraction, &options.maxExtentFraction, sizeof(fraction));
+	// FNV-1a over the fields
+	const uint32_t fields[] = { (uint32_t)options.mode, fraction, options.minTriangles };
+	uint32_t hash = 2166136261u;
+	for (uint32_t field : fields)
+	{
+		for (int b = 0; b < 4; ++b)
+		{
+			hash ^= (field >> (b * 8)) & 0xFF;
+			hash *= 16777619u;
+		}
+	}
+	return hash ? hash : 1;
+}
+
+uint32_t SubsetPartitioner::SettingsKey(const SubsetSplitOptions& options, bool mergedByMaterial, bool welded)
+{
+	const uint32_t key = SettingsKey(options);
+	if (mergedByMaterial && welded)
+		return key;
+	// FNV-1a step over the skipped passes
+	uint32_t hash = (key ^ 0x5Au) * 16777619u;
+	hash = (hash ^ ((mergedByMaterial ? 0u : 1u) | (welded ? 0u : 2u))) * 16777619u;
+	return hash ? hash : 1;
+}
+
+std::string SubsetPartitioner::Format(const Stats& s)
+{
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[Subsets] merged by material: %zu -> %zu subsets (%zu materials), %.1f ms\n",
+		s.subsetsBefore,
+		s.subsetsAfter,
+		s.materialCount,
+		s.milliseconds);
+	return buf;
+}
+
+std::string SubsetPartitioner::FormatSplit(const Stats& s)
+{
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[Subsets] split %zu oversized subsets: %zu -> %zu subsets, %.1f ms\n",
+		s.splitSubsets,
+		s.subsetsBefore,
+		s.subsetsAfter,
+		s.milliseconds);
+	return buf;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "ObjLoader.h"
+#include <cstdint>
+#include <string>
+// Regroups triangles into draw subsets. OBJ files switch usemtl back and
+// forth, and ObjLoader opens a new subset at every switch, so one material
+// ends up as many small draws with identical state.
+struct SubsetMergeOptions
+{
+	// 0 = one subset per material. Otherwise triangles are also bucketed by
+	// the cubic cell (edge chunkSize, model units) containing their centroid.
+	float chunkSize = 0.f;
+};
+
+// Splits subsets that span a large part of the model (floors, walls, roofs)
+// so per-subset culling can reject the parts outside the view.
+struct SubsetSplitOptions
+{
+	enum class Mode
+	{
+		Grid,   // one chunk per cubic cell of the subset's bounds
+		Morton, // Morton-ordered runs, halved until they are small enough
+	};
+	Mode mode = Mode::Morton;
+	// Subsets whose largest bounds extent exceeds this fraction of the whole
+	// mesh's largest extent are split into chunks whose triangle centroids
+	// span no more than that (triangles are never cut, so chunk bounds can
+	// be wider). 0 disables splitting.
+	float maxExtentFraction = 0.25f;
+	// Subsets with fewer triangles are left alone.
+	UINT minTriangles = 256;
+};
+
+class SubsetPartitioner
+{
+public:
+	struct Stats
+	{
+		size_t subsetsBefore = 0;
+		size_t subsetsAfter = 0;
+		size_t materialCount = 0; // distinct materialIdx values
+		size_t splitSubsets = 0; // oversized subsets that were chunked
+		double milliseconds = 0.0;
+	};
+
+	// Stable: groups are ordered by their first triangle and keep the
+	// triangles in their original order. Run right after loading (see
+	// VertexWelder): meshlets and LODs are cleared, vertices are untouched
+	// and subset bounds are recomputed.
+	static Stats MergeByMaterial(ObjMesh& mesh, const SubsetMergeOptions& options = SubsetMergeOptions());
+	// Replaces every oversized subset with chunks in its place; each chunk
+	// keeps the material and gets tight bounds. Instanced subsets are kept
+	// whole and MeshInstance::subset is renumbered, so this can run after
+	// InstanceDetector. Meshlets and LODs are cleared.
+	static Stats SplitOversized(ObjMesh& mesh, const SubsetSplitOptions& options = SubsetSplitOptions());
+
+	// Identifies the options in MeshCache, so changing them re-cooks the mesh.
+	static uint32_t SettingsKey(const SubsetSplitOptions& options);
+	// Same, for a mesh that may have skipped MergeByMaterial or
+	// VertexWelder::Weld; with both run it equals the key above.
+	static uint32_t SettingsKey(const SubsetSplitOptions& options, bool mergedByMaterial, bool welded);
+
+	static std::string Format(const Stats& s);
+	static std::string FormatSplit(const Stats& s);
+};
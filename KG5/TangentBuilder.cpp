@@ -0,0 +1,424 @@
+#include "TangentBuilder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TANGENT_BUILDER_SSE 1
+#include <xmmintrin.h>
+#else
+#define TANGENT_BUILDER_SSE 0
+#endif
+
+// Below this many items per worker the thread start-up outweighs the work.
+static const size_t MinItemsPerThread = 16384;
+
+template <typename Fn>
+static void ParallelFor(size_t count, unsigned threadCount, Fn&& fn)
+{
+	const size_t threads = (std::min)((size_t)(std::max)(threadCount, 1u), (std::max)(count / MinItemsPerThread, (size_t)1));
+	if (threads < 2)
+	{
+		fn(0, count);
+		return;
+	}
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	for (size_t i = 1; i < threads; ++i)
+		workers.emplace_back([&, i]() { fn(count * i / threads, count * (i + 1) / threads); });
+	fn(0, count / threads);
+	for (std::thread& t : workers)
+		t.join();
+}
+
+// Shared by every mode so the reference and the gather produce the same bits
+static void FinalizeVertex(ObjMesh::Vertex& v, const XMFLOAT3& tanAccum, const XMFLOAT3& bitanAccum)
+{
+	const XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&v.Normal));
+	XMVECTOR t = XMLoadFloat3(&tanAccum);
+	XMVECTOR b = XMLoadFloat3(&bitanAccum);
+
+	if (XMVectorGetX(XMVector3LengthSq(t)) < 1e-10f)
+		t = XMVectorSet(1.f, 0.f, 0.f, 0.f);
+
+	const XMVECTOR ntDot = XMVector3Dot(n, t);
+	t = XMVector3Normalize(XMVectorSubtract(t, XMVectorMultiply(n, ntDot)));
+
+	if (XMVectorGetX(XMVector3LengthSq(b)) < 1e-10f)
+		b = XMVector3Normalize(XMVector3Cross(n, t));
+	else
+		b = XMVector3Normalize(b);
+
+	XMStoreFloat3(&v.Tangent, t);
+	XMStoreFloat3(&v.Bitangent, b);
+}
+
+// -------------------------------------------------------
+// Pass 1: face tangents
+// -------------------------------------------------------
+struct FaceFrame
+{
+	XMFLOAT3 tangent;
+	XMFLOAT3 bitangent;
+};
+
+// Same expressions as the reference loop, in the same order, so each lane
+// rounds exactly like the scalar code.
+static bool FaceTangentScalar(const ObjMesh& mesh, const UINT* tri, FaceFrame& out)
+{
+	const size_t vertexCount = mesh.vertices.size();
+	if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount)
+		return false;
+	const ObjMesh::Vertex& v0 = mesh.vertices[tri[0]];
+	const ObjMesh::Vertex& v1 = mesh.vertices[tri[1]];
+	const ObjMesh::Vertex& v2 = mesh.vertices[tri[2]];
+
+	const float x1 = v1.Position.x - v0.Position.x;
+	const float y1 = v1.Position.y - v0.Position.y;
+	const float z1 = v1.Position.z - v0.Position.z;
+	const float x2 = v2.Position.x - v0.Position.x;
+	const float y2 = v2.Position.y - v0.Position.y;
+	const float z2 = v2.Position.z - v0.Position.z;
+
+	const float s1 = v1.TexCoord.x - v0.TexCoord.x;
+	const float t1 = v1.TexCoord.y - v0.TexCoord.y;
+	const float s2 = v2.TexCoord.x - v0.TexCoord.x;
+	const float t2 = v2.TexCoord.y - v0.TexCoord.y;
+
+	const float det = s1 * t2 - s2 * t1;
+	if (std::abs(det) < 1e-8f)
+		return false;
+
+	const float r = 1.0f / det;
+	out.tangent = XMFLOAT3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+	out.bitangent = XMFLOAT3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+	return true;
+}
+
+// Calls emit(triangle, frame) for every triangle with a usable UV mapping,
+// in ascending order.
+template <typename Emit>
+static void FaceTangents(const ObjMesh& mesh, size_t firstTri, size_t lastTri, Emit&& emit)
+{
+	size_t t = firstTri;
+#if TANGENT_BUILDER_SSE
+	const size_t vertexCount = mesh.vertices.size();
+	const UINT* indices = mesh.indices.data();
+	alignas(16) float out[6][4];
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 epsilon = _mm_set1_ps(1e-8f);
+	const __m128 signMask = _mm_set1_ps(-0.f);
+	for (; t + 4 <= lastTri; t += 4)
+	{
+		// One triangle per lane; out-of-range triangles read vertex 0 and are masked off
+		const ObjMesh::Vertex* v[3][4];
+		int inRange = 0;
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const UINT* tri = indices + (t + lane) * 3;
+			const bool ok = tri[0] < vertexCount && tri[1] < vertexCount && tri[2] < vertexCount;
+			inRange |= ok ? (1 << lane) : 0;
+			for (int c = 0; c < 3; ++c)
+				v[c][lane] = &mesh.vertices[ok ? tri[c] : 0];
+		}
+#define TB_LANES(c, member) _mm_setr_ps(v[c][0]->member, v[c][1]->member, v[c][2]->member, v[c][3]->member)
+		const __m128 x0 = TB_LANES(0, Position.x), y0 = TB_LANES(0, Position.y), z0 = TB_LANES(0, Position.z);
+		const __m128 x1 = _mm_sub_ps(TB_LANES(1, Position.x), x0);
+		const __m128 y1 = _mm_sub_ps(TB_LANES(1, Position.y), y0);
+		const __m128 z1 = _mm_sub_ps(TB_LANES(1, Position.z), z0);
+		const __m128 x2 = _mm_sub_ps(TB_LANES(2, Position.x), x0);
+		const __m128 y2 = _mm_sub_ps(TB_LANES(2, Position.y), y0);
+		const __m128 z2 = _mm_sub_ps(TB_LANES(2, Position.z), z0);
+
+		const __m128 u0 = TB_LANES(0, TexCoord.x), v0 = TB_LANES(0, TexCoord.y);
+		const __m128 s1 = _mm_sub_ps(TB_LANES(1, TexCoord.x), u0);
+		const __m128 t1 = _mm_sub_ps(TB_LANES(1, TexCoord.y), v0);
+		const __m128 s2 = _mm_sub_ps(TB_LANES(2, TexCoord.x), u0);
+		const __m128 t2 = _mm_sub_ps(TB_LANES(2, TexCoord.y), v0);
+#undef TB_LANES
+
+		const __m128 det = _mm_sub_ps(_mm_mul_ps(s1, t2), _mm_mul_ps(s2, t1));
+		// !(|det| < eps), so a NaN det counts as valid exactly like the scalar test
+		const int detOk = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_andnot_ps(signMask, det), epsilon));
+		const int laneOk = detOk & inRange;
+
+		const __m128 r = _mm_div_ps(one, det);
+		_mm_store_ps(out[0], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, x1), _mm_mul_ps(t1, x2)), r));
+		_mm_store_ps(out[1], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, y1), _mm_mul_ps(t1, y2)), r));
+		_mm_store_ps(out[2], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, z1), _mm_mul_ps(t1, z2)), r));
+		_mm_store_ps(out[3], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, x2), _mm_mul_ps(s2, x1)), r));
+		_mm_store_ps(out[4], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, y2), _mm_mul_ps(s2, y1)), r));
+		_mm_store_ps(out[5], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, z2), _mm_mul_ps(s2, z1)), r));
+
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			if (!((laneOk >> lane) & 1))
+				continue;
+			FaceFrame f;
+			f.tangent = XMFLOAT3(out[0][lane], out[1][lane], out[2][lane]);
+			f.bitangent = XMFLOAT3(out[3][lane], out[4][lane], out[5][lane]);
+			emit(t + lane, f);
+		}
+	}
+#endif
+	for (; t < lastTri; ++t)
+	{
+		FaceFrame f;
+		if (FaceTangentScalar(mesh, mesh.indices.data() + t * 3, f))
+			emit(t, f);
+	}
+}
+
+// -------------------------------------------------------
+// Pass 2: per-vertex reduction
+// -------------------------------------------------------
+static void Normalize(XMFLOAT3& v)
+{
+	const float len = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	if (len > 0.f)
+	{
+		v.x /= len;
+		v.y /= len;
+		v.z /= len;
+	}
+}
+
+static float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// v minus its component along the unit normal n
+static XMFLOAT3 ProjectOnPlane(const XMFLOAT3& v, const XMFLOAT3& n)
+{
+	const float d = Dot(n, v);
+	return XMFLOAT3(v.x - n.x * d, v.y - n.y * d, v.z - n.z * d);
+}
+
+static void AccumulateVertices(ObjMesh& mesh, size_t firstVertex, size_t lastVertex,
+	const std::vector<UINT>& cornerOffsets, const std::vector<UINT>& corners,
+	const std::vector<FaceFrame>& frames, const std::vector<uint8_t>& valid)
+{
+	for (size_t v = firstVertex; v < lastVertex; ++v)
+	{
+		XMFLOAT3 tanAccum(0.f, 0.f, 0.f);
+		XMFLOAT3 bitanAccum(0.f, 0.f, 0.f);
+		for (UINT k = cornerOffsets[v]; k < cornerOffsets[v + 1]; ++k)
+		{
+			const UINT tri = corners[k] / 3;
+			if (!valid[tri])
+				continue;
+			const FaceFrame& f = frames[tri];
+			tanAccum.x += f.tangent.x; tanAccum.y += f.tangent.y; tanAccum.z += f.tangent.z;
+			bitanAccum.x += f.bitangent.x; bitanAccum.y += f.bitangent.y; bitanAccum.z += f.bitangent.z;
+		}
+		FinalizeVertex(mesh.vertices[v], tanAccum, bitanAccum);
+	}
+}
+
+static void AccumulateVerticesMikk(ObjMesh& mesh, size_t firstVertex, size_t lastVertex,
+	const std::vector<UINT>& cornerOffsets, const std::vector<UINT>& corners,
+	const std::vector<FaceFrame>& frames, const std::vector<uint8_t>& valid)
+{
+	for (size_t v = firstVertex; v < lastVertex; ++v)
+	{
+		ObjMesh::Vertex& vertex = mesh.vertices[v];
+		XMFLOAT3 n = vertex.Normal;
+		Normalize(n);
+		XMFLOAT3 tanAccum(0.f, 0.f, 0.f);
+		XMFLOAT3 bitanAccum(0.f, 0.f, 0.f);
+		for (UINT k = cornerOffsets[v]; k < cornerOffsets[v + 1]; ++k)
+		{
+			const UINT corner = corners[k];
+			const UINT tri = corner / 3;
+			if (!valid[tri])
+				continue;
+			const UINT* idx = mesh.indices.data() + tri * 3;
+			const XMFLOAT3& p = vertex.Position;
+			const XMFLOAT3& pNext = mesh.vertices[idx[(corner + 1) % 3]].Position;
+			const XMFLOAT3& pPrev = mesh.vertices[idx[(corner + 2) % 3]].Position;
+
+			// Corner angle measured in the tangent plane of the vertex normal
+			XMFLOAT3 e1 = ProjectOnPlane(XMFLOAT3(pNext.x - p.x, pNext.y - p.y, pNext.z - p.z), n);
+			XMFLOAT3 e2 = ProjectOnPlane(XMFLOAT3(pPrev.x - p.x, pPrev.y - p.y, pPrev.z - p.z), n);
+			Normalize(e1);
+			Normalize(e2);
+			const float angle = std::acos((std::max)(-1.f, (std::min)(1.f, Dot(e1, e2))));
+
+			XMFLOAT3 t = ProjectOnPlane(frames[tri].tangent, n);
+			XMFLOAT3 b = ProjectOnPlane(frames[tri].bitangent, n);
+			Normalize(t);
+			Normalize(b);
+			tanAccum.x += t.x * angle; tanAccum.y += t.y * angle; tanAccum.z += t.z * angle;
+			bitanAccum.x += b.x * angle; bitanAccum.y += b.y * angle; bitanAccum.z += b.z * angle;
+		}
+
+		if (Dot(tanAccum, tanAccum) < 1e-10f)
+			tanAccum = XMFLOAT3(1.f, 0.f, 0.f);
+		XMFLOAT3 t = ProjectOnPlane(tanAccum, n);
+		Normalize(t);
+		XMFLOAT3 b(n.y * t.z - n.z * t.y, n.z * t.x - n.x * t.z, n.x * t.y - n.y * t.x);
+		Normalize(b);
+		if (Dot(b, bitanAccum) < 0.f)
+			b = XMFLOAT3(-b.x, -b.y, -b.z);
+		vertex.Tangent = t;
+		vertex.Bitangent = b;
+	}
+}
+
+// -------------------------------------------------------
+// Drivers
+// -------------------------------------------------------
+void TangentBuilder::Build(ObjMesh& mesh, const TangentOptions& options)
+{
+	if (mesh.vertices.empty() || mesh.indices.empty())
+		return;
+	unsigned threadCount = options.threadCount ? options.threadCount : std::thread::hardware_concurrency();
+	const size_t vertexCount = mesh.vertices.size();
+	const size_t triCount = mesh.indices.size() / 3;
+	if (triCount < (size_t)MinItemsPerThread * 2)
+		threadCount = 1;
+
+	if (threadCount < 2 && !options.mikkTSpace)
+	{
+		// Single thread: scatter straight from the SIMD pass, in the reference order
+		std::vector<XMFLOAT3> tanAccum(vertexCount, XMFLOAT3(0.f, 0.f, 0.f));
+		std::vector<XMFLOAT3> bitanAccum(vertexCount, XMFLOAT3(0.f, 0.f, 0.f));
+		XMFLOAT3* tans = tanAccum.data();
+		XMFLOAT3* bitans = bitanAccum.data();
+		const UINT* indices = mesh.indices.data();
+		FaceTangents(mesh, 0, triCount, [tans, bitans, indices](size_t t, const FaceFrame& f)
+		{
+			const UINT* tri = indices + t * 3;
+			for (int c = 0; c < 3; ++c)
+			{
+				XMFLOAT3& ta = tans[tri[c]];
+				XMFLOAT3& ba = bitans[tri[c]];
+				ta.x += f.tangent.x; ta.y += f.tangent.y; ta.z += f.tangent.z;
+				ba.x += f.bitangent.x; ba.y += f.bitangent.y; ba.z += f.bitangent.z;
+			}
+		});
+		for (size_t v = 0; v < vertexCount; ++v)
+			FinalizeVertex(mesh.vertices[v], tanAccum[v], bitanAccum[v]);
+		return;
+	}
+
+	std::vector<FaceFrame> frames(triCount);
+	std::vector<uint8_t> valid(triCount, 0);
+	ParallelFor(triCount, threadCount, [&](size_t first, size_t last)
+	{
+		FaceTangents(mesh, first, last, [&](size_t t, const FaceFrame& f)
+		{
+			frames[t] = f;
+			valid[t] = 1;
+			if (options.mikkTSpace)
+			{
+				// Unit face vectors; 1/det only scaled them
+				Normalize(frames[t].tangent);
+				Normalize(frames[t].bitangent);
+			}
+		});
+	});
+
+	// Vertex -> corner table, filled in index order
+	std::vector<UINT> cornerOffsets(vertexCount + 1, 0);
+	const size_t cornerCount = triCount * 3;
+	for (size_t i = 0; i < cornerCount; ++i)
+	{
+		if (mesh.indices[i] < vertexCount)
+			++cornerOffsets[mesh.indices[i] + 1];
+	}
+	for (size_t v = 0; v < vertexCount; ++v)
+		cornerOffsets[v + 1] += cornerOffsets[v];
+	std::vector<UINT> corners(cornerOffsets[vertexCount]);
+	{
+		std::vector<UINT> cursor(cornerOffsets.begin(), cornerOffsets.end() - 1);
+		for (size_t i = 0; i < cornerCount; ++i)
+		{
+			if (mesh.indices[i] < vertexCount)
+				corners[cursor[mesh.indices[i]]++] = (UINT)i;
+		}
+	}
+
+	ParallelFor(vertexCount, threadCount, [&](size_t first, size_t last)
+	{
+		if (options.mikkTSpace)
+			AccumulateVerticesMikk(mesh, first, last, cornerOffsets, corners, frames, valid);
+		else
+			AccumulateVertices(mesh, first, last, cornerOffsets, corners, frames, valid);
+	});
+}
+
+void TangentBuilder::BuildReference(ObjMesh& out)
+{
+	if (out.vertices.empty() || out.indices.empty())
+		return;
+
+	std::vector<XMFLOAT3> tanAccum(out.vertices.size(), XMFLOAT3(0.f, 0.f, 0.f));
+	std::vector<XMFLOAT3> bitanAccum(out.vertices.size(), XMFLOAT3(0.f, 0.f, 0.f));
+
+	for (size_t i = 0; i + 2 < out.indices.size(); i += 3)
+	{
+		const UINT i0 = out.indices[i + 0];
+		const UINT i1 = out.indices[i + 1];
+		const UINT i2 = out.indices[i + 2];
+
+		if (i0 >= out.vertices.size() || i1 >= out.vertices.size() || i2 >= out.vertices.size())
+			continue;
+
+		const ObjMesh::Vertex& v0 = out.vertices[i0];
+		const ObjMesh::Vertex& v1 = out.vertices[i1];
+		const ObjMesh::Vertex& v2 = out.vertices[i2];
+
+		const XMVECTOR p0 = XMLoadFloat3(&v0.Position);
+		const XMVECTOR p1 = XMLoadFloat3(&v1.Position);
+		const XMVECTOR p2 = XMLoadFloat3(&v2.Position);
+
+		const XMFLOAT2 uv0 = v0.TexCoord;
+		const XMFLOAT2 uv1 = v1.TexCoord;
+		const XMFLOAT2 uv2 = v2.TexCoord;
+
+		const float x1 = XMVectorGetX(p1) - XMVectorGetX(p0);
+		const float y1 = XMVectorGetY(p1) - XMVectorGetY(p0);
+		const float z1 = XMVectorGetZ(p1) - XMVectorGetZ(p0);
+		const float x2 = XMVectorGetX(p2) - XMVectorGetX(p0);
+		const float y2 = XMVectorGetY(p2) - XMVectorGetY(p0);
+		const float z2 = XMVectorGetZ(p2) - XMVectorGetZ(p0);
+
+		const float s1 = uv1.x - uv0.x;
+		const float t1 = uv1.y - uv0.y;
+		const float s2 = uv2.x - uv0.x;
+		const float t2 = uv2.y - uv0.y;
+
+		const float det = s1 * t2 - s2 * t1;
+		if (std::abs(det) < 1e-8f)
+			continue;
+
+		const float r = 1.0f / det;
+		const XMFLOAT3 triTangent(
+			(t2 * x1 - t1 * x2) * r,
+			(t2 * y1 - t1 * y2) * r,
+			(t2 * z1 - t1 * z2) * r);
+		const XMFLOAT3 triBitangent(
+			(s1 * x2 - s2 * x1) * r,
+			(s1 * y2 - s2 * y1) * r,
+			(s1 * z2 - s2 * z1) * r);
+
+		auto add = [](XMFLOAT3& a, const XMFLOAT3& b)
+		{
+			a.x += b.x; a.y += b.y; a.z += b.z;
+		};
+
+		add(tanAccum[i0], triTangent);
+		add(tanAccum[i1], triTangent);
+		add(tanAccum[i2], triTangent);
+		add(bitanAccum[i0], triBitangent);
+		add(bitanAccum[i1], triBitangent);
+		add(bitanAccum[i2], triBitangent);
+	}
+
+	for (size_t i = 0; i < out.vertices.size(); ++i)
+		FinalizeVertex(out.vertices[i], tanAccum[i], bitanAccum[i]);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "ObjLoader.h"
+// Per-vertex tangent frames for normal mapping.
+//
+// Build() runs in two passes that both split across threads:
+//   1. face tangents, four triangles per SSE iteration (SoA lanes)
+//   2. per-vertex reduction over a vertex -> corner table, each thread
+//      owning a range of vertices
+// Pass 2 gathers instead of scattering, and visits every vertex's
+// triangles in index order. In the default mode the result is therefore
+// bit-identical to BuildReference for any thread count, which keeps the
+// parallel OBJ loader's output identical to the serial one.
+struct TangentOptions
+{
+	// 0 = std::thread::hardware_concurrency(), 1 = run on the calling thread
+	unsigned threadCount = 1;
+	// MikkTSpace-style frames: unit face tangents projected onto the vertex
+	// normal and weighted by the corner angle, bitangent = sign * (N x T).
+	// Vertices are not split on handedness conflicts; the OBJ welder already
+	// splits mirrored UV seams because their vt indices differ.
+	bool mikkTSpace = false;
+};
+
+class TangentBuilder
+{
+public:
+	static void Build(ObjMesh& mesh, const TangentOptions& options = TangentOptions());
+	// Original single-threaded scatter loop; kept as the baseline for AssetBenchmark.
+	static void BuildReference(ObjMesh& mesh);
+};
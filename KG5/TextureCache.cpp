@@ -0,0 +1,204 @@
+#include "TextureCache.h"
+#include "TextureMipmapper.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+// -------------------------------------------------------
+// File layout
+// -------------------------------------------------------
+// [TextureCacheHeader][TextureCacheLevel x mipCount][pad to 512][level data]
+// Level offsets are relative to dataOffset. Native layout, like MeshCache.
+struct TextureCacheHeader
+{
+	char magic[8] = { 'K', 'G', '5', 'T', 'E', 'X', '\0', '\0' };
+	uint32_t version = TextureCache::Version;
+	uint32_t settings = 0;
+	uint64_t sourceSize = 0;
+	int64_t sourceMtime = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t encoding = 0;
+	uint32_t mipCount = 0;
+	uint64_t dataOffset = 0;
+	uint64_t dataSize = 0;
+	uint64_t fileSize = 0;
+};
+struct TextureCacheLevel
+{
+	uint64_t offset = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t rowPitch = 0;
+	uint32_t pad = 0;
+};
+static_assert(std::is_trivially_copyable<TextureCacheHeader>::value, "header must be memcpy-able");
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static bool StatSource(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+	std::error_code ec;
+	const uintmax_t bytes = fs::file_size(path, ec);
+	if (ec) return false;
+	const fs::file_time_type t = fs::last_write_time(path, ec);
+	if (ec) return false;
+	size = (uint64_t)bytes;
+	mtime = (int64_t)t.time_since_epoch().count();
+	return true;
+}
+
+// -------------------------------------------------------
+// TextureCache
+// -------------------------------------------------------
+std::string TextureCache::PathFor(const std::string& sourcePath)
+{
+	return sourcePath + ".kg5tex";
+}
+
+bool TextureCache::Write(const std::string& sourcePath, uint32_t settings, const TextureImage& image)
+{
+	TextureCacheHeader header;
+	if (!StatSource(sourcePath, header.sourceSize, header.sourceMtime) || image.width == 0 || image.height == 0)
+		return false;
+	TextureMipLevel single;
+	const TextureView view = ViewOf(image, single);
+	header.settings = settings;
+	header.width = view.width;
+	header.height = view.height;
+	header.encoding = (uint32_t)view.encoding;
+	header.mipCount = view.mipCount;
+
+	// Padded layout: rows to 256 bytes, levels to 512
+	std::vector<TextureCacheLevel> levels(view.mipCount);
+	uint64_t dataSize = 0;
+	for (UINT m = 0; m < view.mipCount; ++m)
+	{
+		const TextureMipLevel& src = view.mips[m];
+		TextureCacheLevel& dst = levels[m];
+		dst.offset = AlignUp(dataSize, PlacementAlignment);
+		dst.width = src.width;
+		dst.height = src.height;
+		dst.rowPitch = (uint32_t)AlignUp(src.rowPitch, RowPitchAlignment);
+		dataSize = dst.offset + (uint64_t)dst.rowPitch * RowCount(view.encoding, src.height);
+	}
+	header.dataOffset = AlignUp(sizeof(TextureCacheHeader) + levels.size() * sizeof(TextureCacheLevel), PlacementAlignment);
+	header.dataSize = dataSize;
+	header.fileSize = header.dataOffset + dataSize;
+
+	std::vector<char> file((size_t)header.fileSize, 0);
+	std::memcpy(file.data(), &header, sizeof(header));
+	std::memcpy(file.data() + sizeof(header), levels.data(), levels.size() * sizeof(TextureCacheLevel));
+	for (UINT m = 0; m < view.mipCount; ++m)
+	{
+		const TextureMipLevel& src = view.mips[m];
+		char* dst = file.data() + header.dataOffset + levels[m].offset;
+		const UINT rows = RowCount(view.encoding, src.height);
+		for (UINT r = 0; r < rows; ++r)
+			std::memcpy(dst + (size_t)r * levels[m].rowPitch, view.data + src.offset + (size_t)r * src.rowPitch, src.rowPitch);
+	}
+
+	// Write to a per-thread temp file and rename, so neither a crash nor two
+	// workers cooking the same source leave a torn cache.
+	const std::string cachePath = PathFor(sourcePath);
+	const std::string tmpPath = cachePath + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	{
+		std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open()) return false;
+		out.write(file.data(), (std::streamsize)file.size());
+		if (!out.good()) return false;
+	}
+	std::error_code ec;
+	fs::rename(tmpPath, cachePath, ec);
+	if (ec)
+	{
+		fs::remove(tmpPath, ec);
+		return false;
+	}
+	return true;
+}
+
+bool TextureCache::Open(const std::string& sourcePath, uint32_t settings)
+{
+	Close();
+	uint64_t sourceSize = 0;
+	int64_t sourceMtime = 0;
+	if (!StatSource(sourcePath, sourceSize, sourceMtime) ||
+		!m_file.Open(PathFor(sourcePath)) || m_file.Size() < sizeof(TextureCacheHeader))
+	{
+		Close();
+		return false;
+	}
+	TextureCacheHeader header;
+	std::memcpy(&header, m_file.Data(), sizeof(header));
+	const TextureCacheHeader expected;
+	const uint64_t levelBytes = (uint64_t)header.mipCount * sizeof(TextureCacheLevel);
+	if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+		header.version != Version || header.settings != settings ||
+		header.sourceSize != sourceSize || header.sourceMtime != sourceMtime ||
+		header.fileSize != m_file.Size() || header.mipCount == 0 ||
+		header.width == 0 || header.height == 0 ||
+		header.mipCount > TextureMipmapper::FullChainLength(header.width, header.height) ||
+		header.encoding > (uint32_t)TextureEncoding::BC5 ||
+		sizeof(TextureCacheHeader) + levelBytes > header.dataOffset ||
+		header.dataOffset > header.fileSize || header.dataSize > header.fileSize - header.dataOffset)
+	{
+		Close();
+		return false;
+	}
+
+	const TextureEncoding encoding = (TextureEncoding)header.encoding;
+	std::vector<TextureCacheLevel> levels(header.mipCount);
+	std::memcpy(levels.data(), m_file.Data() + sizeof(header), (size_t)levelBytes);
+	m_mips.resize(header.mipCount);
+	for (uint32_t m = 0; m < header.mipCount; ++m)
+	{
+		// Levels halve from the header size, and every row must hold its
+		// texels; the upload copies RowBytes out of each rowPitch.
+		const TextureCacheLevel& l = levels[m];
+		const uint64_t bytes = (uint64_t)l.rowPitch * RowCount(encoding, l.height);
+		if (l.width != (std::max)(1u, header.width >> m) || l.height != (std::max)(1u, header.height >> m) ||
+			l.rowPitch < RowBytes(encoding, l.width) ||
+			l.offset > header.dataSize || bytes > header.dataSize - l.offset)
+		{
+			Close();
+			return false;
+		}
+		m_mips[m] = { (size_t)l.offset, l.width, l.height, l.rowPitch };
+	}
+	m_data = reinterpret_cast<const uint8_t*>(m_file.Data() + header.dataOffset);
+	m_dataSize = (size_t)header.dataSize;
+	m_width = header.width;
+	m_height = header.height;
+	m_encoding = encoding;
+	return true;
+}
+
+void TextureCache::Close()
+{
+	m_file.Close();
+	m_data = nullptr;
+	m_dataSize = 0;
+	m_mips.clear();
+}
+
+TextureView TextureCache::View() const
+{
+	TextureView view;
+	view.data = m_data;
+	view.width = m_width;
+	view.height = m_height;
+	view.encoding = m_encoding;
+	view.mips = m_mips.data();
+	view.mipCount = (UINT)m_mips.size();
+	return view;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "TextureDecoder.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+// Cooked textures (<source>.kg5tex next to the image): the final mip chain
+// in its GPU encoding, so a warm load maps the file and copies it into the
+// upload heap without decoding, mipping or compressing again.
+//
+// Levels are stored in the layout ID3D12Device::GetCopyableFootprints
+// reports for a buffer at offset 0: each level starts on a 512-byte boundary
+// and rows (of pixels or 4x4 blocks) are padded to 256 bytes. When the
+// device agrees, the whole chain is one memcpy.
+//
+// The cache is stale when the source's size or mtime differs, or when it was
+// cooked with different settings (TextureDecodePool::CookSettings).
+class TextureCache
+{
+public:
+	// Bump whenever the file layout or the cooking (mip filters, BCn encoder) changes.
+	static constexpr uint32_t Version = 1;
+	static constexpr uint32_t RowPitchAlignment = 256;   // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+	static constexpr uint32_t PlacementAlignment = 512;  // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+
+	static std::string PathFor(const std::string& sourcePath);
+	// Stores 'image' (cooked from sourcePath) with padded rows. Safe to call
+	// from several threads, also for the same source.
+	static bool Write(const std::string& sourcePath, uint32_t settings, const TextureImage& image);
+
+	// Maps the cache for sourcePath and validates it against the source file.
+	bool Open(const std::string& sourcePath, uint32_t settings);
+	void Close();
+	bool IsOpen() const { return m_data != nullptr; }
+	// Points into the mapped file; valid until Close().
+	TextureView View() const;
+	size_t DataSize() const { return m_dataSize; }
+private:
+	MappedFile m_file;
+	const uint8_t* m_data = nullptr;
+	size_t m_dataSize = 0;
+	UINT m_width = 0;
+	UINT m_height = 0;
+	TextureEncoding m_encoding = TextureEncoding::RGBA8;
+	std::vector<TextureMipLevel> m_mips;
+};
@@ -0,0 +1,599 @@
+#include "TextureCompressor.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Below this many block rows per worker the thread start-up outweighs the work.
+static const size_t MinRowsPerThread = 16;
+
+// fn(firstRow, endRow, worker)
+template <typename Fn>
+static void ParallelRows(size_t count, unsigned threadCount, Fn&& fn)
+{
+	const size_t threads = (std::min)((size_t)(std::max)(threadCount, 1u), (std::max)(count / MinRowsPerThread, (size_t)1));
+	if (threads < 2)
+	{
+		fn((size_t)0, count, (size_t)0);
+		return;
+	}
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	for (size_t i = 1; i < threads; ++i)
+		workers.emplace_back([&, i]() { fn(count * i / threads, count * (i + 1) / threads, i); });
+	fn((size_t)0, count / threads, (size_t)0);
+	for (std::thread& t : workers)
+		t.join();
+}
+
+// -------------------------------------------------------
+// Source blocks
+// -------------------------------------------------------
+// 4x4 texels of a level; texels past the edge repeat the last row/column
+// and are left out of the error.
+struct SourceBlock
+{
+	uint8_t rgba[16][4];
+	bool inside[16];
+};
+
+static void GatherBlock(const uint8_t* level, UINT width, UINT height, UINT rowPitch, UINT bx, UINT by, SourceBlock& out)
+{
+	for (UINT y = 0; y < 4; ++y)
+	{
+		for (UINT x = 0; x < 4; ++x)
+		{
+			const UINT sx = bx * 4 + x;
+			const UINT sy = by * 4 + y;
+			const UINT cx = (std::min)(sx, width - 1);
+			const UINT cy = (std::min)(sy, height - 1);
+			std::memcpy(out.rgba[y * 4 + x], level + (size_t)cy * rowPitch + (size_t)cx * 4, 4);
+			out.inside[y * 4 + x] = sx < width && sy < height;
+		}
+	}
+}
+
+static inline void Put16(uint8_t* p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static inline uint32_t Get16(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8); }
+
+// -------------------------------------------------------
+// BC1 colour block
+// -------------------------------------------------------
+static uint16_t To565(const float c[3])
+{
+	const int r = (int)((std::min)((std::max)(c[0], 0.f), 255.f) * (31.f / 255.f) + 0.5f);
+	const int g = (int)((std::min)((std::max)(c[1], 0.f), 255.f) * (63.f / 255.f) + 0.5f);
+	const int b = (int)((std::min)((std::max)(c[2], 0.f), 255.f) * (31.f / 255.f) + 0.5f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void From565(uint32_t v, int out[3])
+{
+	const int r = (v >> 11) & 31;
+	const int g = (v >> 5) & 63;
+	const int b = v & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+}
+
+// BC1 decodes c0 <= c1 as three colours plus black; BC3 always uses four.
+static void ColorPalette(uint32_t c0, uint32_t c1, bool fourColor, int palette[4][3])
+{
+	From565(c0, palette[0]);
+	From565(c1, palette[1]);
+	for (int k = 0; k < 3; ++k)
+	{
+		if (fourColor)
+		{
+			palette[2][k] = (2 * palette[0][k] + palette[1][k] + 1) / 3;
+			palette[3][k] = (palette[0][k] + 2 * palette[1][k] + 1) / 3;
+		}
+		else
+		{
+			palette[2][k] = (palette[0][k] + palette[1][k] + 1) / 2;
+			palette[3][k] = 0;
+		}
+	}
+}
+
+// Nearest palette entry per texel; returns the summed squared error
+static int ColorIndices(const SourceBlock& block, const int palette[4][3], uint32_t& indices)
+{
+	int error = 0;
+	indices = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		int best = 0;
+		int bestDist = 1 << 30;
+		for (int p = 0; p < 4; ++p)
+		{
+			const int dr = block.rgba[i][0] - palette[p][0];
+			const int dg = block.rgba[i][1] - palette[p][1];
+			const int db = block.rgba[i][2] - palette[p][2];
+			const int dist = dr * dr + dg * dg + db * db;
+			if (dist < bestDist)
+			{
+				bestDist = dist;
+				best = p;
+			}
+		}
+		indices |= (uint32_t)best << (i * 2);
+		error += bestDist;
+	}
+	return error;
+}
+
+static int EvaluateEndpoints(const SourceBlock& block, uint16_t c0, uint16_t c1, uint32_t& indices)
+{
+	int palette[4][3];
+	ColorPalette(c0, c1, true, palette);
+	return ColorIndices(block, palette, indices);
+}
+
+// Endpoints that minimize the squared error for fixed indices
+static bool LeastSquaresEndpoints(const SourceBlock& block, uint32_t indices, float e0[3], float e1[3])
+{
+	static const float weight0[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+	float aa = 0.f, bb = 0.f, ab = 0.f;
+	float ax[3] = {}, bx[3] = {};
+	for (int i = 0; i < 16; ++i)
+	{
+		const float a = weight0[(indices >> (i * 2)) & 3];
+		const float b = 1.f - a;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (int k = 0; k < 3; ++k)
+		{
+			ax[k] += a * block.rgba[i][k];
+			bx[k] += b * block.rgba[i][k];
+		}
+	}
+	const float det = aa * bb - ab * ab;
+	if (std::fabs(det) < 1e-6f)
+		return false;
+	for (int k = 0; k < 3; ++k)
+	{
+		e0[k] = (ax[k] * bb - bx[k] * ab) / det;
+		e1[k] = (bx[k] * aa - ax[k] * ab) / det;
+	}
+	return true;
+}
+
+static void EncodeColorBlock(const SourceBlock& block, uint8_t* out)
+{
+	float mean[3] = {};
+	float lo[3] = { 255.f, 255.f, 255.f }, hi[3] = {};
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			const float v = block.rgba[i][k];
+			mean[k] += v;
+			lo[k] = (std::min)(lo[k], v);
+			hi[k] = (std::max)(hi[k], v);
+		}
+	}
+	for (int k = 0; k < 3; ++k)
+		mean[k] /= 16.f;
+
+	// Principal axis of the colours by power iteration, starting from the box diagonal
+	float cov[6] = {};
+	for (int i = 0; i < 16; ++i)
+	{
+		const float r = block.rgba[i][0] - mean[0];
+		const float g = block.rgba[i][1] - mean[1];
+		const float b = block.rgba[i][2] - mean[2];
+		cov[0] += r * r;
+		cov[1] += r * g;
+		cov[2] += r * b;
+		cov[3] += g * g;
+		cov[4] += g * b;
+		cov[5] += b * b;
+	}
+	float axis[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+	for (int iter = 0; iter < 4; ++iter)
+	{
+		const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		const float m = (std::max)((std::max)(std::fabs(x), std::fabs(y)), std::fabs(z));
+		if (m < 1e-6f)
+			break;
+		axis[0] = x / m;
+		axis[1] = y / m;
+		axis[2] = z / m;
+	}
+	const float lenSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+	float e0[3], e1[3];
+	if (lenSq < 1e-12f)
+	{
+		std::memcpy(e0, mean, sizeof(e0));
+		std::memcpy(e1, mean, sizeof(e1));
+	}
+	else
+	{
+		const float invLen = 1.f / std::sqrt(lenSq);
+		for (int k = 0; k < 3; ++k)
+			axis[k] *= invLen;
+		float minP = 1e30f, maxP = -1e30f;
+		for (int i = 0; i < 16; ++i)
+		{
+			const float p = (block.rgba[i][0] - mean[0]) * axis[0] + (block.rgba[i][1] - mean[1]) * axis[1] +
+				(block.rgba[i][2] - mean[2]) * axis[2];
+			minP = (std::min)(minP, p);
+			maxP = (std::max)(maxP, p);
+		}
+		// Pull the ends in by 1/16 of the range; the extremes are rarely worth a full palette step
+		const float inset = (maxP - minP) / 16.f;
+		for (int k = 0; k < 3; ++k)
+		{
+			e0[k] = mean[k] + axis[k] * (maxP - inset);
+			e1[k] = mean[k] + axis[k] * (minP + inset);
+		}
+	}
+
+	uint16_t c0 = To565(e0), c1 = To565(e1);
+	uint32_t indices;
+	int error = EvaluateEndpoints(block, c0, c1, indices);
+	float r0[3], r1[3];
+	if (error > 0 && LeastSquaresEndpoints(block, indices, r0, r1))
+	{
+		const uint16_t q0 = To565(r0), q1 = To565(r1);
+		uint32_t refined;
+		const int refinedError = EvaluateEndpoints(block, q0, q1, refined);
+		if (refinedError < error)
+		{
+			c0 = q0;
+			c1 = q1;
+			indices = refined;
+		}
+	}
+
+	// Four-colour mode needs c0 > c1: swapping the ends flips bit 0 of every index
+	if (c0 < c1)
+	{
+		std::swap(c0, c1);
+		indices ^= 0x55555555u;
+	}
+	else if (c0 == c1)
+	{
+		indices = 0;
+	}
+	Put16(out, c0);
+	Put16(out + 2, c1);
+	Put16(out + 4, indices & 0xFFFF);
+	Put16(out + 6, indices >> 16);
+}
+
+static void DecodeColorBlock(const uint8_t* in, bool fourColor, uint8_t rgb[16][3])
+{
+	const uint32_t c0 = Get16(in), c1 = Get16(in + 2);
+	const uint32_t indices = Get16(in + 4) | (Get16(in + 6) << 16);
+	int palette[4][3];
+	ColorPalette(c0, c1, fourColor || c0 > c1, palette);
+	for (int i = 0; i < 16; ++i)
+	{
+		const int* p = palette[(indices >> (i * 2)) & 3];
+		for (int k = 0; k < 3; ++k)
+			rgb[i][k] = (uint8_t)p[k];
+	}
+}
+
+// -------------------------------------------------------
+// BC4 channel block
+// -------------------------------------------------------
+static void ChannelPalette(int a0, int a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+	if (a0 > a1)
+	{
+		for (int i = 2; i < 8; ++i)
+			palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+	}
+	else
+	{
+		for (int i = 2; i < 6; ++i)
+			palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void EncodeChannelBlock(const SourceBlock& block, int channel, uint8_t* out)
+{
+	int lo = 255, hi = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		lo = (std::min)(lo, (int)block.rgba[i][channel]);
+		hi = (std::max)(hi, (int)block.rgba[i][channel]);
+	}
+	std::memset(out, 0, 8);
+	out[0] = (uint8_t)hi;
+	out[1] = (uint8_t)lo;
+	if (hi == lo)
+		return;
+
+	int palette[8];
+	ChannelPalette(hi, lo, palette);
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		const int v = block.rgba[i][channel];
+		int best = 0;
+		int bestDist = 1 << 30;
+		for (int p = 0; p < 8; ++p)
+		{
+			const int dist = std::abs(v - palette[p]);
+			if (dist < bestDist)
+			{
+				bestDist = dist;
+				best = p;
+			}
+		}
+		bits |= (uint64_t)best << (i * 3);
+	}
+	for (int b = 0; b < 6; ++b)
+		out[2 + b] = (uint8_t)(bits >> (b * 8));
+}
+
+static void DecodeChannelBlock(const uint8_t* in, uint8_t values[16])
+{
+	int palette[8];
+	ChannelPalette(in[0], in[1], palette);
+	uint64_t bits = 0;
+	for (int b = 0; b < 6; ++b)
+		bits |= (uint64_t)in[2 + b] << (b * 8);
+	for (int i = 0; i < 16; ++i)
+		values[i] = (uint8_t)palette[(bits >> (i * 3)) & 7];
+}
+
+// -------------------------------------------------------
+// Blocks by encoding
+// -------------------------------------------------------
+static UINT BlockBytes(TextureEncoding e)
+{
+	return (e == TextureEncoding::BC1 || e == TextureEncoding::BC4) ? 8 : 16;
+}
+
+// Encodes one block, decodes it again and returns the squared error over
+// the encoded channels of the texels inside the level.
+static double EncodeBlock(const SourceBlock& block, TextureEncoding encoding, uint8_t* out, size_t& samples)
+{
+	uint8_t decoded[16][4];
+	int channels = 0;
+	switch (encoding)
+	{
+	case TextureEncoding::BC1:
+	{
+		EncodeColorBlock(block, out);
+		uint8_t rgb[16][3];
+		DecodeColorBlock(out, false, rgb);
+		for (int i = 0; i < 16; ++i)
+			std::memcpy(decoded[i], rgb[i], 3);
+		channels = 3;
+		break;
+	}
+	case TextureEncoding::BC3:
+	{
+		EncodeChannelBlock(block, 3, out);
+		EncodeColorBlock(block, out + 8);
+		uint8_t rgb[16][3], alpha[16];
+		DecodeColorBlock(out + 8, true, rgb);
+		DecodeChannelBlock(out, alpha);
+		for (int i = 0; i < 16; ++i)
+		{
+			std::memcpy(decoded[i], rgb[i], 3);
+			decoded[i][3] = alpha[i];
+		}
+		channels = 4;
+		break;
+	}
+	case TextureEncoding::BC4:
+	{
+		EncodeChannelBlock(block, 0, out);
+		uint8_t r[16];
+		DecodeChannelBlock(out, r);
+		for (int i = 0; i < 16; ++i)
+			decoded[i][0] = r[i];
+		channels = 1;
+		break;
+	}
+	default:
+	{
+		EncodeChannelBlock(block, 0, out);
+		EncodeChannelBlock(block, 1, out + 8);
+		uint8_t r[16], g[16];
+		DecodeChannelBlock(out, r);
+		DecodeChannelBlock(out + 8, g);
+		for (int i = 0; i < 16; ++i)
+		{
+			decoded[i][0] = r[i];
+			decoded[i][1] = g[i];
+		}
+		channels = 2;
+		break;
+	}
+	}
+
+	double error = 0.0;
+	for (int i = 0; i < 16; ++i)
+	{
+		if (!block.inside[i])
+			continue;
+		for (int k = 0; k < channels; ++k)
+		{
+			const int d = (int)block.rgba[i][k] - decoded[i][k];
+			error += d * d;
+		}
+		samples += channels;
+	}
+	return error;
+}
+
+// -------------------------------------------------------
+// Images
+// -------------------------------------------------------
+bool TextureCompressor::Compress(TextureImage& image, TextureCompression mode,
+	const TextureCompressOptions& options, Stats* stats)
+{
+	const auto start = std::chrono::steady_clock::now();
+	if (mode == TextureCompression::None)
+		return false;
+	if (image.encoding != TextureEncoding::RGBA8 || image.width == 0 || image.height == 0 ||
+		image.width % 4 != 0 || image.height % 4 != 0)
+	{
+		if (stats)
+			++stats->skipped;
+		return false;
+	}
+
+	std::vector<TextureMipLevel> source = image.mips;
+	if (source.empty())
+		source.push_back({ 0, image.width, image.height, image.rowPitch });
+
+	TextureEncoding encoding = TextureEncoding::BC5;
+	if (mode == TextureCompression::Height)
+	{
+		encoding = TextureEncoding::BC4;
+	}
+	else if (mode == TextureCompression::Color)
+	{
+		// Levels below are averages of level 0, so they are opaque when it is
+		encoding = TextureEncoding::BC1;
+		const TextureMipLevel& top = source[0];
+		for (UINT y = 0; y < top.height && encoding == TextureEncoding::BC1; ++y)
+		{
+			const uint8_t* row = image.pixels.data() + top.offset + (size_t)y * top.rowPitch;
+			for (UINT x = 0; x < top.width; ++x)
+			{
+				if (row[x * 4 + 3] != 255)
+				{
+					encoding = TextureEncoding::BC3;
+					break;
+				}
+			}
+		}
+	}
+
+	const UINT blockBytes = BlockBytes(encoding);
+	std::vector<TextureMipLevel> levels(source.size());
+	size_t total = 0;
+	for (size_t m = 0; m < source.size(); ++m)
+	{
+		const UINT blocksWide = (source[m].width + 3) / 4;
+		levels[m] = { total, source[m].width, source[m].height, blocksWide * blockBytes };
+		total += (size_t)levels[m].rowPitch * RowCount(encoding, source[m].height);
+	}
+
+	const unsigned threadCount = options.threadCount ? options.threadCount : std::thread::hardware_concurrency();
+	std::vector<uint8_t> compressed(total);
+	std::vector<double> errors((std::max)(threadCount, 1u), 0.0);
+	std::vector<size_t> samples(errors.size(), 0);
+	for (size_t m = 0; m < source.size(); ++m)
+	{
+		const TextureMipLevel& src = source[m];
+		const TextureMipLevel& dst = levels[m];
+		const uint8_t* srcBytes = image.pixels.data() + src.offset;
+		ParallelRows(RowCount(encoding, src.height), threadCount, [&](size_t first, size_t end, size_t worker)
+		{
+			SourceBlock block;
+			for (size_t by = first; by < end; ++by)
+			{
+				uint8_t* row = compressed.data() + dst.offset + by * dst.rowPitch;
+				for (UINT bx = 0; bx * 4 < src.width; ++bx)
+				{
+					GatherBlock(srcBytes, src.width, src.height, src.rowPitch, bx, (UINT)by, block);
+					errors[worker] += EncodeBlock(block, encoding, row + (size_t)bx * blockBytes, samples[worker]);
+				}
+			}
+		});
+	}
+
+	if (stats)
+	{
+		const int e = (int)encoding;
+		++stats->imageCount[e];
+		for (size_t w = 0; w < errors.size(); ++w)
+		{
+			stats->squaredError[e] += errors[w];
+			stats->sampleCount[e] += samples[w];
+		}
+		stats->bytesBefore += image.pixels.size();
+		stats->bytesAfter += compressed.size();
+	}
+
+	image.pixels.swap(compressed);
+	image.rowPitch = levels[0].rowPitch;
+	image.mips = levels;
+	image.encoding = encoding;
+
+	if (stats)
+		stats->milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+void TextureCompressor::Stats::Add(const Stats& other)
+{
+	for (int e = 0; e < 5; ++e)
+	{
+		imageCount[e] += other.imageCount[e];
+		squaredError[e] += other.squaredError[e];
+		sampleCount[e] += other.sampleCount[e];
+	}
+	bytesBefore += other.bytesBefore;
+	bytesAfter += other.bytesAfter;
+	skipped += other.skipped;
+	milliseconds += other.milliseconds;
+}
+
+double TextureCompressor::Stats::Psnr(TextureEncoding e) const
+{
+	const int i = (int)e;
+	if (sampleCount[i] == 0)
+		return 0.0;
+	const double mse = squaredError[i] / (double)sampleCount[i];
+	return (mse > 0.0) ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+std::string TextureCompressor::Format(const Stats& s)
+{
+	static const char* names[5] = { "RGBA8", "BC1", "BC3", "BC4", "BC5" };
+	size_t images = 0;
+	std::string psnr;
+	for (int e = 1; e < 5; ++e)
+	{
+		images += s.imageCount[e];
+		if (s.imageCount[e] == 0)
+			continue;
+		char part[64];
+		std::snprintf(part, sizeof(part), "%s%s x%zu %.1f dB", psnr.empty() ? "" : ", ", names[e], s.imageCount[e],
+			s.Psnr((TextureEncoding)e));
+		psnr += part;
+	}
+	char buf[512];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[BCn] %zu images (%zu skipped): %.1f -> %.1f MB (%.1fx), PSNR %s, %.1f ms\n",
+		images,
+		s.skipped,
+		(double)s.bytesBefore / (1024.0 * 1024.0),
+		(double)s.bytesAfter / (1024.0 * 1024.0),
+		(s.bytesAfter > 0) ? (double)s.bytesBefore / (double)s.bytesAfter : 0.0,
+		psnr.empty() ? "-" : psnr.c_str(),
+		s.milliseconds);
+	return buf;
+}
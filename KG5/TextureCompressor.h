@@ -0,0 +1,49 @@
+#pragma once
+#include "TextureDecoder.h"
+#include <string>
+// CPU block compression of RGBA8 images (every mip level) to BC1/BC3/BC4/BC5.
+// Colour endpoints come from the principal axis of each block and are
+// refined once by least squares; BC4/BC5 channels use the block's range.
+// Quality is measured while encoding: every block is decoded again and
+// compared with its source texels.
+enum class TextureCompression
+{
+	None,
+	Color,     // BC1, or BC3 when any texel has alpha below 255
+	NormalMap, // BC5 from x/y; the shader rebuilds z
+	Height,    // BC4 from the red channel
+};
+
+struct TextureCompressOptions
+{
+	// 0 = std::thread::hardware_concurrency(). Block rows are split between
+	// threads; use 1 when images are already compressed in parallel.
+	unsigned threadCount = 0;
+};
+
+class TextureCompressor
+{
+public:
+	struct Stats
+	{
+		size_t imageCount[5] = {};  // indexed by TextureEncoding
+		double squaredError[5] = {}; // over encoded channels of every level
+		size_t sampleCount[5] = {};
+		size_t bytesBefore = 0;
+		size_t bytesAfter = 0;
+		size_t skipped = 0; // level 0 not a multiple of 4, or not RGBA8
+		double milliseconds = 0.0;
+
+		void Add(const Stats& other);
+		// Peak signal-to-noise ratio in dB for one encoding (0 if unused)
+		double Psnr(TextureEncoding e) const;
+	};
+
+	// Replaces image.pixels (and image.mips) with the compressed chain. False
+	// and untouched when the mode is None or the image cannot be compressed:
+	// D3D12 requires level 0 of a BC texture to be a multiple of 4 texels.
+	static bool Compress(TextureImage& image, TextureCompression mode,
+		const TextureCompressOptions& options = TextureCompressOptions(), Stats* stats = nullptr);
+
+	static std::string Format(const Stats& s);
+};
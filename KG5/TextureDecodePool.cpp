@@ -0,0 +1,159 @@
+#include "TextureDecodePool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// Per-worker counters, summed after the join
+struct DecodeWorkerStats
+{
+	size_t decodedCount = 0;
+	size_t candidatesTried = 0;
+	size_t pixelCount = 0;
+	size_t cacheHits = 0;
+	size_t cacheWrites = 0;
+	size_t deferredCount = 0;
+	TextureMipmapper::Stats mips;
+	TextureCompressor::Stats compression;
+	double decodeMs = 0.0;
+};
+
+static void DecodeJob(TextureDecodeJob& job, DecodeWorkerStats& stats)
+{
+	const auto start = std::chrono::steady_clock::now();
+	job.image = TextureImage{};
+	job.cooked.reset();
+	job.decodedCandidate = -1;
+	const uint32_t settings = TextureDecodePool::CookSettings(job);
+	const bool deferPixels = job.decodeAtUpload && !job.generateMips && job.compression == TextureCompression::None;
+	for (size_t c = 0; c < job.candidates.size(); ++c)
+	{
+		++stats.candidatesTried;
+		if (job.useCache)
+		{
+			std::unique_ptr<TextureCache> cache(new TextureCache());
+			if (cache->Open(job.candidates[c], settings))
+			{
+				job.decodedCandidate = (int)c;
+				++stats.decodedCount;
+				++stats.cacheHits;
+				const TextureView view = cache->View();
+				stats.pixelCount += (size_t)view.width * view.height;
+				job.cooked = std::move(cache);
+				break;
+			}
+		}
+		if (deferPixels)
+		{
+			if (!TextureDecoder::ReadInfo(job.candidates[c], job.image.width, job.image.height))
+				continue;
+			job.image.rowPitch = job.image.width * 4;
+			job.decodedCandidate = (int)c;
+			++stats.decodedCount;
+			++stats.deferredCount;
+			stats.pixelCount += (size_t)job.image.width * job.image.height;
+			break;
+		}
+		if (TextureDecoder::LoadFromFile(job.candidates[c], job.image, job.generateMips))
+		{
+			job.decodedCandidate = (int)c;
+			++stats.decodedCount;
+			stats.pixelCount += (size_t)job.image.width * job.image.height;
+			if (job.generateMips)
+				TextureMipmapper::Generate(job.image, job.mipFilter, &stats.mips);
+			// Jobs already run in parallel, so each image is compressed on one thread
+			TextureCompressOptions compressOptions;
+			compressOptions.threadCount = 1;
+			TextureCompressor::Compress(job.image, job.compression, compressOptions, &stats.compression);
+			if (job.useCache && TextureCache::Write(job.candidates[c], settings, job.image))
+				++stats.cacheWrites;
+			break;
+		}
+	}
+	job.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	stats.decodeMs += job.milliseconds;
+}
+
+TextureDecodePool::Stats TextureDecodePool::Decode(std::vector<TextureDecodeJob>& jobs, unsigned threadCount)
+{
+	const auto start = std::chrono::steady_clock::now();
+	Stats stats;
+	std::vector<size_t> queue;
+	queue.reserve(jobs.size());
+	for (size_t j = 0; j < jobs.size(); ++j)
+	{
+		if (jobs[j].sharedWith < 0)
+			queue.push_back(j);
+	}
+	stats.jobCount = queue.size();
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	const size_t threads = (std::min)((size_t)(std::max)(threadCount, 1u), (std::max)(queue.size(), (size_t)1));
+	stats.threadCount = (unsigned)threads;
+
+	// Jobs differ a lot in size (missing files vs 4k TGAs), so workers claim
+	// them one at a time instead of taking fixed ranges.
+	std::atomic<size_t> next(0);
+	std::vector<DecodeWorkerStats> workerStats(threads);
+	auto work = [&](size_t worker)
+	{
+		for (size_t j = next++; j < queue.size(); j = next++)
+			DecodeJob(jobs[queue[j]], workerStats[worker]);
+	};
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	for (size_t i = 1; i < threads; ++i)
+		workers.emplace_back(work, i);
+	work(0);
+	for (std::thread& t : workers)
+		t.join();
+
+	for (const DecodeWorkerStats& w : workerStats)
+	{
+		stats.decodedCount += w.decodedCount;
+		stats.candidatesTried += w.candidatesTried;
+		stats.pixelCount += w.pixelCount;
+		stats.cacheHits += w.cacheHits;
+		stats.cacheWrites += w.cacheWrites;
+		stats.deferredCount += w.deferredCount;
+		stats.mips.imageCount += w.mips.imageCount;
+		stats.mips.levelCount += w.mips.levelCount;
+		stats.mips.bytesAdded += w.mips.bytesAdded;
+		stats.mips.milliseconds += w.mips.milliseconds;
+		stats.compression.Add(w.compression);
+		stats.decodeMs += w.decodeMs;
+	}
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+uint32_t TextureDecodePool::CookSettings(const TextureDecodeJob& job)
+{
+	const uint32_t mipFilter = job.generateMips ? 1u + (uint32_t)job.mipFilter : 0u;
+	return (mipFilter << 8) | (uint32_t)job.compression;
+}
+
+std::string TextureDecodePool::Format(const Stats& s)
+{
+	char buf[384];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[Textures] loaded %zu / %zu slots (%zu cooked, %zu cooked now, %zu at upload, %zu files tried, %.1f Mpixel, %zu with mips) on %u threads: "
+		"%.1f ms (%.1f ms summed over jobs, %.1f ms of it mips)\n",
+		s.decodedCount,
+		s.jobCount,
+		s.cacheHits,
+		s.cacheWrites,
+		s.deferredCount,
+		s.candidatesTried,
+		(double)s.pixelCount / 1e6,
+		s.mips.imageCount,
+		s.threadCount,
+		s.milliseconds,
+		s.decodeMs,
+		s.mips.milliseconds);
+	return buf;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "TextureDecoder.h"
+#include "TextureMipmapper.h"
+#include "TextureCompressor.h"
+#include "TextureCache.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+// Decodes many texture files at once. Every job is one texture slot (a
+// material's diffuse, normal or displacement map) with its candidate files
+// in priority order; the first candidate that decodes fills the slot.
+// Results stay in job order, so the caller records GPU uploads
+// deterministically afterwards.
+struct TextureDecodeJob
+{
+	std::vector<std::string> candidates;
+	// Build the mip chain on the worker right after decoding, then block-compress it
+	bool generateMips = false;
+	TextureMipFilter mipFilter = TextureMipFilter::Srgb;
+	TextureCompression compression = TextureCompression::None;
+	// Map <candidate>.kg5tex when it matches these settings, and cook it after a decode
+	bool useCache = false;
+	// Single-level, uncompressed jobs only: Decode reads just the size, and
+	// the upload decodes into staging memory (TextureLoader::CreateTextureFromFile).
+	// The header is all Decode checks, so the upload must fall back to the
+	// later candidates itself and update decodedCandidate.
+	// A matching cache file is still used; none is written.
+	bool decodeAtUpload = false;
+	// Index of an earlier job that loads the same texture (TextureRegistry::Share).
+	// Decode skips such jobs; their results stay empty.
+	int sharedWith = -1;
+
+	// Filled by TextureDecodePool::Decode. On a cache hit 'cooked' is open
+	// and 'image' stays empty.
+	TextureImage image;
+	std::unique_ptr<TextureCache> cooked;
+	int decodedCandidate = -1; // index into candidates, -1 = none decoded
+	double milliseconds = 0.0;
+
+	// Left for the upload by decodeAtUpload: 'image' has the size but no pixels
+	bool PixelsPending() const { return decodedCandidate >= 0 && !cooked && image.pixels.empty(); }
+	// 'single' as for ViewOf
+	TextureView View(TextureMipLevel& single) const { return cooked ? cooked->View() : ViewOf(image, single); }
+};
+
+class TextureDecodePool
+{
+public:
+	struct Stats
+	{
+		size_t jobCount = 0;       // without shared jobs
+		size_t decodedCount = 0;   // jobs with an image
+		size_t candidatesTried = 0; // files opened, including missing ones
+		size_t pixelCount = 0;     // level 0 only
+		size_t cacheHits = 0;
+		size_t cacheWrites = 0;
+		size_t deferredCount = 0;  // left to decode at upload
+		TextureMipmapper::Stats mips;
+		TextureCompressor::Stats compression;
+		unsigned threadCount = 0;
+		double decodeMs = 0.0; // summed over jobs
+		double milliseconds = 0.0; // wall clock
+	};
+
+	// Workers take the next unclaimed job until none are left.
+	// threadCount 0 = std::thread::hardware_concurrency(); never more
+	// threads than jobs, and 1 decodes on the calling thread.
+	static Stats Decode(std::vector<TextureDecodeJob>& jobs, unsigned threadCount = 0);
+	// TextureCache key for what a job produces (mips, filter, compression)
+	static uint32_t CookSettings(const TextureDecodeJob& job);
+
+	static std::string Format(const Stats& s);
+};
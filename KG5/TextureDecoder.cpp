@@ -0,0 +1,151 @@
+#include "TextureDecoder.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// -------------------------------------------------------
+// Uncompressed TGA
+// -------------------------------------------------------
+// Type 2 (true-color, no color map, no RLE) at 24 or 32 bits stores plain
+// BGR(A) rows, so the pixels go straight from the mapped file into their
+// destination. Other TGAs (RLE, palettes, grayscale, right-to-left) are
+// left to stb_image.
+struct RawTga
+{
+	const uint8_t* rows = nullptr; // first row in the file
+	UINT width = 0;
+	UINT height = 0;
+	UINT bytesPerPixel = 0;
+	bool topDown = false;
+};
+
+static bool ParseRawTga(const MappedFile& file, RawTga& tga)
+{
+	const size_t HeaderSize = 18;
+	if (file.Size() < HeaderSize) return false;
+	const uint8_t* header = reinterpret_cast<const uint8_t*>(file.Data());
+	const uint8_t idLength = header[0];
+	const uint8_t colorMapType = header[1];
+	const uint8_t imageType = header[2];
+	const uint8_t bitsPerPixel = header[16];
+	const uint8_t descriptor = header[17];
+	if (colorMapType != 0 || imageType != 2 || (bitsPerPixel != 24 && bitsPerPixel != 32) || (descriptor & 0x10) != 0)
+		return false;
+	tga.width = header[12] | (header[13] << 8);
+	tga.height = header[14] | (header[15] << 8);
+	tga.bytesPerPixel = bitsPerPixel / 8;
+	tga.topDown = (descriptor & 0x20) != 0;
+	const size_t dataSize = (size_t)tga.width * tga.height * tga.bytesPerPixel;
+	if (tga.width == 0 || tga.height == 0 || file.Size() - HeaderSize < idLength ||
+		file.Size() - HeaderSize - idLength < dataSize)
+	{
+		return false; // truncated files get stb_image's zero fill
+	}
+	tga.rows = header + HeaderSize + idLength;
+	return true;
+}
+
+// BGR(A) -> RGBA8, flipped to top-down, 'rowPitch' bytes between rows.
+// Whole pixels are written in order, which suits write-combined memory.
+static void ReadRawTga(const RawTga& tga, uint8_t* dst, size_t rowPitch)
+{
+	const size_t srcPitch = (size_t)tga.width * tga.bytesPerPixel;
+	for (UINT y = 0; y < tga.height; ++y)
+	{
+		const uint8_t* src = tga.rows + (size_t)(tga.topDown ? y : tga.height - 1 - y) * srcPitch;
+		uint8_t* row = dst + (size_t)y * rowPitch;
+		for (UINT x = 0; x < tga.width; ++x, src += tga.bytesPerPixel)
+		{
+			const uint8_t alpha = (tga.bytesPerPixel == 4) ? src[3] : 0xFF;
+			const uint32_t rgba = src[2] | (src[1] << 8) | (src[0] << 16) | ((uint32_t)alpha << 24);
+			std::memcpy(row + (size_t)x * 4, &rgba, 4);
+		}
+	}
+}
+
+// -------------------------------------------------------
+// TextureDecoder
+// -------------------------------------------------------
+bool TextureDecoder::LoadFromFile(const std::string& path, TextureImage& out, bool reserveMipChain)
+{
+	MappedFile file;
+	RawTga tga;
+	const bool raw = file.Open(path) && ParseRawTga(file, tga);
+	int w = 0, h = 0, channels = 0;
+	unsigned char* data = nullptr;
+	if (raw)
+	{
+		w = (int)tga.width;
+		h = (int)tga.height;
+	}
+	else
+	{
+		file.Close();
+		data = stbi_load(path.c_str(), &w, &h, &channels, 4);
+		if (!data) return false;
+	}
+
+	out.width = (UINT)w;
+	out.height = (UINT)h;
+	out.rowPitch = (UINT)w * 4;
+	const size_t bytes = (size_t)w * h * 4;
+	if (reserveMipChain)
+	{
+		size_t chainBytes = 0;
+		for (size_t cw = (size_t)w, ch = (size_t)h;; cw = (std::max)(cw / 2, (size_t)1), ch = (std::max)(ch / 2, (size_t)1))
+		{
+			chainBytes += cw * ch * 4;
+			if (cw == 1 && ch == 1)
+				break;
+		}
+		out.pixels.reserve(chainBytes);
+	}
+	if (raw)
+	{
+		out.pixels.resize(bytes);
+		ReadRawTga(tga, out.pixels.data(), out.rowPitch);
+		return true;
+	}
+	out.pixels.assign(data, data + bytes);
+
+	stbi_image_free(data);
+	return true;
+}
+
+bool TextureDecoder::ReadInfo(const std::string& path, UINT& width, UINT& height)
+{
+	int w = 0, h = 0, channels = 0;
+	if (!stbi_info(path.c_str(), &w, &h, &channels) || w <= 0 || h <= 0)
+		return false;
+	width = (UINT)w;
+	height = (UINT)h;
+	return true;
+}
+
+bool TextureDecoder::LoadInto(const std::string& path, uint8_t* dst, UINT rowPitch, UINT width, UINT height)
+{
+	if (rowPitch < width * 4) return false;
+	MappedFile file;
+	RawTga tga;
+	if (file.Open(path) && ParseRawTga(file, tga))
+	{
+		if (tga.width != width || tga.height != height) return false;
+		ReadRawTga(tga, dst, rowPitch);
+		return true;
+	}
+	file.Close();
+
+	int w, h, channels;
+	unsigned char* data = stbi_load(path.c_str(), &w, &h, &channels, 4);
+	if (!data) return false;
+	const bool sizeMatches = (UINT)w == width && (UINT)h == height;
+	if (sizeMatches)
+	{
+		for (UINT y = 0; y < height; ++y)
+			std::memcpy(dst + (size_t)y * rowPitch, data + (size_t)y * width * 4, (size_t)width * 4);
+	}
+	stbi_image_free(data);
+	return sizeMatches;
+}
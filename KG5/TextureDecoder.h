@@ -0,0 +1,88 @@
+#pragma once
+#include "AssetTypes.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+// Platform-neutral half of TextureLoader: image files to tightly packed
+// RGBA8 pixels. The D3D12 upload stays in TextureLoader.
+// Layout of TextureImage::pixels
+enum class TextureEncoding
+{
+	RGBA8,
+	BC1, // 8 bytes per 4x4 block, RGB
+	BC3, // 16 bytes per block, RGBA
+	BC4, // 8 bytes per block, R
+	BC5, // 16 bytes per block, RG
+};
+inline bool IsBlockCompressed(TextureEncoding e) { return e != TextureEncoding::RGBA8; }
+// Rows of pixels, or of 4x4 blocks, in a level 'height' texels tall
+inline UINT RowCount(TextureEncoding e, UINT height) { return IsBlockCompressed(e) ? (height + 3) / 4 : height; }
+// Bytes in one of those rows for a level 'width' texels wide
+inline uint64_t RowBytes(TextureEncoding e, UINT width)
+{
+	if (!IsBlockCompressed(e)) return (uint64_t)width * 4;
+	const uint64_t blockBytes = (e == TextureEncoding::BC1 || e == TextureEncoding::BC4) ? 8 : 16;
+	return (uint64_t)((width + 3) / 4) * blockBytes;
+}
+
+struct TextureMipLevel
+{
+	size_t offset = 0; // into TextureImage::pixels
+	UINT width = 0;    // texels
+	UINT height = 0;
+	UINT rowPitch = 0; // bytes per row of pixels or blocks
+};
+struct TextureImage
+{
+	std::vector<uint8_t> pixels; // level 0, then the rest of the chain if any
+	UINT width = 0;
+	UINT height = 0;
+	UINT rowPitch = 0;
+	// Every level including 0 once a chain was built (TextureMipmapper);
+	// empty when 'pixels' holds level 0 only.
+	std::vector<TextureMipLevel> mips;
+	TextureEncoding encoding = TextureEncoding::RGBA8;
+
+	UINT MipCount() const { return mips.empty() ? 1u : (UINT)mips.size(); }
+};
+// Non-owning description of a mip chain in memory (a TextureImage or a
+// mapped TextureCache file), as the GPU upload consumes it.
+struct TextureView
+{
+	const uint8_t* data = nullptr;
+	UINT width = 0;
+	UINT height = 0;
+	TextureEncoding encoding = TextureEncoding::RGBA8;
+	const TextureMipLevel* mips = nullptr;
+	UINT mipCount = 0;
+};
+// 'single' receives level 0 when the image has no chain; it must outlive the view.
+inline TextureView ViewOf(const TextureImage& image, TextureMipLevel& single)
+{
+	single = { 0, image.width, image.height, image.rowPitch };
+	TextureView view;
+	view.data = image.pixels.data();
+	view.width = image.width;
+	view.height = image.height;
+	view.encoding = image.encoding;
+	view.mips = image.mips.empty() ? &single : image.mips.data();
+	view.mipCount = image.MipCount();
+	return view;
+}
+class TextureDecoder
+{
+public:
+	// Any format stb_image reads (TGA, PNG, JPG, BMP, ...), expanded to 4 channels.
+	// reserveMipChain leaves capacity for a full chain after level 0, so
+	// TextureMipmapper does not reallocate and copy the image.
+	// Uncompressed 24/32-bit TGAs are read straight from the mapped file.
+	static bool LoadFromFile(const std::string& path, TextureImage& out, bool reserveMipChain = false);
+	// Size from the file header, without decoding
+	static bool ReadInfo(const std::string& path, UINT& width, UINT& height);
+	// Decodes level 0 straight into caller memory (e.g. a mapped staging
+	// footprint): 'height' rows of 'width' RGBA8 pixels, 'rowPitch' bytes
+	// apart. Fails when the file is not width x height (see ReadInfo).
+	// Uncompressed TGAs never touch an intermediate buffer; other formats
+	// are copied once from stb_image's.
+	static bool LoadInto(const std::string& path, uint8_t* dst, UINT rowPitch, UINT width, UINT height);
+};
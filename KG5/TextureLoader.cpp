@@ -1,27 +1,27 @@
 #include "TextureLoader.h"
 #include <wincodec.h>
 #include <stdexcept>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 
 bool TextureLoader::LoadFromFile(const std::wstring& path, TextureData& out)
 {
 	//  wstring  string
 	std::string narrowPath(path.begin(), path.end());
 
-	int w, h, channels;
-	unsigned char* data = stbi_load(narrowPath.c_str(), &w, &h, &channels, 4);
-	if (!data) return false;
-
-	out.width = (UINT)w;
-	out.height = (UINT)h;
+	if (!TextureDecoder::LoadFromFile(narrowPath, out)) return false;
 	out.format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	out.rowPitch = (UINT)w * 4;
-	out.pixels.assign(data, data + (size_t)w * h * 4);
-
-	stbi_image_free(data);
 	return true;
 }
+DXGI_FORMAT TextureLoader::FormatFor(TextureEncoding encoding)
+{
+	switch (encoding)
+	{
+	case TextureEncoding::BC1: return DXGI_FORMAT_BC1_UNORM;
+	case TextureEncoding::BC3: return DXGI_FORMAT_BC3_UNORM;
+	case TextureEncoding::BC4: return DXGI_FORMAT_BC4_UNORM;
+	case TextureEncoding::BC5: return DXGI_FORMAT_BC5_UNORM;
+	default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
 // -------------------------------------------------------
 // Upload to GPU default heap
 // -------------------------------------------------------
@@ -32,14 +32,35 @@ bool TextureLoader::CreateTexture(
 	ComPtr<ID3D12Resource>& texture,
 	ComPtr<ID3D12Resource>& uploadBuf)
 {
-	// Default heap texture
+	TextureMipLevel single;
+	return CreateTexture(device, cmdList, ViewOf(data, single), data.format, texture, uploadBuf);
+}
+
+// Default heap texture for the view, and where its levels go in a staging
+// buffer starting at offset 0
+struct TextureUploadLayout
+{
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+	std::vector<UINT> numRows;
+	std::vector<UINT64> rowSizes;
+	UINT64 uploadSize = 0;
+};
+
+static bool CreateDestination(
+	ID3D12Device* device,
+	const TextureView& view,
+	DXGI_FORMAT format,
+	ComPtr<ID3D12Resource>& texture,
+	TextureUploadLayout& upload)
+{
 	D3D12_RESOURCE_DESC texDesc{};
 	texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	texDesc.Width = data.width;
-	texDesc.Height = data.height;
+	texDesc.Width = view.width;
+	texDesc.Height = view.height;
 	texDesc.DepthOrArraySize = 1;
-	texDesc.MipLevels = 1;
-	texDesc.Format = data.format;
+	const UINT mipCount = view.mipCount;
+	texDesc.MipLevels = (UINT16)mipCount;
+	texDesc.Format = format;
 	texDesc.SampleDesc = { 1, 0 };
 	CD3DX12_HEAP_PROPERTIES defHeap(D3D12_HEAP_TYPE_DEFAULT);
 	HRESULT hr = device->CreateCommittedResource(
@@ -47,28 +68,148 @@ bool TextureLoader::CreateTexture(
 		D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
 		IID_PPV_ARGS(&texture));
 	if (FAILED(hr)) return false;
+	upload.layouts.resize(mipCount);
+	upload.numRows.resize(mipCount);
+	upload.rowSizes.resize(mipCount);
+	device->GetCopyableFootprints(&texDesc, 0, mipCount, 0,
+		upload.layouts.data(), upload.numRows.data(), upload.rowSizes.data(), &upload.uploadSize);
+	return true;
+}
+
+// Records the level copies out of 'staging' (laid out as 'upload', from
+// stagingOffset) and the transition to shader resource
+static void RecordCopies(
+	ID3D12GraphicsCommandList* cmdList,
+	ID3D12Resource* texture,
+	const TextureUploadLayout& upload,
+	ID3D12Resource* staging,
+	UINT64 stagingOffset)
+{
+	for (UINT m = 0; m < (UINT)upload.layouts.size(); ++m)
+	{
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = upload.layouts[m];
+		layout.Offset += stagingOffset;
+		const CD3DX12_TEXTURE_COPY_LOCATION dst(texture, m);
+		const CD3DX12_TEXTURE_COPY_LOCATION src(staging, layout);
+		cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	}
+	// Transition to shader resource
+	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+		texture,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	cmdList->ResourceBarrier(1, &barrier);
+}
+
+// Writes the chain into staging memory ('cpu' = 'staging' at stagingOffset)
+// and records the copies
+static void RecordUpload(
+	ID3D12GraphicsCommandList* cmdList,
+	const TextureView& view,
+	ID3D12Resource* texture,
+	const TextureUploadLayout& upload,
+	ID3D12Resource* staging,
+	UINT64 stagingOffset,
+	uint8_t* cpu)
+{
+	// Cooked chains (TextureCache) are already laid out like the footprints:
+	// copy the whole chain at once.
+	bool footprintLayout = true;
+	for (UINT m = 0; m < view.mipCount; ++m)
+	{
+		footprintLayout = footprintLayout &&
+			upload.layouts[m].Offset == view.mips[m].offset &&
+			upload.layouts[m].Footprint.RowPitch == view.mips[m].rowPitch;
+	}
+	if (footprintLayout)
+	{
+		memcpy(cpu, view.data, (size_t)upload.uploadSize);
+	}
+	else
+	{
+		for (UINT m = 0; m < view.mipCount; ++m)
+		{
+			const TextureMipLevel& level = view.mips[m];
+			const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = upload.layouts[m];
+			for (UINT r = 0; r < upload.numRows[m]; ++r)
+			{
+				memcpy(cpu + layout.Offset + (size_t)r * layout.Footprint.RowPitch,
+					view.data + level.offset + (size_t)r * level.rowPitch,
+					(size_t)upload.rowSizes[m]);
+			}
+		}
+	}
+	RecordCopies(cmdList, texture, upload, staging, stagingOffset);
+}
+
+bool TextureLoader::CreateTexture(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	const TextureView& view,
+	DXGI_FORMAT format,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& uploadBuf)
+{
+	TextureUploadLayout upload;
+	if (!CreateDestination(device, view, format, texture, upload)) return false;
 	// Upload heap buffer
-	UINT64 uploadSize = 0;
-	device->GetCopyableFootprints(&texDesc, 0, 1, 0, nullptr, nullptr, nullptr, &uploadSize);
 	CD3DX12_HEAP_PROPERTIES upHeap(D3D12_HEAP_TYPE_UPLOAD);
-	CD3DX12_RESOURCE_DESC upDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadSize);
-	hr = device->CreateCommittedResource(
+	CD3DX12_RESOURCE_DESC upDesc = CD3DX12_RESOURCE_DESC::Buffer(upload.uploadSize);
+	HRESULT hr = device->CreateCommittedResource(
 		&upHeap, D3D12_HEAP_FLAG_NONE, &upDesc,
 		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
 		IID_PPV_ARGS(&uploadBuf));
 	if (FAILED(hr)) return false;
-	// Copy pixels into upload buffer
-	D3D12_SUBRESOURCE_DATA subData{};
-	subData.pData = data.pixels.data();
-	subData.RowPitch = data.rowPitch;
-	subData.SlicePitch = (LONG_PTR)data.rowPitch * data.height;
-	UpdateSubresources(cmdList, texture.Get(), uploadBuf.Get(),
-		0, 0, 1, &subData);
-	// Transition to shader resource
-	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-		texture.Get(),
-		D3D12_RESOURCE_STATE_COPY_DEST,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	cmdList->ResourceBarrier(1, &barrier);
+	void* mapped = nullptr;
+	const CD3DX12_RANGE noRead(0, 0);
+	if (FAILED(uploadBuf->Map(0, &noRead, &mapped))) return false;
+	RecordUpload(cmdList, view, texture.Get(), upload, uploadBuf.Get(), 0, static_cast<uint8_t*>(mapped));
+	uploadBuf->Unmap(0, nullptr);
+	return true;
+}
+
+bool TextureLoader::CreateTexture(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	const TextureView& view,
+	DXGI_FORMAT format,
+	UploadRing& staging,
+	ComPtr<ID3D12Resource>& texture)
+{
+	TextureUploadLayout upload;
+	if (!CreateDestination(device, view, format, texture, upload)) return false;
+	UploadRing::Allocation allocation;
+	if (!staging.Allocate(upload.uploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, allocation)) return false;
+	RecordUpload(cmdList, view, texture.Get(), upload, allocation.buffer, allocation.offset, allocation.cpu);
+	return true;
+}
+
+bool TextureLoader::CreateTextureFromFile(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	const std::string& path,
+	UploadRing& staging,
+	ComPtr<ID3D12Resource>& texture)
+{
+	// Level 0 only, RGBA8: the size is all CreateDestination needs
+	TextureMipLevel single;
+	TextureView view;
+	if (!TextureDecoder::ReadInfo(path, view.width, view.height)) return false;
+	single = { 0, view.width, view.height, view.width * 4 };
+	view.mips = &single;
+	view.mipCount = 1;
+
+	TextureUploadLayout upload;
+	if (!CreateDestination(device, view, DXGI_FORMAT_R8G8B8A8_UNORM, texture, upload)) return false;
+	UploadRing::Allocation allocation;
+	if (!staging.Allocate(upload.uploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, allocation) ||
+		!TextureDecoder::LoadInto(path, allocation.cpu + upload.layouts[0].Offset,
+			upload.layouts[0].Footprint.RowPitch, view.width, view.height))
+	{
+		// A failed decode leaves its staging range to the next Retire
+		texture.Reset();
+		return false;
+	}
+	RecordCopies(cmdList, texture.Get(), upload, allocation.buffer, allocation.offset);
 	return true;
 }
\ No newline at end of file
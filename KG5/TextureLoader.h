@@ -6,22 +6,24 @@
 #include <string>
 #include <vector>
 #include "d3dx12.h"
+#include "TextureDecoder.h"
+#include "UploadRing.h"
 using Microsoft::WRL::ComPtr;
 
 class TextureLoader
 {
 public:
-	struct TextureData
+	// Decoded pixels (TextureDecoder) plus the GPU format to create them in
+	struct TextureData : TextureImage
 	{
-		std::vector<uint8_t> pixels;
-		UINT width = 0;
-		UINT height = 0;
 		DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		UINT rowPitch = 0;
 	};
+	// GPU format for a decoded or block-compressed image
+	static DXGI_FORMAT FormatFor(TextureEncoding encoding);
 	// Load image file into CPU memory
 	static bool LoadFromFile(const std::wstring& path, TextureData& out);
-	// Upload CPU data to a GPU default heap texture.
+	// Upload CPU data to a GPU default heap texture, with every mip level
+	// the data carries (TextureImage::mips).
 	// uploadBuf must stay alive until command list is executed.
 	static bool CreateTexture(
 		ID3D12Device* device,
@@ -29,4 +31,31 @@ public:
 		const TextureData& data,
 		ComPtr<ID3D12Resource>& texture,
 		ComPtr<ID3D12Resource>& uploadBuf);
+	// Same for a chain in memory that TextureLoader does not own (a mapped
+	// TextureCache file); 'view' is only read during the call.
+	static bool CreateTexture(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		const TextureView& view,
+		DXGI_FORMAT format,
+		ComPtr<ID3D12Resource>& texture,
+		ComPtr<ID3D12Resource>& uploadBuf);
+	// Same, with the staging copy suballocated from 'staging'; the ring
+	// reclaims it once the copy has executed (UploadRing::Retire).
+	static bool CreateTexture(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		const TextureView& view,
+		DXGI_FORMAT format,
+		UploadRing& staging,
+		ComPtr<ID3D12Resource>& texture);
+	// Single-level RGBA8 texture decoded straight into the staging
+	// allocation at the footprint's row pitch (TextureDecoder::LoadInto),
+	// with no CPU-side image in between.
+	static bool CreateTextureFromFile(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		const std::string& path,
+		UploadRing& staging,
+		ComPtr<ID3D12Resource>& texture);
 };
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "TextureManifest.h"
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+// -------------------------------------------------------
+// File layout
+// -------------------------------------------------------
+// [ManifestHeader][folder x folderCount][int32 candidate x jobCount]
+// folder = uint64 stamp, uint32 length, path bytes. Candidates index the
+// job's original list; -1 = nothing loaded, -2 = filter through the folder
+// index again. Native layout, like MeshCache.
+struct ManifestHeader
+{
+	char magic[8] = { 'K', 'G', '5', 'P', 'A', 'T', 'H', '\0' };
+	uint32_t version = TextureManifest::Version;
+	uint32_t jobCount = 0;
+	uint64_t candidateHash = 0;
+	uint32_t folderCount = 0;
+	uint32_t pad = 0;
+	uint64_t fileSize = 0;
+};
+static_assert(std::is_trivially_copyable<ManifestHeader>::value, "header must be memcpy-able");
+
+static const int32_t NothingLoaded = -1;
+static const int32_t ResolveAgain = -2;
+
+static uint64_t HashCandidates(const std::vector<TextureDecodeJob>& jobs)
+{
+	uint64_t hash = HashBytes64(nullptr, 0, jobs.size());
+	for (const TextureDecodeJob& job : jobs)
+	{
+		hash = HashBytes64(nullptr, 0, hash ^ job.candidates.size());
+		for (const std::string& candidate : job.candidates)
+			hash = HashBytes64(candidate.data(), candidate.size() + 1, hash);
+	}
+	return hash;
+}
+
+// Validates the manifest at 'path' and reads the recorded candidate per job
+static bool ReadManifest(const std::string& path, uint64_t candidateHash, size_t jobCount,
+	AssetDirectoryIndex& index, std::vector<int32_t>& chosen)
+{
+	MappedFile file;
+	if (!file.Open(path) || file.Size() < sizeof(ManifestHeader)) return false;
+	ManifestHeader header;
+	std::memcpy(&header, file.Data(), sizeof(header));
+	const ManifestHeader expected;
+	if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+		header.version != TextureManifest::Version || header.fileSize != file.Size() ||
+		header.jobCount != jobCount || header.candidateHash != candidateHash)
+	{
+		return false;
+	}
+
+	size_t offset = sizeof(header);
+	for (uint32_t f = 0; f < header.folderCount; ++f)
+	{
+		uint64_t stamp = 0;
+		uint32_t length = 0;
+		if (offset + sizeof(stamp) + sizeof(length) > file.Size()) return false;
+		std::memcpy(&stamp, file.Data() + offset, sizeof(stamp));
+		std::memcpy(&length, file.Data() + offset + sizeof(stamp), sizeof(length));
+		offset += sizeof(stamp) + sizeof(length);
+		if (length > file.Size() - offset) return false;
+		const std::string folder(file.Data() + offset, length);
+		offset += length;
+		if (index.FolderStamp(folder) != stamp) return false;
+	}
+	if (file.Size() - offset != jobCount * sizeof(int32_t)) return false;
+	chosen.resize(jobCount);
+	std::memcpy(chosen.data(), file.Data() + offset, jobCount * sizeof(int32_t));
+	return true;
+}
+
+// -------------------------------------------------------
+// TextureManifest
+// -------------------------------------------------------
+std::string TextureManifest::PathFor(const std::string& objPath)
+{
+	return fs::path(objPath).replace_extension(".kg5paths").string();
+}
+
+bool TextureManifest::Resolve(const std::string& objPath, std::vector<TextureDecodeJob>& jobs, AssetDirectoryIndex& index)
+{
+	const auto start = std::chrono::steady_clock::now();
+	m_path = PathFor(objPath);
+	m_stats = Stats();
+	m_stats.jobCount = jobs.size();
+	m_candidateHash = HashCandidates(jobs);
+
+	// Every folder a candidate may live in, stamped now so a later Write
+	// describes the state the candidates were resolved against
+	m_folders.clear();
+	m_folderStamps.clear();
+	for (const TextureDecodeJob& job : jobs)
+	{
+		m_stats.candidatesBefore += job.candidates.size();
+		for (const std::string& candidate : job.candidates)
+		{
+			std::string folder = AssetDirectoryIndex::Key(fs::path(candidate).parent_path().string());
+			if (std::find(m_folders.begin(), m_folders.end(), folder) == m_folders.end())
+				m_folders.push_back(std::move(folder));
+		}
+	}
+	m_stats.folderCount = m_folders.size();
+
+	std::vector<int32_t> chosen;
+	m_stats.loaded = ReadManifest(m_path, m_candidateHash, jobs.size(), index, chosen);
+	m_kept.assign(jobs.size(), std::vector<int32_t>());
+	for (size_t j = 0; j < jobs.size(); ++j)
+	{
+		TextureDecodeJob& job = jobs[j];
+		std::vector<std::string> kept;
+		if (m_stats.loaded && chosen[j] != ResolveAgain)
+		{
+			const int32_t c = chosen[j];
+			if (c >= 0 && (size_t)c < job.candidates.size())
+			{
+				kept.push_back(job.candidates[c]);
+				m_kept[j].push_back(c);
+			}
+		}
+		else
+		{
+			for (size_t c = 0; c < job.candidates.size(); ++c)
+			{
+				if (!index.Exists(job.candidates[c]))
+					continue;
+				kept.push_back(job.candidates[c]);
+				m_kept[j].push_back((int32_t)c);
+			}
+		}
+		job.candidates = std::move(kept);
+		m_stats.candidatesAfter += job.candidates.size();
+		m_stats.resolvedCount += job.candidates.empty() ? 0 : 1;
+	}
+	if (!m_stats.loaded)
+	{
+		for (const std::string& folder : m_folders)
+			m_folderStamps.push_back(index.FolderStamp(folder));
+	}
+	m_stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return m_stats.loaded;
+}
+
+bool TextureManifest::Write(const std::vector<TextureDecodeJob>& jobs)
+{
+	if (m_path.empty() || jobs.size() != m_kept.size() || m_folderStamps.size() != m_folders.size())
+		return false;
+
+	std::vector<char> file(sizeof(ManifestHeader));
+	ManifestHeader header;
+	header.jobCount = (uint32_t)jobs.size();
+	header.candidateHash = m_candidateHash;
+	header.folderCount = (uint32_t)m_folders.size();
+	for (size_t f = 0; f < m_folders.size(); ++f)
+	{
+		const uint64_t stamp = m_folderStamps[f];
+		const uint32_t length = (uint32_t)m_folders[f].size();
+		const char* p = reinterpret_cast<const char*>(&stamp);
+		file.insert(file.end(), p, p + sizeof(stamp));
+		p = reinterpret_cast<const char*>(&length);
+		file.insert(file.end(), p, p + sizeof(length));
+		file.insert(file.end(), m_folders[f].begin(), m_folders[f].end());
+	}
+	for (size_t j = 0; j < jobs.size(); ++j)
+	{
+		const int32_t original = RecordedCandidate(jobs, j);
+		const char* p = reinterpret_cast<const char*>(&original);
+		file.insert(file.end(), p, p + sizeof(original));
+	}
+	header.fileSize = file.size();
+	std::memcpy(file.data(), &header, sizeof(header));
+
+	const std::string tmpPath = m_path + ".tmp";
+	{
+		std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open()) return false;
+		out.write(file.data(), (std::streamsize)file.size());
+		if (!out.good()) return false;
+	}
+	std::error_code ec;
+	fs::rename(tmpPath, m_path, ec);
+	if (ec)
+	{
+		fs::remove(tmpPath, ec);
+		return false;
+	}
+	m_stats.written = true;
+	return true;
+}
+
+int32_t TextureManifest::RecordedCandidate(const std::vector<TextureDecodeJob>& jobs, size_t j) const
+{
+	// decodedCandidate indexes the narrowed list
+	const TextureDecodeJob& job = jobs[j];
+	if (job.sharedWith < 0)
+	{
+		const int decoded = job.decodedCandidate;
+		return (decoded >= 0 && (size_t)decoded < m_kept[j].size()) ? m_kept[j][decoded] : NothingLoaded;
+	}
+
+	// TextureRegistry::Share left the job undecoded: it loads the owner's file,
+	// which is one of its own candidates unless only the contents matched
+	const TextureDecodeJob& owner = jobs[job.sharedWith];
+	if (owner.decodedCandidate < 0)
+		return NothingLoaded;
+	const std::string ownerKey = AssetDirectoryIndex::Key(owner.candidates[owner.decodedCandidate]);
+	for (size_t c = 0; c < job.candidates.size() && c < m_kept[j].size(); ++c)
+	{
+		if (AssetDirectoryIndex::Key(job.candidates[c]) == ownerKey)
+			return m_kept[j][c];
+	}
+	return ResolveAgain;
+}
+
+std::string TextureManifest::Format(const Stats& s)
+{
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[TextureManifest] %s: %zu / %zu slots resolved, %zu -> %zu candidates in %zu folders, %.2f ms\n",
+		s.loaded ? "hit" : (s.written ? "rebuilt" : "miss"),
+		s.resolvedCount,
+		s.jobCount,
+		s.candidatesBefore,
+		s.candidatesAfter,
+		s.folderCount,
+		s.milliseconds);
+	return buf;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "AssetDirectoryIndex.h"
+#include "TextureDecodePool.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+// Remembers which candidate each texture slot of a model ended up loading
+// (<model>.kg5paths next to the OBJ), so the next load goes straight to the
+// right file for every slot and skips slots that found nothing.
+//
+// The manifest matches when the slots' candidate lists are the same as when
+// it was written and no file was added to, removed from or renamed in any
+// folder a candidate lives in (AssetDirectoryIndex::FolderStamp). Otherwise
+// the candidates are filtered through the index and the manifest is
+// rewritten after decoding. A file that exists but does not decode is
+// recorded as missing until its folder changes. A shared slot whose owner
+// only matched by content is filtered through the index on every load.
+class TextureManifest
+{
+public:
+	// Bump whenever the file layout changes
+	static constexpr uint32_t Version = 2;
+	struct Stats
+	{
+		size_t jobCount = 0;
+		size_t resolvedCount = 0;    // jobs left with a candidate
+		size_t candidatesBefore = 0;
+		size_t candidatesAfter = 0;
+		size_t folderCount = 0;      // folders the candidates live in
+		bool loaded = false;         // the manifest matched
+		bool written = false;
+		double milliseconds = 0.0;
+	};
+
+	static std::string PathFor(const std::string& objPath);
+	// Narrows every job's candidates to the recorded one (or none) when the
+	// manifest for objPath matches, else to the candidates that exist.
+	// Returns true when the manifest was used. Run before TextureRegistry::Share.
+	bool Resolve(const std::string& objPath, std::vector<TextureDecodeJob>& jobs, AssetDirectoryIndex& index);
+	// After TextureDecodePool::Decode and the uploads of decodeAtUpload jobs
+	// (which may move decodedCandidate), when Resolve returned false: records
+	// each job's decoded candidate, or for a shared job (TextureRegistry::Share)
+	// its own candidate for the owner's file.
+	bool Write(const std::vector<TextureDecodeJob>& jobs);
+
+	const Stats& GetStats() const { return m_stats; }
+	static std::string Format(const Stats& s);
+private:
+	// Original candidate index to store for job j
+	int32_t RecordedCandidate(const std::vector<TextureDecodeJob>& jobs, size_t j) const;
+
+	std::string m_path;
+	uint64_t m_candidateHash = 0;
+	std::vector<std::string> m_folders;
+	std::vector<uint64_t> m_folderStamps;
+	// Per job: index in the original candidate list of each candidate kept
+	std::vector<std::vector<int32_t>> m_kept;
+	Stats m_stats;
+};
@@ -0,0 +1,284 @@
+#include "TextureMipmapper.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TEXTURE_MIPMAPPER_SSE 1
+#include <emmintrin.h>
+#else
+#define TEXTURE_MIPMAPPER_SSE 0
+#endif
+
+// -------------------------------------------------------
+// sRGB transfer tables
+// -------------------------------------------------------
+// Encoding goes through a table indexed by linear value; 16K entries keep
+// the error below a quarter step even in the steep dark end of the curve.
+static const int SrgbEncodeSize = 16384;
+
+struct SrgbTables
+{
+	float decode[256];
+	uint8_t encode[SrgbEncodeSize];
+	SrgbTables()
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			const float c = i / 255.f;
+			decode[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int i = 0; i < SrgbEncodeSize; ++i)
+		{
+			const float l = (float)i / (SrgbEncodeSize - 1);
+			const float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+			encode[i] = (uint8_t)(std::min)(c * 255.f + 0.5f, 255.f);
+		}
+	}
+};
+
+static const SrgbTables& Srgb()
+{
+	static const SrgbTables tables;
+	return tables;
+}
+
+// -------------------------------------------------------
+// Texel math
+// -------------------------------------------------------
+// Texels are RGBA floats in filter space: linear light for Srgb, [0,1] as
+// stored for Linear, [-1,1] xyz for NormalMap. The SSE and scalar paths do
+// the same operations in the same order, so their results are identical.
+#if TEXTURE_MIPMAPPER_SSE
+typedef __m128 Texel;
+
+static inline Texel LoadTexel(const float* p) { return _mm_loadu_ps(p); }
+static inline void StoreTexel(float* p, Texel t) { _mm_storeu_ps(p, t); }
+static inline Texel MakeTexel(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+
+static inline Texel Average4(Texel a, Texel b, Texel c, Texel d)
+{
+	return _mm_mul_ps(_mm_add_ps(_mm_add_ps(a, b), _mm_add_ps(c, d)), _mm_set1_ps(0.25f));
+}
+
+// Unit-length xyz, alpha untouched; a vanished average becomes +Z
+static inline Texel RenormalizeXyz(Texel t)
+{
+	const __m128 maskXyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	const __m128 xyz = _mm_and_ps(t, maskXyz);
+	const __m128 sq = _mm_mul_ps(xyz, xyz);
+	__m128 sum = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+	sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	if (_mm_cvtss_f32(sum) < 1e-12f)
+		return _mm_or_ps(_mm_setr_ps(0.f, 0.f, 1.f, 0.f), _mm_andnot_ps(maskXyz, t));
+	const __m128 scaled = _mm_div_ps(xyz, _mm_sqrt_ps(sum));
+	return _mm_or_ps(scaled, _mm_andnot_ps(maskXyz, t));
+}
+#else
+struct Texel
+{
+	float v[4];
+};
+
+static inline Texel LoadTexel(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+static inline void StoreTexel(float* p, const Texel& t) { p[0] = t.v[0]; p[1] = t.v[1]; p[2] = t.v[2]; p[3] = t.v[3]; }
+static inline Texel MakeTexel(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+
+static inline Texel Average4(const Texel& a, const Texel& b, const Texel& c, const Texel& d)
+{
+	Texel r;
+	for (int k = 0; k < 4; ++k)
+		r.v[k] = ((a.v[k] + b.v[k]) + (c.v[k] + d.v[k])) * 0.25f;
+	return r;
+}
+
+static inline Texel RenormalizeXyz(const Texel& t)
+{
+	const float sum = (t.v[0] * t.v[0] + t.v[1] * t.v[1]) + (t.v[2] * t.v[2] + 0.f);
+	if (sum < 1e-12f)
+		return { { 0.f, 0.f, 1.f, t.v[3] } };
+	const float len = std::sqrt(sum);
+	return { { t.v[0] / len, t.v[1] / len, t.v[2] / len, t.v[3] } };
+}
+#endif
+
+// Filter space from stored RGBA8
+template <TextureMipFilter F>
+static inline Texel DecodeTexel(const uint8_t* p, const float* srgbDecode)
+{
+	const float inv255 = 1.f / 255.f;
+	if (F == TextureMipFilter::Srgb)
+		return MakeTexel(srgbDecode[p[0]], srgbDecode[p[1]], srgbDecode[p[2]], p[3] * inv255);
+#if TEXTURE_MIPMAPPER_SSE
+	int packed;
+	std::memcpy(&packed, p, 4);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+	const __m128 unorm = _mm_mul_ps(_mm_cvtepi32_ps(wide), _mm_set1_ps(inv255));
+	if (F == TextureMipFilter::NormalMap)
+		return _mm_add_ps(_mm_mul_ps(unorm, _mm_setr_ps(2.f, 2.f, 2.f, 1.f)), _mm_setr_ps(-1.f, -1.f, -1.f, 0.f));
+	return unorm;
+#else
+	const Texel unorm = MakeTexel(p[0] * inv255, p[1] * inv255, p[2] * inv255, p[3] * inv255);
+	if (F == TextureMipFilter::NormalMap)
+		return MakeTexel(unorm.v[0] * 2.f - 1.f, unorm.v[1] * 2.f - 1.f, unorm.v[2] * 2.f - 1.f, unorm.v[3]);
+	return unorm;
+#endif
+}
+
+// Filter space back to RGBA8, rounded to nearest. sRGB channels become
+// indices into the encode table instead of 0..255.
+template <TextureMipFilter F>
+static inline void EncodeTexel(Texel t, const uint8_t* srgbEncode, uint8_t* out)
+{
+	const float top = (F == TextureMipFilter::Srgb) ? (float)(SrgbEncodeSize - 1) : 255.f;
+#if TEXTURE_MIPMAPPER_SSE
+	if (F == TextureMipFilter::NormalMap)
+		t = _mm_add_ps(_mm_mul_ps(t, _mm_setr_ps(0.5f, 0.5f, 0.5f, 1.f)), _mm_setr_ps(0.5f, 0.5f, 0.5f, 0.f));
+	const __m128 clamped = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.f));
+	const __m128i q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_setr_ps(top, top, top, 255.f)), _mm_set1_ps(0.5f)));
+	if (F == TextureMipFilter::Srgb)
+	{
+		alignas(16) int32_t idx[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(idx), q);
+		out[0] = srgbEncode[idx[0]];
+		out[1] = srgbEncode[idx[1]];
+		out[2] = srgbEncode[idx[2]];
+		out[3] = (uint8_t)idx[3];
+		return;
+	}
+	const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(q, q), q));
+	std::memcpy(out, &packed, 4);
+#else
+	if (F == TextureMipFilter::NormalMap)
+		t = MakeTexel(t.v[0] * 0.5f + 0.5f, t.v[1] * 0.5f + 0.5f, t.v[2] * 0.5f + 0.5f, t.v[3]);
+	int32_t idx[4];
+	for (int k = 0; k < 4; ++k)
+		idx[k] = (int32_t)((std::min)((std::max)(t.v[k], 0.f), 1.f) * (k < 3 ? top : 255.f) + 0.5f);
+	for (int k = 0; k < 3; ++k)
+		out[k] = (F == TextureMipFilter::Srgb) ? srgbEncode[idx[k]] : (uint8_t)idx[k];
+	out[3] = (uint8_t)idx[3];
+#endif
+}
+
+// -------------------------------------------------------
+// Chain
+// -------------------------------------------------------
+UINT TextureMipmapper::FullChainLength(UINT width, UINT height)
+{
+	UINT levels = 1;
+	for (UINT size = (std::max)(width, height); size > 1; size >>= 1)
+		++levels;
+	return levels;
+}
+
+// One level down from src: 'fetch' returns the texel at (x, y) of the level
+// above. Writes the unquantized result to dstFloat and RGBA8 to dstBytes.
+template <TextureMipFilter F, typename FetchFn>
+static void Reduce(UINT srcW, UINT srcH, FetchFn&& fetch, const uint8_t* srgbEncode,
+	UINT dstW, UINT dstH, float* dstFloat, uint8_t* dstBytes)
+{
+	for (UINT y = 0; y < dstH; ++y)
+	{
+		const UINT y0 = (std::min)(y * 2, srcH - 1);
+		const UINT y1 = (std::min)(y * 2 + 1, srcH - 1);
+		for (UINT x = 0; x < dstW; ++x)
+		{
+			const UINT x0 = (std::min)(x * 2, srcW - 1);
+			const UINT x1 = (std::min)(x * 2 + 1, srcW - 1);
+			Texel t = Average4(fetch(x0, y0), fetch(x1, y0), fetch(x0, y1), fetch(x1, y1));
+			if (F == TextureMipFilter::NormalMap)
+				t = RenormalizeXyz(t);
+			const size_t i = (size_t)y * dstW + x;
+			StoreTexel(dstFloat + i * 4, t);
+			EncodeTexel<F>(t, srgbEncode, dstBytes + i * 4);
+		}
+	}
+}
+
+// Level 1 reads the bytes; every later level reads the float copy of the
+// level above, so rounding does not accumulate.
+template <TextureMipFilter F>
+static void BuildChain(TextureImage& image)
+{
+	const SrgbTables& srgb = Srgb();
+	std::vector<float> above, below;
+	for (size_t m = 1; m < image.mips.size(); ++m)
+	{
+		const TextureMipLevel& src = image.mips[m - 1];
+		const TextureMipLevel& dst = image.mips[m];
+		below.resize((size_t)dst.width * dst.height * 4);
+		uint8_t* dstBytes = image.pixels.data() + dst.offset;
+		if (m == 1)
+		{
+			const uint8_t* bytes = image.pixels.data();
+			Reduce<F>(src.width, src.height,
+				[&](UINT x, UINT y) { return DecodeTexel<F>(bytes + (size_t)y * src.rowPitch + (size_t)x * 4, srgb.decode); },
+				srgb.encode, dst.width, dst.height, below.data(), dstBytes);
+		}
+		else
+		{
+			const float* floats = above.data();
+			Reduce<F>(src.width, src.height,
+				[&](UINT x, UINT y) { return LoadTexel(floats + ((size_t)y * src.width + x) * 4); },
+				srgb.encode, dst.width, dst.height, below.data(), dstBytes);
+		}
+		above.swap(below);
+	}
+}
+
+bool TextureMipmapper::Generate(TextureImage& image, TextureMipFilter filter, Stats* stats)
+{
+	const auto start = std::chrono::steady_clock::now();
+	if (image.width == 0 || image.height == 0 || !image.mips.empty() || image.rowPitch != image.width * 4 ||
+		image.pixels.size() < (size_t)image.rowPitch * image.height)
+		return false;
+
+	const UINT levelCount = FullChainLength(image.width, image.height);
+	image.mips.resize(levelCount);
+	size_t offset = 0;
+	UINT w = image.width, h = image.height;
+	for (UINT m = 0; m < levelCount; ++m)
+	{
+		image.mips[m] = { offset, w, h, w * 4 };
+		offset += (size_t)w * h * 4;
+		w = (std::max)(w >> 1, 1u);
+		h = (std::max)(h >> 1, 1u);
+	}
+	const size_t level0Bytes = (size_t)image.rowPitch * image.height;
+	image.pixels.resize(offset);
+
+	switch (filter)
+	{
+	case TextureMipFilter::Srgb: BuildChain<TextureMipFilter::Srgb>(image); break;
+	case TextureMipFilter::NormalMap: BuildChain<TextureMipFilter::NormalMap>(image); break;
+	default: BuildChain<TextureMipFilter::Linear>(image); break;
+	}
+
+	if (stats)
+	{
+		++stats->imageCount;
+		stats->levelCount += levelCount - 1;
+		stats->bytesAdded += offset - level0Bytes;
+		stats->milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	return true;
+}
+
+std::string TextureMipmapper::Format(const Stats& s)
+{
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[Mips] %zu images, %zu levels, +%.1f MB: %.1f ms\n",
+		s.imageCount,
+		s.levelCount,
+		(double)s.bytesAdded / (1024.0 * 1024.0),
+		s.milliseconds);
+	return buf;
+}
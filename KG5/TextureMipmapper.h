@@ -0,0 +1,32 @@
+#pragma once
+#include "TextureDecoder.h"
+#include <string>
+// Builds full mip chains for RGBA8 images on the CPU. Each level is a 2x2
+// box filter of the one above, computed from the unquantized float level so
+// rounding does not accumulate down the chain. Odd sizes clamp the last
+// row/column.
+enum class TextureMipFilter
+{
+	Srgb,      // colour: RGB averaged in linear light, alpha linearly
+	Linear,    // data maps (displacement, masks): all channels averaged as stored
+	NormalMap, // tangent-space normals: xyz decoded from [0,1], averaged and renormalized
+};
+
+class TextureMipmapper
+{
+public:
+	struct Stats
+	{
+		size_t imageCount = 0;
+		size_t levelCount = 0;   // generated, without level 0
+		size_t bytesAdded = 0;
+		double milliseconds = 0.0;
+	};
+
+	// Appends levels 1..N (down to 1x1) to image.pixels and fills image.mips.
+	// Expects tightly packed RGBA8 level 0 with no chain yet.
+	static bool Generate(TextureImage& image, TextureMipFilter filter, Stats* stats = nullptr);
+
+	static UINT FullChainLength(UINT width, UINT height);
+	static std::string Format(const Stats& s);
+};
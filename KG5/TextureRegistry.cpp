@@ -0,0 +1,125 @@
+#include "TextureRegistry.h"
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+// First candidate that exists, as a canonical path; empty if none does
+static std::string ResolveCandidate(const TextureDecodeJob& job)
+{
+	for (const std::string& candidate : job.candidates)
+	{
+		std::error_code ec;
+		if (!fs::is_regular_file(candidate, ec))
+			continue;
+		fs::path canonical = fs::weakly_canonical(candidate, ec);
+		if (ec)
+			canonical = fs::absolute(candidate, ec);
+		std::string key = canonical.generic_string();
+#ifdef _WIN32
+		std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+		return key;
+	}
+	return std::string();
+}
+
+TextureRegistry::Stats TextureRegistry::Share(std::vector<TextureDecodeJob>& jobs, const TextureShareOptions& options)
+{
+	const auto start = std::chrono::steady_clock::now();
+	Stats stats;
+	stats.jobCount = jobs.size();
+
+	// The settings are part of the key: a diffuse map that is also tried as
+	// a displacement candidate is cooked differently there.
+	std::unordered_map<std::string, int> byPath;
+	std::map<std::tuple<uint64_t, uint64_t, uint32_t>, int> byContent;
+	for (size_t j = 0; j < jobs.size(); ++j)
+	{
+		TextureDecodeJob& job = jobs[j];
+		job.sharedWith = -1;
+		const std::string path = ResolveCandidate(job);
+		if (path.empty())
+			continue;
+		++stats.resolvedCount;
+		const uint32_t settings = TextureDecodePool::CookSettings(job);
+
+		const auto inserted = byPath.emplace(path + '|' + std::to_string(settings), (int)j);
+		if (!inserted.second)
+		{
+			job.sharedWith = inserted.first->second;
+			++stats.sharedCount;
+			continue;
+		}
+		if (options.compareContents)
+		{
+			MappedFile file;
+			if (file.Open(path))
+			{
+				stats.hashedBytes += file.Size();
+				const auto key = std::make_tuple(HashBytes64(file.Data(), file.Size()), (uint64_t)file.Size(), settings);
+				const auto match = byContent.emplace(key, (int)j);
+				if (!match.second)
+				{
+					job.sharedWith = match.first->second;
+					inserted.first->second = match.first->second;
+					++stats.sharedCount;
+					++stats.contentMatches;
+					continue;
+				}
+			}
+		}
+		++stats.uniqueCount;
+	}
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+void TextureRegistry::AddSavings(const std::vector<TextureDecodeJob>& jobs, Stats& stats)
+{
+	stats.savedMs = 0.0;
+	stats.savedBytes = 0;
+	for (const TextureDecodeJob& job : jobs)
+	{
+		if (job.sharedWith < 0)
+			continue;
+		const TextureDecodeJob& owner = jobs[job.sharedWith];
+		if (owner.decodedCandidate < 0)
+			continue;
+		stats.savedMs += owner.milliseconds;
+		if (owner.cooked)
+			stats.savedBytes += owner.cooked->DataSize();
+		else if (owner.PixelsPending())
+			stats.savedBytes += (size_t)owner.image.rowPitch * owner.image.height;
+		else
+			stats.savedBytes += owner.image.pixels.size();
+	}
+}
+
+std::string TextureRegistry::Format(const Stats& s)
+{
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[TextureShare] %zu slots, %zu resolved to %zu textures (%zu shared, %zu by content): "
+		"saved %.1f MB and %.1f ms of loading, %zu materials reuse SRVs, %.2f ms\n",
+		s.jobCount,
+		s.resolvedCount,
+		s.uniqueCount,
+		s.sharedCount,
+		s.contentMatches,
+		(double)s.savedBytes / (1024.0 * 1024.0),
+		s.savedMs,
+		s.sharedSrvMaterials,
+		s.milliseconds);
+	return buf;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "TextureDecodePool.h"
+#include <string>
+#include <vector>
+// Finds texture slots that load the same file. Sponza's materials reuse
+// diffuse and _ddn maps, and the name-derived normal/displacement candidates
+// often land on a file another slot already uses; without sharing each slot
+// decodes, uploads and keeps its own copy.
+struct TextureShareOptions
+{
+	// Also share files with identical bytes under different paths (hashes
+	// every resolved file once).
+	bool compareContents = false;
+};
+
+class TextureRegistry
+{
+public:
+	struct Stats
+	{
+		size_t jobCount = 0;
+		size_t resolvedCount = 0; // jobs with an existing candidate
+		size_t uniqueCount = 0;   // distinct textures among them
+		size_t sharedCount = 0;   // jobs pointed at an earlier one
+		size_t contentMatches = 0; // of those, different paths with the same bytes
+		size_t hashedBytes = 0;
+		double milliseconds = 0.0;
+		// AddSavings: what the shared jobs would have cost on their own
+		double savedMs = 0.0;     // decode, mips, BCn (or cache map) of their texture
+		size_t savedBytes = 0;    // texture memory: size of the chain they reuse
+		// Set by the caller when materials with the same textures share SRVs
+		size_t sharedSrvMaterials = 0;
+	};
+
+	// Resolves every job's texture: its first existing candidate, made
+	// canonical (case-folded on Windows), plus TextureDecodePool::CookSettings.
+	// A job whose texture an earlier job already loads gets sharedWith set to
+	// that job. Run before TextureDecodePool::Decode.
+	static Stats Share(std::vector<TextureDecodeJob>& jobs, const TextureShareOptions& options = TextureShareOptions());
+	// After Decode, before the images are released
+	static void AddSavings(const std::vector<TextureDecodeJob>& jobs, Stats& stats);
+
+	static std::string Format(const Stats& s);
+};
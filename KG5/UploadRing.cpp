@@ -0,0 +1,154 @@
+#include "UploadRing.h"
+#include "d3dx12.h"
+#include <algorithm>
+#include <cstdio>
+
+static UINT64 AlignUp(UINT64 value, UINT64 alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool UploadRing::Init(ID3D12Device* device, UINT64 capacity, FlushCallback flush)
+{
+	m_device = device;
+	m_capacity = capacity;
+	m_flush = std::move(flush);
+	m_head = m_tail = m_used = 0;
+	m_open = Batch();
+	m_inFlight.clear();
+	m_stats = Stats();
+	m_stats.capacity = capacity;
+
+	CD3DX12_HEAP_PROPERTIES upHeap(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+	HRESULT hr = device->CreateCommittedResource(
+		&upHeap, D3D12_HEAP_FLAG_NONE, &desc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+		IID_PPV_ARGS(&m_buffer));
+	if (FAILED(hr)) return false;
+	// Upload heaps may stay mapped for the resource's lifetime
+	const CD3DX12_RANGE noRead(0, 0);
+	void* mapped = nullptr;
+	if (FAILED(m_buffer->Map(0, &noRead, &mapped))) return false;
+	m_cpu = static_cast<uint8_t*>(mapped);
+	return true;
+}
+
+bool UploadRing::TryAllocate(UINT64 size, UINT64 alignment, Allocation& out)
+{
+	if (m_used == 0)
+		m_head = m_tail = 0;
+	UINT64 offset = AlignUp(m_head, alignment);
+	UINT64 taken = 0;
+	if (m_used == 0 || m_head > m_tail)
+	{
+		// Free space is [head, capacity) and [0, tail)
+		if (offset + size <= m_capacity)
+			taken = offset + size - m_head;
+		else if (size <= m_tail)
+		{
+			offset = 0;
+			taken = m_capacity - m_head + size;
+		}
+		else
+			return false;
+	}
+	else
+	{
+		// Wrapped: free space is [head, tail)
+		if (offset + size > m_tail)
+			return false;
+		taken = offset + size - m_head;
+	}
+
+	m_head = offset + size;
+	if (m_head == m_capacity)
+		m_head = 0;
+	m_used += taken;
+	m_open.bytes += taken;
+	m_stats.peakBytes = (std::max)(m_stats.peakBytes, m_used);
+	out.buffer = m_buffer.Get();
+	out.offset = offset;
+	out.cpu = m_cpu + offset;
+	return true;
+}
+
+bool UploadRing::Allocate(UINT64 size, UINT64 alignment, Allocation& out)
+{
+	if (!m_buffer || size == 0)
+		return false;
+	if (size <= m_capacity)
+	{
+		bool allocated = TryAllocate(size, alignment, out);
+		if (!allocated && m_flush)
+		{
+			++m_stats.flushes;
+			m_flush();
+			allocated = TryAllocate(size, alignment, out);
+		}
+		if (allocated)
+		{
+			++m_stats.allocations;
+			m_stats.bytesAllocated += size;
+			return true;
+		}
+	}
+
+	// Does not fit even into an empty ring
+	ComPtr<ID3D12Resource> buffer;
+	CD3DX12_HEAP_PROPERTIES upHeap(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	HRESULT hr = m_device->CreateCommittedResource(
+		&upHeap, D3D12_HEAP_FLAG_NONE, &desc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+		IID_PPV_ARGS(&buffer));
+	if (FAILED(hr)) return false;
+	const CD3DX12_RANGE noRead(0, 0);
+	void* mapped = nullptr;
+	if (FAILED(buffer->Map(0, &noRead, &mapped))) return false;
+	out.buffer = buffer.Get();
+	out.offset = 0;
+	out.cpu = static_cast<uint8_t*>(mapped);
+	m_open.dedicated.push_back(buffer);
+	++m_stats.dedicated;
+	m_stats.dedicatedBytes += size;
+	return true;
+}
+
+void UploadRing::Submit(UINT64 fenceValue)
+{
+	if (m_open.bytes == 0 && m_open.dedicated.empty())
+		return;
+	m_open.fenceValue = fenceValue;
+	m_open.end = m_head;
+	m_inFlight.push_back(std::move(m_open));
+	m_open = Batch();
+}
+
+void UploadRing::Retire(UINT64 completedValue)
+{
+	while (!m_inFlight.empty() && m_inFlight.front().fenceValue <= completedValue)
+	{
+		m_used -= m_inFlight.front().bytes;
+		m_tail = m_inFlight.front().end;
+		m_inFlight.pop_front();
+	}
+}
+
+std::string UploadRing::Format(const Stats& s)
+{
+	const double mb = 1024.0 * 1024.0;
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[Staging] %.1f MB ring: %.1f MB in %zu copies, peak %.1f MB, %zu flushes, %zu dedicated (%.1f MB)\n",
+		(double)s.capacity / mb,
+		(double)s.bytesAllocated / mb,
+		s.allocations,
+		(double)s.peakBytes / mb,
+		s.flushes,
+		s.dedicated,
+		(double)s.dedicatedBytes / mb);
+	return buf;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+using Microsoft::WRL::ComPtr;
+
+// Staging memory for GPU copies: one persistently mapped upload-heap buffer
+// of fixed size, handed out front to back and reused once the copies that
+// read it have completed. Upload-heap use stays at the ring's capacity
+// however much is uploaded.
+//
+// Allocations belong to the open batch until Submit() tags it with the fence
+// value its copies signal; Retire() frees every batch whose fence has been
+// reached. When an allocation does not fit, the ring calls the flush
+// callback, which must execute the recorded copies, Submit() and wait until
+// Retire() has freed them. Requests larger than the whole ring get a
+// dedicated buffer that is released with its batch.
+class UploadRing
+{
+public:
+	struct Allocation
+	{
+		ID3D12Resource* buffer = nullptr;
+		UINT64 offset = 0; // of cpu within buffer
+		uint8_t* cpu = nullptr;
+	};
+	struct Stats
+	{
+		UINT64 capacity = 0;
+		UINT64 bytesAllocated = 0; // over the ring's lifetime
+		UINT64 peakBytes = 0;      // most in use at once, padding included
+		size_t allocations = 0;
+		size_t flushes = 0;        // ring full, copies executed early
+		size_t dedicated = 0;      // larger than the ring
+		UINT64 dedicatedBytes = 0;
+	};
+	using FlushCallback = std::function<void()>;
+
+	bool Init(ID3D12Device* device, UINT64 capacity, FlushCallback flush);
+	// 'alignment' must be a power of two
+	bool Allocate(UINT64 size, UINT64 alignment, Allocation& out);
+	// Closes the open batch; its copies complete when the fence reaches fenceValue
+	void Submit(UINT64 fenceValue);
+	// Frees batches whose fence value is at most completedValue
+	void Retire(UINT64 completedValue);
+
+	UINT64 BytesInUse() const { return m_used; }
+	const Stats& GetStats() const { return m_stats; }
+	static std::string Format(const Stats& s);
+private:
+	struct Batch
+	{
+		UINT64 fenceValue = 0;
+		UINT64 end = 0;   // head when submitted
+		UINT64 bytes = 0; // taken from the ring, padding included
+		std::vector<ComPtr<ID3D12Resource>> dedicated;
+	};
+	bool TryAllocate(UINT64 size, UINT64 alignment, Allocation& out);
+
+	ID3D12Device* m_device = nullptr;
+	ComPtr<ID3D12Resource> m_buffer;
+	uint8_t* m_cpu = nullptr;
+	UINT64 m_capacity = 0;
+	UINT64 m_head = 0; // next free byte
+	UINT64 m_tail = 0; // oldest byte still in use
+	UINT64 m_used = 0;
+	Batch m_open;
+	std::deque<Batch> m_inFlight;
+	FlushCallback m_flush;
+	Stats m_stats;
+};
@@ -0,0 +1,536 @@
+#include "VertexPacking.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static uint32_t FloatBits(float f)
+{
+	uint32_t u;
+	std::memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+static float BitsFloat(uint32_t u)
+{
+	float f;
+	std::memcpy(&f, &u, sizeof(f));
+	return f;
+}
+
+static float Dot3(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static XMFLOAT3 Cross3(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static XMFLOAT3 Normalize3(const XMFLOAT3& v)
+{
+	const float len = std::sqrt(Dot3(v, v));
+	if (len <= 0.f) return XMFLOAT3(0.f, 0.f, 0.f);
+	return XMFLOAT3(v.x / len, v.y / len, v.z / len);
+}
+
+static float AngleDeg(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	// atan2 keeps precision for tiny angles where acos(dot) does not
+	const XMFLOAT3 na = Normalize3(a);
+	const XMFLOAT3 nb = Normalize3(b);
+	const XMFLOAT3 c = Cross3(na, nb);
+	return std::atan2(std::sqrt(Dot3(c, c)), Dot3(na, nb)) * (180.f / 3.14159265f);
+}
+
+// -------------------------------------------------------
+// Octahedral normal (R16G16_SNORM)
+// -------------------------------------------------------
+static float SnormToFloat(int16_t q)
+{
+	return std::max((float)q / 32767.f, -1.f);
+}
+
+static XMFLOAT3 OctToVector(float u, float v)
+{
+	XMFLOAT3 n(u, v, 1.f - std::abs(u) - std::abs(v));
+	const float t = std::max(-n.z, 0.f);
+	n.x += (n.x >= 0.f) ? -t : t;
+	n.y += (n.y >= 0.f) ? -t : t;
+	return Normalize3(n);
+}
+
+static uint32_t PackSnorm2(int q0, int q1)
+{
+	return (uint32_t)(uint16_t)(int16_t)q0 | ((uint32_t)(uint16_t)(int16_t)q1 << 16);
+}
+
+uint32_t VertexPacking::EncodeOctNormal(const XMFLOAT3& n)
+{
+	const XMFLOAT3 nn = Normalize3(n);
+	const float l1 = std::abs(nn.x) + std::abs(nn.y) + std::abs(nn.z);
+	if (l1 <= 0.f)
+		return 0;
+	float u = nn.x / l1;
+	float v = nn.y / l1;
+	if (nn.z < 0.f)
+	{
+		const float ou = u;
+		u = (1.f - std::abs(v)) * (ou >= 0.f ? 1.f : -1.f);
+		v = (1.f - std::abs(ou)) * (v >= 0.f ? 1.f : -1.f);
+	}
+
+	// Plain rounding is up to ~2x worse than the best of the four
+	// surrounding grid points, so pick the one that decodes closest.
+	const float fu = std::floor(u * 32767.f);
+	const float fv = std::floor(v * 32767.f);
+	uint32_t best = 0;
+	float bestDot = -2.f;
+	for (int i = 0; i < 4; ++i)
+	{
+		const int qu = (int)std::max(-32767.f, std::min(32767.f, fu + (float)(i & 1)));
+		const int qv = (int)std::max(-32767.f, std::min(32767.f, fv + (float)(i >> 1)));
+		const float d = Dot3(OctToVector(SnormToFloat((int16_t)qu), SnormToFloat((int16_t)qv)), nn);
+		if (d > bestDot)
+		{
+			bestDot = d;
+			best = PackSnorm2(qu, qv);
+		}
+	}
+	return best;
+}
+
+XMFLOAT3 VertexPacking::DecodeOctNormal(uint32_t packed)
+{
+	return OctToVector(SnormToFloat((int16_t)(packed & 0xFFFFu)), SnormToFloat((int16_t)(packed >> 16)));
+}
+
+// -------------------------------------------------------
+// Half float (R16G16_FLOAT), round to nearest even
+// -------------------------------------------------------
+uint16_t VertexPacking::FloatToHalf(float f)
+{
+	uint32_t u = FloatBits(f);
+	const uint32_t sign = u & 0x80000000u;
+	u ^= sign;
+
+	uint32_t h;
+	if (u >= (143u << 23)) // >= 65536: inf, or NaN
+	{
+		h = (u > (255u << 23)) ? 0x7E00u : 0x7C00u;
+	}
+	else if (u < (113u << 23)) // below 2^-14: subnormal or zero
+	{
+		// Adding 0.5 aligns the mantissa so the FPU does the rounding
+		const uint32_t magic = 126u << 23;
+		h = FloatBits(BitsFloat(u) + BitsFloat(magic)) - magic;
+	}
+	else
+	{
+		const uint32_t mantOdd = (u >> 13) & 1u;
+		u -= (uint32_t)(127 - 15) << 23;
+		u += 0xFFFu + mantOdd;
+		h = u >> 13; // overflow into the exponent rounds up to inf
+	}
+	return (uint16_t)(h | (sign >> 16));
+}
+
+float VertexPacking::HalfToFloat(uint16_t h)
+{
+	const uint32_t shiftedExp = 0x7C00u << 13;
+	uint32_t u = ((uint32_t)h & 0x7FFFu) << 13;
+	const uint32_t exp = u & shiftedExp;
+	u += (uint32_t)(127 - 15) << 23;
+	if (exp == shiftedExp)
+	{
+		u += (uint32_t)(128 - 16) << 23; // inf/NaN
+	}
+	else if (exp == 0)
+	{
+		u += 1u << 23; // subnormal: renormalize
+		u = FloatBits(BitsFloat(u) - BitsFloat(113u << 23));
+	}
+	return BitsFloat(u | (((uint32_t)h & 0x8000u) << 16));
+}
+
+uint32_t VertexPacking::EncodeTexCoord(const XMFLOAT2& uv)
+{
+	return (uint32_t)FloatToHalf(uv.x) | ((uint32_t)FloatToHalf(uv.y) << 16);
+}
+
+XMFLOAT2 VertexPacking::DecodeTexCoord(uint32_t packed)
+{
+	return XMFLOAT2(HalfToFloat((uint16_t)(packed & 0xFFFFu)), HalfToFloat((uint16_t)(packed >> 16)));
+}
+
+// -------------------------------------------------------
+// Tangent + sign (R10G10B10A2_UNORM)
+// -------------------------------------------------------
+static XMFLOAT3 Unorm10ToTangent(uint32_t x, uint32_t y, uint32_t z)
+{
+	return Normalize3(XMFLOAT3(
+		(float)x / 1023.f * 2.f - 1.f,
+		(float)y / 1023.f * 2.f - 1.f,
+		(float)z / 1023.f * 2.f - 1.f));
+}
+
+uint32_t VertexPacking::EncodeTangent(const XMFLOAT3& t, float sign)
+{
+	const XMFLOAT3 tn = Normalize3(t);
+	const float f[3] =
+	{
+		std::floor((tn.x * 0.5f + 0.5f) * 1023.f),
+		std::floor((tn.y * 0.5f + 0.5f) * 1023.f),
+		std::floor((tn.z * 0.5f + 0.5f) * 1023.f),
+	};
+	uint32_t best = 0;
+	float bestDot = -2.f;
+	for (int i = 0; i < 8; ++i)
+	{
+		uint32_t q[3];
+		for (int c = 0; c < 3; ++c)
+			q[c] = (uint32_t)std::max(0.f, std::min(1023.f, f[c] + (float)((i >> c) & 1)));
+		const float d = Dot3(Unorm10ToTangent(q[0], q[1], q[2]), tn);
+		if (d > bestDot)
+		{
+			bestDot = d;
+			best = q[0] | (q[1] << 10) | (q[2] << 20);
+		}
+	}
+	return best | ((sign < 0.f ? 0u : 3u) << 30);
+}
+
+XMFLOAT3 VertexPacking::DecodeTangent(uint32_t packed, float& sign)
+{
+	sign = ((packed >> 30) >= 2u) ? 1.f : -1.f;
+	return Unorm10ToTangent(packed & 0x3FFu, (packed >> 10) & 0x3FFu, (packed >> 20) & 0x3FFu);
+}
+
+static float BitangentSign(const ObjMesh::Vertex& v)
+{
+	return (Dot3(Cross3(v.Normal, v.Tangent), v.Bitangent) < 0.f) ? -1.f : 1.f;
+}
+
+// -------------------------------------------------------
+// Mesh packing
+// -------------------------------------------------------
+static bool SubsetsPartitionVertices(const std::vector<MeshSubset>& subsets, size_t vertexCount)
+{
+	size_t next = 0;
+	for (const MeshSubset& s : subsets)
+	{
+		if (s.vertexStart != next)
+			return false;
+		next += s.vertexCount;
+	}
+	return next == vertexCount;
+}
+
+static void SubsetBounds(const ObjMesh::Vertex* vertices, const MeshSubset& s, XMFLOAT3& mn, XMFLOAT3& mx)
+{
+	mn = XMFLOAT3(0.f, 0.f, 0.f);
+	mx = XMFLOAT3(0.f, 0.f, 0.f);
+	for (UINT i = 0; i < s.vertexCount; ++i)
+	{
+		const XMFLOAT3& p = vertices[s.vertexStart + i].Position;
+		if (i == 0)
+		{
+			mn = p;
+			mx = p;
+			continue;
+		}
+		mn.x = std::min(mn.x, p.x); mn.y = std::min(mn.y, p.y); mn.z = std::min(mn.z, p.z);
+		mx.x = std::max(mx.x, p.x); mx.y = std::max(mx.y, p.y); mx.z = std::max(mx.z, p.z);
+	}
+}
+
+static uint16_t QuantizeUnorm16(float value, float offset, float scale)
+{
+	if (scale <= 0.f)
+		return 0;
+	const float n = (value - offset) / scale;
+	return (uint16_t)std::lround(std::max(0.f, std::min(1.f, n)) * 65535.f);
+}
+
+bool VertexPacking::Pack(const ObjMesh::Vertex* vertices, size_t vertexCount,
+	const std::vector<MeshSubset>& subsets, VertexFormat format, PackedVertexData& out)
+{
+	out.format = format;
+	out.subsetDequant.assign(subsets.size(), PositionDequant());
+
+	if (format == VertexFormat::Packed)
+	{
+		out.stride = sizeof(PackedVertex);
+		out.bytes.resize(vertexCount * sizeof(PackedVertex));
+		PackedVertex* dst = reinterpret_cast<PackedVertex*>(out.bytes.data());
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			const ObjMesh::Vertex& v = vertices[i];
+			dst[i].Position = v.Position;
+			dst[i].Normal = EncodeOctNormal(v.Normal);
+			dst[i].TexCoord = EncodeTexCoord(v.TexCoord);
+			dst[i].Tangent = EncodeTangent(v.Tangent, BitangentSign(v));
+		}
+		return true;
+	}
+
+	if (!SubsetsPartitionVertices(subsets, vertexCount))
+		return false;
+
+	out.stride = sizeof(QuantizedVertex);
+	out.bytes.resize(vertexCount * sizeof(QuantizedVertex));
+	QuantizedVertex* dst = reinterpret_cast<QuantizedVertex*>(out.bytes.data());
+	for (size_t si = 0; si < subsets.size(); ++si)
+	{
+		const MeshSubset& s = subsets[si];
+		XMFLOAT3 mn, mx;
+		SubsetBounds(vertices, s, mn, mx);
+		PositionDequant& dq = out.subsetDequant[si];
+		dq.Scale = XMFLOAT4(mx.x - mn.x, mx.y - mn.y, mx.z - mn.z, 0.f);
+		dq.Offset = XMFLOAT4(mn.x, mn.y, mn.z, 0.f);
+		for (UINT i = s.vertexStart; i < s.vertexStart + s.vertexCount; ++i)
+		{
+			const ObjMesh::Vertex& v = vertices[i];
+			dst[i].Position[0] = QuantizeUnorm16(v.Position.x, dq.Offset.x, dq.Scale.x);
+			dst[i].Position[1] = QuantizeUnorm16(v.Position.y, dq.Offset.y, dq.Scale.y);
+			dst[i].Position[2] = QuantizeUnorm16(v.Position.z, dq.Offset.z, dq.Scale.z);
+			dst[i].Position[3] = 0;
+			dst[i].Normal = EncodeOctNormal(v.Normal);
+			dst[i].TexCoord = EncodeTexCoord(v.TexCoord);
+			dst[i].Tangent = EncodeTangent(v.Tangent, BitangentSign(v));
+		}
+	}
+	return true;
+}
+
+// -------------------------------------------------------
+// Index packing
+// -------------------------------------------------------
+void VertexPacking::PackIndices(const UINT* indices, size_t indexCount,
+	const std::vector<MeshSubset>& subsets, const std::vector<MeshLod>& lods, PackedIndexData& out)
+{
+	out = PackedIndexData();
+	out.draws.resize(subsets.size());
+	out.lodDraws.resize(lods.size());
+	std::vector<char> narrow(subsets.size(), 0);
+	auto place = [&](UINT rangeStart, UINT rangeCount, size_t si, SubsetDrawArgs& d)
+	{
+		if (rangeStart + (size_t)rangeCount > indexCount)
+			return;
+		d.indexCount = rangeCount;
+		d.wideIndices = !narrow[si];
+		if (narrow[si])
+		{
+			d.indexStart = out.narrowCount;
+			d.baseVertex = (int32_t)subsets[si].vertexStart;
+			out.narrowCount += rangeCount;
+		}
+		else
+		{
+			d.indexStart = out.wideCount;
+			out.wideCount += rangeCount;
+		}
+	};
+	for (size_t si = 0; si < subsets.size(); ++si)
+	{
+		const MeshSubset& s = subsets[si];
+		narrow[si] = s.vertexCount > 0 && s.vertexCount <= 65536u;
+		place(s.indexStart, s.indexCount, si, out.draws[si]);
+	}
+	for (size_t li = 0; li < lods.size(); ++li)
+	{
+		if (lods[li].subset < subsets.size())
+			place(lods[li].indexStart, lods[li].indexCount, lods[li].subset, out.lodDraws[li]);
+	}
+
+	out.wideOffset = (out.narrowCount * (UINT)sizeof(uint16_t) + 3u) & ~3u;
+	out.bytes.assign(out.wideOffset + out.wideCount * sizeof(UINT), 0);
+	uint16_t* dst16 = reinterpret_cast<uint16_t*>(out.bytes.data());
+	UINT* dst32 = reinterpret_cast<UINT*>(out.bytes.data() + out.wideOffset);
+	auto copy = [&](UINT rangeStart, size_t si, const SubsetDrawArgs& d)
+	{
+		if (d.indexCount == 0)
+			return;
+		const UINT* src = indices + rangeStart;
+		if (narrow[si])
+		{
+			const UINT vertexStart = subsets[si].vertexStart;
+			for (UINT i = 0; i < d.indexCount; ++i)
+				dst16[d.indexStart + i] = (uint16_t)(src[i] - vertexStart);
+		}
+		else
+		{
+			std::memcpy(dst32 + d.indexStart, src, d.indexCount * sizeof(UINT));
+		}
+	};
+	for (size_t si = 0; si < subsets.size(); ++si)
+		copy(subsets[si].indexStart, si, out.draws[si]);
+	for (size_t li = 0; li < lods.size(); ++li)
+	{
+		if (lods[li].subset < subsets.size())
+			copy(lods[li].indexStart, lods[li].subset, out.lodDraws[li]);
+	}
+}
+
+std::string VertexPacking::FormatIndices(const PackedIndexData& packed)
+{
+	size_t narrowSubsets = 0;
+	for (const SubsetDrawArgs& d : packed.draws)
+		narrowSubsets += (d.indexCount > 0 && !d.wideIndices) ? 1 : 0;
+	const size_t fullBytes = ((size_t)packed.narrowCount + packed.wideCount) * sizeof(UINT);
+	char buf[256];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[IndexPack] 16-bit subsets %zu/%zu, indices %u + %u wide, %zu B (%.0f%% of %zu B)\n",
+		narrowSubsets,
+		packed.draws.size(),
+		packed.narrowCount,
+		packed.wideCount,
+		packed.bytes.size(),
+		fullBytes ? 100.0 * (double)packed.bytes.size() / (double)fullBytes : 0.0,
+		fullBytes);
+	return buf;
+}
+
+// -------------------------------------------------------
+// Accuracy
+// -------------------------------------------------------
+bool VertexPacking::Accuracy::Passes() const
+{
+	// Bounds: 16-bit oct ~0.005 deg, 10-bit unorm tangent ~0.1 deg,
+	// half UV 2^-11 relative, unorm16 position half a step. The rebuilt
+	// bitangent inherits both direction errors. Its angle to the stored
+	// bitangent also holds the source's skew (TangentBuilder does not
+	// orthogonalize it), so only its side is checked.
+	return maxNormalErrorDeg <= 0.02f &&
+		maxTangentErrorDeg <= 0.2f &&
+		maxBitangentRebuildErrorDeg <= 0.25f &&
+		bitangentHandednessErrors == 0 &&
+		maxTexCoordRelError <= 1.0f / 2048.0f &&
+		maxPositionError <= positionTolerance &&
+		bitangentSignFlips == 0;
+}
+
+VertexPacking::Accuracy VertexPacking::Measure(const ObjMesh::Vertex* vertices, size_t vertexCount,
+	const std::vector<MeshSubset>& subsets, const PackedVertexData& packed)
+{
+	Accuracy a;
+	a.vertexCount = vertexCount;
+	if (packed.bytes.size() != vertexCount * packed.stride)
+	{
+		a.bitangentSignFlips = vertexCount;
+		return a;
+	}
+
+	// Position dequantization per vertex (identity for Packed)
+	std::vector<UINT> owner(vertexCount, 0);
+	if (packed.format == VertexFormat::PackedQuantized)
+	{
+		for (size_t si = 0; si < subsets.size(); ++si)
+		{
+			const MeshSubset& s = subsets[si];
+			for (UINT i = s.vertexStart; i < s.vertexStart + s.vertexCount && i < vertexCount; ++i)
+				owner[i] = (UINT)si;
+			const PositionDequant& dq = packed.subsetDequant[si];
+			const float step = std::sqrt(dq.Scale.x * dq.Scale.x + dq.Scale.y * dq.Scale.y + dq.Scale.z * dq.Scale.z) / 65535.f;
+			a.positionTolerance = std::max(a.positionTolerance, 0.5f * step * 1.01f + 1e-6f);
+		}
+	}
+
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const ObjMesh::Vertex& src = vertices[i];
+		XMFLOAT3 pos;
+		uint32_t normal, texCoord, tangent;
+		if (packed.format == VertexFormat::Packed)
+		{
+			const PackedVertex& v = reinterpret_cast<const PackedVertex*>(packed.bytes.data())[i];
+			pos = v.Position;
+			normal = v.Normal;
+			texCoord = v.TexCoord;
+			tangent = v.Tangent;
+		}
+		else
+		{
+			const QuantizedVertex& v = reinterpret_cast<const QuantizedVertex*>(packed.bytes.data())[i];
+			const PositionDequant& dq = packed.subsetDequant[owner[i]];
+			pos = XMFLOAT3(
+				(float)v.Position[0] / 65535.f * dq.Scale.x + dq.Offset.x,
+				(float)v.Position[1] / 65535.f * dq.Scale.y + dq.Offset.y,
+				(float)v.Position[2] / 65535.f * dq.Scale.z + dq.Offset.z);
+			normal = v.Normal;
+			texCoord = v.TexCoord;
+			tangent = v.Tangent;
+		}
+
+		const XMFLOAT3 dp(pos.x - src.Position.x, pos.y - src.Position.y, pos.z - src.Position.z);
+		a.maxPositionError = std::max(a.maxPositionError, std::sqrt(Dot3(dp, dp)));
+
+		const XMFLOAT3 n = DecodeOctNormal(normal);
+		if (Dot3(src.Normal, src.Normal) > 0.f)
+			a.maxNormalErrorDeg = std::max(a.maxNormalErrorDeg, AngleDeg(n, src.Normal));
+
+		float sign = 1.f;
+		const XMFLOAT3 t = DecodeTangent(tangent, sign);
+		a.maxTangentErrorDeg = std::max(a.maxTangentErrorDeg, AngleDeg(t, src.Tangent));
+		if (sign != BitangentSign(src))
+			++a.bitangentSignFlips;
+		const XMFLOAT3 nt = Cross3(n, t);
+		const XMFLOAT3 b(nt.x * sign, nt.y * sign, nt.z * sign);
+		if (Dot3(src.Bitangent, src.Bitangent) > 0.f)
+		{
+			a.maxBitangentErrorDeg = std::max(a.maxBitangentErrorDeg, AngleDeg(b, src.Bitangent));
+			// Past 90 deg by more than the rebuild error; exactly 90 deg is a
+			// mirror seam where the source frame has no handedness
+			if (Dot3(b, Normalize3(src.Bitangent)) < -0.01f)
+				++a.bitangentHandednessErrors;
+		}
+		// What the shader should rebuild: cross(N, T) * sign of the source frame
+		const XMFLOAT3 srcNt = Cross3(src.Normal, src.Tangent);
+		if (Dot3(srcNt, srcNt) > 1e-6f)
+		{
+			const float srcSign = BitangentSign(src);
+			const XMFLOAT3 srcB(srcNt.x * srcSign, srcNt.y * srcSign, srcNt.z * srcSign);
+			a.maxBitangentRebuildErrorDeg = std::max(a.maxBitangentRebuildErrorDeg, AngleDeg(b, srcB));
+		}
+
+		const XMFLOAT2 uv = DecodeTexCoord(texCoord);
+		const float eu = std::abs(uv.x - src.TexCoord.x);
+		const float ev = std::abs(uv.y - src.TexCoord.y);
+		a.maxTexCoordError = std::max(a.maxTexCoordError, std::max(eu, ev));
+		// Below 2^-14 halves are subnormal with a fixed 2^-24 step
+		const float ru = eu / std::max(std::abs(src.TexCoord.x), 1.f / 16384.f);
+		const float rv = ev / std::max(std::abs(src.TexCoord.y), 1.f / 16384.f);
+		a.maxTexCoordRelError = std::max(a.maxTexCoordRelError, std::max(ru, rv));
+	}
+	return a;
+}
+
+std::string VertexPacking::Format(const Accuracy& a, const PackedVertexData& packed)
+{
+	char buf[512];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[VertexPack] %s, %u B/vertex (%.0f%% of %u B), vertices=%zu\n"
+		"[VertexPack] max error: normal %.4f deg, tangent %.4f deg, bitangent %.4f deg rebuilt / %.3f deg stored, "
+		"uv %.2e (rel %.2e), position %.2e, sign flips %zu, flipped bitangents %zu -> %s\n",
+		packed.format == VertexFormat::Packed ? "Packed" : "PackedQuantized",
+		packed.stride,
+		100.0 * (double)packed.stride / (double)sizeof(ObjMesh::Vertex),
+		(unsigned)sizeof(ObjMesh::Vertex),
+		a.vertexCount,
+		a.maxNormalErrorDeg,
+		a.maxTangentErrorDeg,
+		a.maxBitangentRebuildErrorDeg,
+		a.maxBitangentErrorDeg,
+		a.maxTexCoordError,
+		a.maxTexCoordRelError,
+		a.maxPositionError,
+		a.bitangentSignFlips,
+		a.bitangentHandednessErrors,
+		a.Passes() ? "PASS" : "FAIL");
+	return buf;
+}
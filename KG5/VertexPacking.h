@@ -0,0 +1,115 @@
+#pragma once
+#include "ObjLoader.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+// Compressed GPU vertex formats. ObjMesh::Vertex (56 bytes, full floats)
+// stays the CPU/cache representation; Pack() converts it at upload time.
+//   normal   R16G16_SNORM       octahedral
+//   texcoord R16G16_FLOAT       half
+//   tangent  R10G10B10A2_UNORM  xyz in [-1,1] -> [0,1], a = bitangent sign
+// The bitangent is rebuilt in the vertex shader as cross(N, T) * sign.
+enum class VertexFormat
+{
+	Packed,          // float3 position, 24 bytes
+	PackedQuantized, // unorm16 position relative to the subset AABB, 20 bytes
+};
+
+struct PackedVertex
+{
+	XMFLOAT3 Position;
+	uint32_t Normal;
+	uint32_t TexCoord;
+	uint32_t Tangent;
+};
+struct QuantizedVertex
+{
+	uint16_t Position[4]; // w unused
+	uint32_t Normal;
+	uint32_t TexCoord;
+	uint32_t Tangent;
+};
+static_assert(sizeof(PackedVertex) == 24, "PackedVertex must match the geometry input layout");
+static_assert(sizeof(QuantizedVertex) == 20, "QuantizedVertex must match the geometry input layout");
+
+// position = unorm * scale + offset (identity for VertexFormat::Packed)
+struct PositionDequant
+{
+	XMFLOAT4 Scale = XMFLOAT4(1.f, 1.f, 1.f, 0.f);
+	XMFLOAT4 Offset = XMFLOAT4(0.f, 0.f, 0.f, 0.f);
+};
+
+struct PackedVertexData
+{
+	VertexFormat format = VertexFormat::Packed;
+	UINT stride = 0;
+	std::vector<uint8_t> bytes;
+	std::vector<PositionDequant> subsetDequant; // one per subset
+};
+
+// Draw arguments for one subset after index packing. indexStart is relative
+// to the 16-bit or 32-bit view; baseVertex rebases subset-local indices.
+struct SubsetDrawArgs
+{
+	UINT indexStart = 0;
+	UINT indexCount = 0;
+	int32_t baseVertex = 0;
+	bool wideIndices = false;
+};
+
+// One buffer: all 16-bit indices first, then the 32-bit ones at wideOffset.
+struct PackedIndexData
+{
+	std::vector<uint8_t> bytes;
+	UINT narrowCount = 0;
+	UINT wideCount = 0;
+	UINT wideOffset = 0; // bytes, 4-byte aligned
+	std::vector<SubsetDrawArgs> draws; // one per subset
+	std::vector<SubsetDrawArgs> lodDraws; // one per ObjMesh::lods entry, same width as its subset
+};
+
+class VertexPacking
+{
+public:
+	// PackedQuantized needs MeshSubset::vertexStart/vertexCount (see
+	// MeshOptimizer::OptimizeVertexFetch); returns false without them.
+	static bool Pack(const ObjMesh::Vertex* vertices, size_t vertexCount,
+		const std::vector<MeshSubset>& subsets, VertexFormat format, PackedVertexData& out);
+
+	// Subsets with a known vertex range of at most 65536 vertices get 16-bit
+	// indices relative to vertexStart; the rest keep 32-bit global indices.
+	// LODs follow the subsets in each region and reuse their subset's base vertex.
+	static void PackIndices(const UINT* indices, size_t indexCount,
+		const std::vector<MeshSubset>& subsets, const std::vector<MeshLod>& lods, PackedIndexData& out);
+	static std::string FormatIndices(const PackedIndexData& packed);
+
+	static uint32_t EncodeOctNormal(const XMFLOAT3& n);
+	static XMFLOAT3 DecodeOctNormal(uint32_t packed);
+	static uint16_t FloatToHalf(float f);
+	static float HalfToFloat(uint16_t h);
+	static uint32_t EncodeTexCoord(const XMFLOAT2& uv);
+	static XMFLOAT2 DecodeTexCoord(uint32_t packed);
+	// sign = +1 when (N x T) points along the bitangent
+	static uint32_t EncodeTangent(const XMFLOAT3& t, float sign);
+	static XMFLOAT3 DecodeTangent(uint32_t packed, float& sign);
+
+	struct Accuracy
+	{
+		float maxPositionError = 0.f;   // object-space units
+		float positionTolerance = 0.f;  // half a unorm16 step of the largest subset AABB
+		float maxNormalErrorDeg = 0.f;
+		float maxTangentErrorDeg = 0.f;
+		float maxBitangentErrorDeg = 0.f; // vs. the stored (non-orthogonal) bitangent
+		float maxBitangentRebuildErrorDeg = 0.f; // vs. cross(N, T) * sign of the source
+		float maxTexCoordError = 0.f;   // absolute, in UV units
+		float maxTexCoordRelError = 0.f; // relative to |uv| (half precision bound: 2^-11)
+		size_t bitangentSignFlips = 0;
+		size_t bitangentHandednessErrors = 0; // rebuilt bitangent facing away from the stored one
+		size_t vertexCount = 0;
+		bool Passes() const;
+	};
+	// Decodes 'packed' on the CPU and compares it with the source vertices.
+	static Accuracy Measure(const ObjMesh::Vertex* vertices, size_t vertexCount,
+		const std::vector<MeshSubset>& subsets, const PackedVertexData& packed);
+	static std::string Format(const Accuracy& a, const PackedVertexData& packed);
+};
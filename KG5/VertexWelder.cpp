@@ -0,0 +1,329 @@
+#include "VertexWelder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static const UINT InvalidIndex = 0xFFFFFFFFu;
+
+// -------------------------------------------------------
+// Position grid
+// -------------------------------------------------------
+// Cells are twice the position tolerance wide, so anything within the
+// tolerance of a point lies in its own cell or in the neighbour on the side
+// of the cell it is closer to: 2 candidates per axis, 8 cells per lookup.
+// Each cell is a linked list (head in the open-addressing table, links in
+// 'next') of the vertices kept so far.
+class WeldGrid
+{
+public:
+	WeldGrid(size_t vertexCount, float cellSize)
+		: m_next(vertexCount, InvalidIndex), m_invCell(cellSize > 0.f ? 1.f / cellSize : 0.f)
+	{
+		size_t capacity = 16;
+		while (capacity < vertexCount * 2) capacity <<= 1;
+		m_slots.assign(capacity, Slot{});
+	}
+	// Cell coordinates of p and the neighbour to visit on each axis (-1/+1)
+	void Locate(const XMFLOAT3& p, int32_t cell[3], int32_t side[3]) const
+	{
+		const float c[3] = { p.x * m_invCell, p.y * m_invCell, p.z * m_invCell };
+		for (int a = 0; a < 3; ++a)
+		{
+			const float f = std::floor(c[a]);
+			cell[a] = (int32_t)f;
+			side[a] = (c[a] - f < 0.5f) ? -1 : 1;
+		}
+	}
+	UINT Head(int32_t x, int32_t y, int32_t z) const
+	{
+		const uint64_t key = Key(x, y, z);
+		const size_t mask = m_slots.size() - 1;
+		for (size_t i = Hash(key) & mask;; i = (i + 1) & mask)
+		{
+			const Slot& slot = m_slots[i];
+			if (slot.head == InvalidIndex) return InvalidIndex;
+			if (slot.key == key) return slot.head;
+		}
+	}
+	UINT Next(UINT v) const { return m_next[v]; }
+	void Insert(const int32_t cell[3], UINT v)
+	{
+		const uint64_t key = Key(cell[0], cell[1], cell[2]);
+		const size_t mask = m_slots.size() - 1;
+		for (size_t i = Hash(key) & mask;; i = (i + 1) & mask)
+		{
+			Slot& slot = m_slots[i];
+			if (slot.head == InvalidIndex)
+			{
+				slot.key = key;
+				slot.head = v;
+				return;
+			}
+			if (slot.key == key)
+			{
+				m_next[v] = slot.head;
+				slot.head = v;
+				return;
+			}
+		}
+	}
+private:
+	struct Slot
+	{
+		uint64_t key = 0;
+		UINT head = InvalidIndex;
+	};
+	// 21 bits per axis; cells that alias are told apart by the value compare
+	static uint64_t Key(int32_t x, int32_t y, int32_t z)
+	{
+		return ((uint64_t)(uint32_t)x & 0x1FFFFF) |
+			(((uint64_t)(uint32_t)y & 0x1FFFFF) << 21) |
+			(((uint64_t)(uint32_t)z & 0x1FFFFF) << 42);
+	}
+	static size_t Hash(uint64_t k)
+	{
+		// splitmix64 finalizer
+		k ^= k >> 30;
+		k *= 0xBF58476D1CE4E5B9ull;
+		k ^= k >> 27;
+		k *= 0x94D049BB133111EBull;
+		k ^= k >> 31;
+		return (size_t)k;
+	}
+	std::vector<Slot> m_slots;
+	std::vector<UINT> m_next;
+	float m_invCell;
+};
+
+struct WeldTolerance
+{
+	float position;
+	float normalCos; // 1 - normalEpsilon
+	float uv;
+};
+
+static bool SameVertex(const ObjMesh::Vertex& a, const ObjMesh::Vertex& b, const WeldTolerance& tol)
+{
+	if (std::fabs(a.Position.x - b.Position.x) > tol.position ||
+		std::fabs(a.Position.y - b.Position.y) > tol.position ||
+		std::fabs(a.Position.z - b.Position.z) > tol.position)
+		return false;
+	if (std::fabs(a.TexCoord.x - b.TexCoord.x) > tol.uv ||
+		std::fabs(a.TexCoord.y - b.TexCoord.y) > tol.uv)
+		return false;
+	const XMFLOAT3& n = a.Normal;
+	const XMFLOAT3& m = b.Normal;
+	const float dot = n.x * m.x + n.y * m.y + n.z * m.z;
+	const float lengths = std::sqrt((n.x * n.x + n.y * n.y + n.z * n.z) * (m.x * m.x + m.y * m.y + m.z * m.z));
+	if (lengths == 0.f)
+		return n.x == m.x && n.y == m.y && n.z == m.z;
+	return dot >= tol.normalCos * lengths;
+}
+
+static bool SameBits(const ObjMesh::Vertex& a, const ObjMesh::Vertex& b)
+{
+	return std::memcmp(&a.Position, &b.Position, sizeof(XMFLOAT3)) == 0 &&
+		std::memcmp(&a.Normal, &b.Normal, sizeof(XMFLOAT3)) == 0 &&
+		std::memcmp(&a.TexCoord, &b.TexCoord, sizeof(XMFLOAT2)) == 0;
+}
+
+// Triangle height over its longest edge (0 for collinear corners)
+static float TriangleHeight(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+{
+	const float e1x = b.x - a.x, e1y = b.y - a.y, e1z = b.z - a.z;
+	const float e2x = c.x - a.x, e2y = c.y - a.y, e2z = c.z - a.z;
+	const float e3x = c.x - b.x, e3y = c.y - b.y, e3z = c.z - b.z;
+	const float cx = e1y * e2z - e1z * e2y;
+	const float cy = e1z * e2x - e1x * e2z;
+	const float cz = e1x * e2y - e1y * e2x;
+	const float longest = (std::max)((std::max)(
+		e1x * e1x + e1y * e1y + e1z * e1z,
+		e2x * e2x + e2y * e2y + e2z * e2z),
+		e3x * e3x + e3y * e3y + e3z * e3z);
+	if (longest == 0.f)
+		return 0.f;
+	return std::sqrt((cx * cx + cy * cy + cz * cz) / longest);
+}
+
+// -------------------------------------------------------
+// Weld
+// -------------------------------------------------------
+VertexWelder::Stats VertexWelder::Weld(ObjMesh& mesh, const WeldOptions& options)
+{
+	const auto start = std::chrono::steady_clock::now();
+	Stats stats;
+	stats.verticesBefore = mesh.vertices.size();
+	stats.indicesBefore = mesh.indices.size();
+	stats.verticesAfter = stats.verticesBefore;
+	stats.indicesAfter = stats.indicesBefore;
+	const size_t vertexCount = mesh.vertices.size();
+	if (vertexCount == 0)
+		return stats;
+
+	XMFLOAT3 mn = mesh.vertices[0].Position;
+	XMFLOAT3 mx = mn;
+	for (const ObjMesh::Vertex& v : mesh.vertices)
+	{
+		mn.x = (std::min)(mn.x, v.Position.x);
+		mn.y = (std::min)(mn.y, v.Position.y);
+		mn.z = (std::min)(mn.z, v.Position.z);
+		mx.x = (std::max)(mx.x, v.Position.x);
+		mx.y = (std::max)(mx.y, v.Position.y);
+		mx.z = (std::max)(mx.z, v.Position.z);
+	}
+	const float extent = (std::max)((std::max)(mx.x - mn.x, mx.y - mn.y), mx.z - mn.z);
+	WeldTolerance tol;
+	tol.position = (std::isfinite(extent) ? extent : 0.f) * (std::max)(options.positionEpsilon, 0.f);
+	tol.normalCos = 1.f - (std::max)(options.normalEpsilon, 0.f);
+	tol.uv = (std::max)(options.uvEpsilon, 0.f);
+	const bool exact = tol.position == 0.f;
+
+	// 1. Merge every vertex into the lowest kept vertex that matches it
+	std::vector<UINT> remap(vertexCount);
+	WeldGrid grid(vertexCount, exact ? 1.f : 2.f * tol.position);
+	for (UINT v = 0; v < (UINT)vertexCount; ++v)
+	{
+		const ObjMesh::Vertex& vertex = mesh.vertices[v];
+		const XMFLOAT3& p = vertex.Position;
+		if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+		{
+			remap[v] = v;
+			continue;
+		}
+		int32_t cell[3], side[3];
+		grid.Locate(p, cell, side);
+		UINT match = InvalidIndex;
+		const int cellsToVisit = exact ? 1 : 8;
+		for (int c = 0; c < cellsToVisit; ++c)
+		{
+			const int32_t x = cell[0] + ((c & 1) ? side[0] : 0);
+			const int32_t y = cell[1] + ((c & 2) ? side[1] : 0);
+			const int32_t z = cell[2] + ((c & 4) ? side[2] : 0);
+			for (UINT k = grid.Head(x, y, z); k != InvalidIndex; k = grid.Next(k))
+			{
+				if (k >= match) continue;
+				if (exact ? SameBits(mesh.vertices[k], vertex) : SameVertex(mesh.vertices[k], vertex, tol))
+					match = k;
+			}
+		}
+		if (match != InvalidIndex)
+		{
+			remap[v] = match;
+			continue;
+		}
+		remap[v] = v;
+		grid.Insert(cell, v);
+	}
+
+	// 2. Rewrite every subset's triangles, dropping the degenerate ones
+	std::vector<UINT> indices;
+	indices.reserve(mesh.indices.size());
+	std::vector<MeshSubset> subsets;
+	subsets.reserve(mesh.subsets.size());
+	for (const MeshSubset& s : mesh.subsets)
+	{
+		MeshSubset out = s;
+		out.indexStart = (UINT)indices.size();
+		const size_t last = (std::min)((size_t)s.indexStart + s.indexCount, mesh.indices.size());
+		for (size_t i = s.indexStart; i + 2 < last; i += 3)
+		{
+			const UINT a = remap[mesh.indices[i]];
+			const UINT b = remap[mesh.indices[i + 1]];
+			const UINT c = remap[mesh.indices[i + 2]];
+			if (options.removeDegenerates)
+			{
+				if (a == b || b == c || a == c)
+				{
+					++stats.collapsedTriangles;
+					continue;
+				}
+				if (TriangleHeight(mesh.vertices[a].Position, mesh.vertices[b].Position,
+					mesh.vertices[c].Position) <= tol.position)
+				{
+					++stats.zeroAreaTriangles;
+					continue;
+				}
+			}
+			indices.push_back(a);
+			indices.push_back(b);
+			indices.push_back(c);
+		}
+		out.indexCount = (UINT)indices.size() - out.indexStart;
+		if (out.indexCount == 0)
+		{
+			++stats.subsetsRemoved;
+			continue;
+		}
+		subsets.push_back(out);
+	}
+
+	bool merged = false;
+	for (UINT v = 0; v < (UINT)vertexCount && !merged; ++v)
+		merged = remap[v] != v;
+	if (!merged && indices.size() == mesh.indices.size())
+	{
+		stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+
+	// 3. Keep referenced vertices in their original order
+	std::vector<UINT> compact(vertexCount, InvalidIndex);
+	for (UINT i : indices)
+		compact[i] = 0;
+	std::vector<ObjMesh::Vertex> vertices;
+	for (UINT v = 0; v < (UINT)vertexCount; ++v)
+	{
+		if (compact[v] == InvalidIndex) continue;
+		compact[v] = (UINT)vertices.size();
+		vertices.push_back(mesh.vertices[v]);
+	}
+	for (UINT& i : indices)
+		i = compact[i];
+
+	mesh.vertices.swap(vertices);
+	mesh.indices.swap(indices);
+	mesh.subsets.swap(subsets);
+	for (MeshSubset& s : mesh.subsets)
+	{
+		s.vertexStart = s.vertexCount = 0;
+		s.meshletStart = s.meshletCount = 0;
+		s.lodStart = s.lodCount = 0;
+	}
+	mesh.meshlets.clear();
+	mesh.lods.clear();
+
+	// Merged vertices now collect the faces of every copy
+	TangentBuilder::Build(mesh, options.tangents);
+	ObjLoader::ComputeBounds(mesh);
+
+	stats.verticesAfter = mesh.vertices.size();
+	stats.indicesAfter = mesh.indices.size();
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+std::string VertexWelder::Format(const Stats& s)
+{
+	const double vertexCut = s.verticesBefore ? 100.0 * (1.0 - (double)s.verticesAfter / (double)s.verticesBefore) : 0.0;
+	const double indexCut = s.indicesBefore ? 100.0 * (1.0 - (double)s.indicesAfter / (double)s.indicesBefore) : 0.0;
+	char buf[320];
+	std::snprintf(
+		buf,
+		sizeof(buf),
+		"[Weld] vertices %zu -> %zu (-%.1f%%), indices %zu -> %zu (-%.1f%%), "
+		"degenerate triangles %zu collapsed + %zu zero-area, %zu empty subsets, %.1f ms\n",
+		s.verticesBefore,
+		s.verticesAfter,
+		vertexCut,
+		s.indicesBefore,
+		s.indicesAfter,
+		indexCut,
+		s.collapsedTriangles,
+		s.zeroAreaTriangles,
+		s.subsetsRemoved,
+		s.milliseconds);
+	return buf;
+}
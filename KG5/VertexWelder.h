@@ -0,0 +1,47 @@
+#pragma once
+#include "ObjLoader.h"
+#include "TangentBuilder.h"
+#include <string>
+// Value-based vertex welding. ObjLoader only merges corners with identical
+// (v, vt, vn) index triples, but exporters often write the same value under
+// several indices, and fan triangulation leaves zero-area triangles behind
+// collinear or repeated corners.
+struct WeldOptions
+{
+	// Positions merge when every coordinate is within this fraction of the
+	// mesh's largest bounding-box extent (0 = bit-identical only).
+	float positionEpsilon = 1e-6f;
+	// Normals merge when the angle between them is below acos(1 - normalEpsilon).
+	float normalEpsilon = 1e-4f;
+	float uvEpsilon = 1e-5f;
+	// Drop triangles with repeated indices, or thinner than the position
+	// tolerance (height over the longest edge).
+	bool removeDegenerates = true;
+	// Frames are rebuilt for the welded mesh when anything changed.
+	TangentOptions tangents;
+};
+
+class VertexWelder
+{
+public:
+	struct Stats
+	{
+		size_t verticesBefore = 0;
+		size_t verticesAfter = 0;
+		size_t indicesBefore = 0;
+		size_t indicesAfter = 0;
+		size_t collapsedTriangles = 0; // repeated index after merging
+		size_t zeroAreaTriangles = 0;
+		size_t subsetsRemoved = 0;    // left without triangles
+		double milliseconds = 0.0;
+	};
+
+	// Every vertex is merged into the first earlier vertex that matches it,
+	// so the result does not depend on hash order. Unreferenced vertices
+	// are dropped and empty subsets removed. Run right after loading,
+	// before InstanceDetector: meshlets and LODs are cleared and subset
+	// bounds are recomputed.
+	static Stats Weld(ObjMesh& mesh, const WeldOptions& options = WeldOptions());
+
+	static std::string Format(const Stats& s);
+};
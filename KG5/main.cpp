@@ -2,6 +2,7 @@
 #include "RenderingSystem.h"
 #include "Timer.h"
 #include "InputDevice.h"
+#include "AssetBenchmark.h"
 #include <windowsx.h>
 #include <cstring>
 #include <stdexcept>
@@ -90,10 +91,30 @@ private:
     InputDevice m_input;
 };
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
+// "--bench-assets [path/to/model.obj]" runs the CPU asset benchmarks instead of the renderer.
+static int RunAssetBenchmark(const char* args)
+{
+    std::string objPath = "assets/sponza/sponza.obj";
+    while (*args == ' ')
+        ++args;
+    if (*args != '\0')
+        objPath = args;
+
+    std::string report;
+    const bool passed = AssetBenchmark::RunAll(objPath, 3, report);
+    OutputDebugStringA(report.c_str());
+    MessageBoxA(nullptr, report.c_str(), "Asset Benchmark", MB_OK | (passed ? MB_ICONINFORMATION : MB_ICONERROR));
+    return passed ? 0 : 1;
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int nCmdShow)
 {
     try
     {
+        const char* benchArg = lpCmdLine ? std::strstr(lpCmdLine, "--bench-assets") : nullptr;
+        if (benchArg)
+            return RunAssetBenchmark(benchArg + std::strlen("--bench-assets"));
+
         App app;
         if (!app.Init(hInstance))
         {